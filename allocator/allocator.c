@@ -0,0 +1,50 @@
+#include "allocator.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../hugealloc/hugealloc.h"
+
+/* `aligned_alloc()` requires the size to be a multiple of the alignment. */
+static size_t round_to_alignment(const size_t size, const size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+static void *default_alloc(void *const ctx, const size_t size,
+                           const size_t alignment) {
+  (void)ctx;
+  if (alignment <= DEFAULT_ALIGNMENT) return huge_alloc(size);
+  return aligned_alloc(alignment, round_to_alignment(size, alignment));
+}
+
+static void *default_realloc(void *const ctx, void *const ptr,
+                             const size_t old_size, const size_t new_size,
+                             const size_t alignment) {
+  (void)ctx;
+  if (alignment <= DEFAULT_ALIGNMENT) return huge_realloc(ptr, new_size);
+  /* There is no aligned counterpart to `realloc()`, so move the block. */
+  void *const new_ptr =
+      aligned_alloc(alignment, round_to_alignment(new_size, alignment));
+  if (new_ptr == NULL) return NULL;
+  memcpy(new_ptr, ptr, (old_size < new_size) ? old_size : new_size);
+  free(ptr);
+  return new_ptr;
+}
+
+static void default_free(void *const ctx, void *const ptr, const size_t size,
+                         const size_t alignment) {
+  (void)ctx;
+  (void)size;
+  if (alignment <= DEFAULT_ALIGNMENT)
+    huge_free(ptr);
+  else
+    free(ptr);
+}
+
+const allocator_t default_allocator = {default_alloc, default_realloc,
+                                       default_free, NULL};
+
+const allocator_t *allocator_or_default(const allocator_t *const allocator) {
+  return (allocator != NULL) ? allocator : &default_allocator;
+}
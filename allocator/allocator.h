@@ -0,0 +1,47 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stddef.h>
+
+/* The alignment containers request for their blocks unless told otherwise. */
+#define DEFAULT_ALIGNMENT (_Alignof(max_align_t))
+
+/*
+ * A set of functions through which a container obtains, resizes and releases
+ * its memory, along with a context pointer passed back to each of them.
+ *
+ * Every call is given the size and alignment the block was (or is to be)
+ * allocated with, so allocators such as arenas and size-class pools need not
+ * store any bookkeeping of their own.
+ *
+ * \note An allocator must outlive every container created with it.
+ */
+typedef struct allocator_t {
+  /*
+   * Allocates `size` bytes aligned to `alignment`, a power of two.
+   * Returns `NULL` upon failure.
+   */
+  void *(*alloc)(void *ctx, size_t size, size_t alignment);
+  /*
+   * Resizes the `old_size`-byte block at `ptr` to `new_size` bytes, keeping
+   * its contents up to the smaller of the two sizes. Returns `NULL` upon
+   * failure, in which case `ptr` must remain valid.
+   */
+  void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size,
+                   size_t alignment);
+  /* Releases the `size`-byte block at `ptr`, which may be `NULL`. */
+  void (*free)(void *ctx, void *ptr, size_t size, size_t alignment);
+  void *ctx;
+} allocator_t;
+
+/*
+ * The allocator used by containers created without one, which is backed by
+ * `huge_alloc()` and friends. Alignments above `DEFAULT_ALIGNMENT` are served
+ * by `aligned_alloc()` instead.
+ */
+extern const allocator_t default_allocator;
+
+/* Returns `allocator`, or `&default_allocator` if `allocator` is `NULL`. */
+const allocator_t *allocator_or_default(const allocator_t *allocator);
+
+#endif
@@ -4,13 +4,40 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../allocator/allocator.h"
+
 array_t *_new_array(const void *const data, const size_t elem_size,
                    const size_t length) {
-  array_t *const new_arr = malloc(elem_size * length + sizeof(array_t));
+  return _new_array_with(data, elem_size, length, NULL);
+}
+
+/* The data follows the header, padded to the array's alignment. */
+static size_t data_offset(const size_t alignment) {
+  return (sizeof(array_t) + alignment - 1) / alignment * alignment;
+}
+
+array_t *_new_array_with(const void *const data, const size_t elem_size,
+                         const size_t length,
+                         const allocator_t *const allocator) {
+  return _new_array_aligned(data, elem_size, length, DEFAULT_ALIGNMENT,
+                            allocator);
+}
+
+array_t *_new_array_aligned(const void *const data, const size_t elem_size,
+                            const size_t length, size_t alignment,
+                            const allocator_t *const allocator) {
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) return NULL;
+  if (alignment < DEFAULT_ALIGNMENT) alignment = DEFAULT_ALIGNMENT;
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  array_t *const new_arr = ALLOCATOR->alloc(
+      ALLOCATOR->ctx, data_offset(alignment) + elem_size * length, alignment);
+  if (new_arr == NULL) return NULL;
   new_arr->capacity = elem_size * length;
   new_arr->elem_size = elem_size;
   new_arr->length = length;
-  new_arr->data = (char *)new_arr + sizeof(array_t);
+  new_arr->data = (char *)new_arr + data_offset(alignment);
+  new_arr->allocator = ALLOCATOR;
+  new_arr->alignment = alignment;
 
   if (data != NULL) memcpy(new_arr->data, data, elem_size * length);
   return new_arr;
@@ -22,13 +49,20 @@ void *get_elem(const array_t *const arr, const size_t index) {
 }
 
 void _delete_array(array_t **const arr) {
-  free(*arr);
+  const allocator_t *const ALLOCATOR = (*arr)->allocator;
+  const size_t ALIGNMENT = (*arr)->alignment;
+  ALLOCATOR->free(ALLOCATOR->ctx, *arr,
+                  data_offset(ALIGNMENT) + (*arr)->capacity, ALIGNMENT);
   *arr = NULL;
 }
 
 void delete_array_s(array_t *arr) {
-  memset(arr, 0, arr->capacity + sizeof(*arr));
-  delete_array(arr);
+  /* The header is about to be zeroed, so keep what freeing it requires. */
+  const allocator_t *const ALLOCATOR = arr->allocator;
+  const size_t ALIGNMENT = arr->alignment;
+  const size_t SIZE = data_offset(ALIGNMENT) + arr->capacity;
+  memset(arr, 0, SIZE);
+  ALLOCATOR->free(ALLOCATOR->ctx, arr, SIZE, ALIGNMENT);
 }
 
 void clear_array_contents(array_t *const arr) {
@@ -3,7 +3,13 @@
 
 #include <stddef.h>
 
+#include "../allocator/allocator.h"
+
 #define new_array(data, length) _new_array(data, sizeof*(data), length)
+#define new_array_with(data, length, allocator) \
+  _new_array_with(data, sizeof *(data), length, allocator)
+#define new_array_aligned(data, length, alignment) \
+  _new_array_aligned(data, sizeof *(data), length, alignment, NULL)
 #define delete_array(arr) _delete_array(&(arr))
 
 typedef struct array_t {
@@ -11,10 +17,30 @@ typedef struct array_t {
   size_t capacity;
   size_t length;
   size_t elem_size;
+  const allocator_t *allocator;
+  size_t alignment; /* The alignment of `data`. */
 } array_t;
 
 array_t *_new_array(const void *data, size_t elem_size, size_t length);
 
+/*
+ * Same as `_new_array()`, except the array's memory is obtained from and
+ * returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+array_t *_new_array_with(const void *data, size_t elem_size, size_t length,
+                         const allocator_t *allocator);
+
+/*
+ * Same as `_new_array_with()`, except `data` is aligned to `alignment`, a
+ * power of two, such as a cache line so vector loads never straddle one.
+ * Alignments below `DEFAULT_ALIGNMENT` are raised to it.
+ *
+ * \return A pointer to the new array or `NULL` upon failure or if `alignment`
+ * is not a power of two.
+ */
+array_t *_new_array_aligned(const void *data, size_t elem_size, size_t length,
+                            size_t alignment, const allocator_t *allocator);
+
 void *get_elem(const array_t *arr, size_t index);
 
 void _delete_array(array_t **arr);
@@ -0,0 +1,470 @@
+#include "arraykernels.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../dispatch/dispatch.h"
+#include "array.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS (1)
+#else
+#define HAVE_X86_KERNELS (0)
+#endif
+
+/* Integer products wrap around, so they are computed on unsigned types. */
+#define WRAPPING_MUL(T, U, x, y) ((T)((U)(x) * (U)(y)))
+
+/* - KERNELS - */
+
+/* clang-format off */
+#define DEFINE_SCALAR_SUM(name, T, ACC_T)                                  \
+  static ACC_T name##_scalar(const T *const p, const size_t n) {           \
+    ACC_T sum = 0;                                                         \
+    for (size_t i = 0; i < n; i++) sum += (ACC_T)p[i];                     \
+    return sum;                                                            \
+  }
+
+#define DEFINE_SCALAR_DOT(name, T, ACC_T)                                  \
+  static ACC_T name##_scalar(const T *const a, const T *const b,           \
+                             const size_t n) {                             \
+    ACC_T sum = 0;                                                         \
+    for (size_t i = 0; i < n; i++) sum += (ACC_T)a[i] * (ACC_T)b[i];       \
+    return sum;                                                            \
+  }
+
+#define DEFINE_SCALAR_MIN_MAX(name, T)                                     \
+  static void name##_scalar(const T *const p, const size_t n,              \
+                            T *const min, T *const max) {                  \
+    T lo = p[0], hi = p[0];                                                \
+    for (size_t i = 1; i < n; i++) {                                       \
+      if (p[i] < lo) lo = p[i];                                            \
+      if (p[i] > hi) hi = p[i];                                            \
+    }                                                                      \
+    *min = lo;                                                             \
+    *max = hi;                                                             \
+  }
+
+#define DEFINE_SCALAR_FILL(name, T)                                        \
+  static void name##_scalar(T *const p, const size_t n, const T value) {   \
+    for (size_t i = 0; i < n; i++) p[i] = value;                           \
+  }
+
+#define DEFINE_SCALAR_SCALE(name, T, U)                                    \
+  static void name##_scalar(T *const p, const size_t n, const T factor) {  \
+    for (size_t i = 0; i < n; i++) p[i] = WRAPPING_MUL(T, U, p[i], factor); \
+  }
+
+#define DEFINE_SCALAR_EQUAL(name, T)                                       \
+  static bool name##_scalar(const T *const a, const T *const b,            \
+                            const size_t n) {                              \
+    for (size_t i = 0; i < n; i++)                                         \
+      if (a[i] != b[i]) return false;                                      \
+    return true;                                                           \
+  }
+/* clang-format on */
+
+DEFINE_SCALAR_SUM(sum_i32, int32_t, int64_t)
+DEFINE_SCALAR_SUM(sum_i64, int64_t, uint64_t)
+DEFINE_SCALAR_SUM(sum_f32, float, float)
+DEFINE_SCALAR_SUM(sum_f64, double, double)
+DEFINE_SCALAR_MIN_MAX(min_max_i32, int32_t)
+DEFINE_SCALAR_MIN_MAX(min_max_i64, int64_t)
+DEFINE_SCALAR_MIN_MAX(min_max_f32, float)
+DEFINE_SCALAR_MIN_MAX(min_max_f64, double)
+DEFINE_SCALAR_FILL(fill_i32, int32_t)
+DEFINE_SCALAR_FILL(fill_i64, int64_t)
+DEFINE_SCALAR_FILL(fill_f32, float)
+DEFINE_SCALAR_FILL(fill_f64, double)
+DEFINE_SCALAR_SCALE(scale_i32, int32_t, uint32_t)
+DEFINE_SCALAR_SCALE(scale_i64, int64_t, uint64_t)
+DEFINE_SCALAR_SCALE(scale_f32, float, float)
+DEFINE_SCALAR_SCALE(scale_f64, double, double)
+DEFINE_SCALAR_DOT(dot_i32, int32_t, uint64_t)
+DEFINE_SCALAR_DOT(dot_i64, int64_t, uint64_t)
+DEFINE_SCALAR_DOT(dot_f32, float, float)
+DEFINE_SCALAR_DOT(dot_f64, double, double)
+DEFINE_SCALAR_EQUAL(equal_f32, float)
+DEFINE_SCALAR_EQUAL(equal_f64, double)
+
+#if HAVE_X86_KERNELS
+/*
+ * The kernels are written once with GCC's vector extensions and instantiated
+ * for each instruction set with vectors of that set's register width. Loads
+ * and stores go through `memcpy()`, which compiles to single unaligned vector
+ * moves and runs at full speed on aligned data.
+ */
+
+/* clang-format off */
+#define DEFINE_VECTOR_TYPES(bytes)                                      \
+  typedef int32_t i32_v##bytes __attribute__((vector_size(bytes)));     \
+  typedef int64_t i64_v##bytes __attribute__((vector_size(bytes)));     \
+  typedef uint32_t u32_v##bytes __attribute__((vector_size(bytes)));    \
+  typedef uint64_t u64_v##bytes __attribute__((vector_size(bytes)));    \
+  typedef float f32_v##bytes __attribute__((vector_size(bytes)));       \
+  typedef double f64_v##bytes __attribute__((vector_size(bytes)));
+/* clang-format on */
+
+DEFINE_VECTOR_TYPES(8)
+DEFINE_VECTOR_TYPES(16)
+DEFINE_VECTOR_TYPES(32)
+DEFINE_VECTOR_TYPES(64)
+
+#define LOAD(v, src) memcpy(&(v), (src), sizeof(v))
+#define STORE(dst, v) memcpy((dst), &(v), sizeof(v))
+
+/*
+ * Blends `a` where `mask` is set with `b` elsewhere. The mask is a vector of
+ * signed integers as wide as the lanes, as produced by vector comparisons.
+ */
+#define BLEND(VT, MT, mask, a, b) \
+  ((VT)(((MT)(a) & (mask)) | ((MT)(b) & ~(mask))))
+
+/*
+ * Sums run four independent accumulators so consecutive additions need not
+ * wait on each other.
+ */
+/* clang-format off */
+#define DEFINE_SUM(isa, ATTR, name, T, VT, ACC_T)                          \
+  ATTR static ACC_T name##_##isa(const T *const p, const size_t n) {       \
+    const size_t LANES = sizeof(VT) / sizeof(T);                           \
+    VT acc0 = {0}, acc1 = {0}, acc2 = {0}, acc3 = {0};                     \
+    size_t i = 0;                                                          \
+    for (; i + 4 * LANES <= n; i += 4 * LANES) {                           \
+      VT v0, v1, v2, v3;                                                   \
+      LOAD(v0, p + i);                                                     \
+      LOAD(v1, p + i + LANES);                                             \
+      LOAD(v2, p + i + 2 * LANES);                                         \
+      LOAD(v3, p + i + 3 * LANES);                                         \
+      acc0 += v0;                                                          \
+      acc1 += v1;                                                          \
+      acc2 += v2;                                                          \
+      acc3 += v3;                                                          \
+    }                                                                      \
+    for (; i + LANES <= n; i += LANES) {                                   \
+      VT v;                                                                \
+      LOAD(v, p + i);                                                      \
+      acc0 += v;                                                           \
+    }                                                                      \
+    acc0 = (acc0 + acc1) + (acc2 + acc3);                                  \
+    ACC_T sum = 0;                                                         \
+    for (size_t l = 0; l < LANES; l++) sum += (ACC_T)acc0[l];              \
+    for (; i < n; i++) sum += (ACC_T)p[i];                                 \
+    return sum;                                                            \
+  }
+
+/* Sums `int32_t` elements in `int64_t` lanes, widening half a vector each. */
+#define DEFINE_SUM_I32(isa, ATTR, VT, HALF_VT)                             \
+  ATTR static int64_t sum_i32_##isa(const int32_t *const p,                \
+                                    const size_t n) {                      \
+    const size_t LANES = sizeof(VT) / sizeof(int64_t);                     \
+    VT acc0 = {0}, acc1 = {0};                                             \
+    size_t i = 0;                                                          \
+    for (; i + 2 * LANES <= n; i += 2 * LANES) {                           \
+      HALF_VT h0, h1;                                                      \
+      LOAD(h0, p + i);                                                     \
+      LOAD(h1, p + i + LANES);                                             \
+      acc0 += __builtin_convertvector(h0, VT);                             \
+      acc1 += __builtin_convertvector(h1, VT);                             \
+    }                                                                      \
+    acc0 += acc1;                                                          \
+    int64_t sum = 0;                                                       \
+    for (size_t l = 0; l < LANES; l++) sum += acc0[l];                     \
+    for (; i < n; i++) sum += p[i];                                        \
+    return sum;                                                            \
+  }
+
+#define DEFINE_DOT(isa, ATTR, name, T, VT, ACC_T)                          \
+  ATTR static ACC_T name##_##isa(const T *const a, const T *const b,       \
+                                 const size_t n) {                         \
+    const size_t LANES = sizeof(VT) / sizeof(T);                           \
+    VT acc0 = {0}, acc1 = {0};                                             \
+    size_t i = 0;                                                          \
+    for (; i + 2 * LANES <= n; i += 2 * LANES) {                           \
+      VT a0, a1, b0, b1;                                                   \
+      LOAD(a0, a + i);                                                     \
+      LOAD(a1, a + i + LANES);                                             \
+      LOAD(b0, b + i);                                                     \
+      LOAD(b1, b + i + LANES);                                             \
+      acc0 += a0 * b0;                                                     \
+      acc1 += a1 * b1;                                                     \
+    }                                                                      \
+    acc0 += acc1;                                                          \
+    ACC_T sum = 0;                                                         \
+    for (size_t l = 0; l < LANES; l++) sum += (ACC_T)acc0[l];              \
+    for (; i < n; i++) sum += (ACC_T)a[i] * (ACC_T)b[i];                   \
+    return sum;                                                            \
+  }
+
+/*
+ * Products of `int32_t` elements are formed in `uint64_t` lanes, after
+ * sign-extending through `int64_t` ones, so that they wrap around.
+ */
+#define DEFINE_DOT_I32(isa, ATTR, VT, UT, HALF_VT)                         \
+  ATTR static uint64_t dot_i32_##isa(const int32_t *const a,               \
+                                     const int32_t *const b,               \
+                                     const size_t n) {                     \
+    const size_t LANES = sizeof(UT) / sizeof(uint64_t);                    \
+    UT acc = {0};                                                          \
+    size_t i = 0;                                                          \
+    for (; i + LANES <= n; i += LANES) {                                   \
+      HALF_VT ha, hb;                                                      \
+      LOAD(ha, a + i);                                                     \
+      LOAD(hb, b + i);                                                     \
+      acc += (UT)__builtin_convertvector(ha, VT) *                         \
+             (UT)__builtin_convertvector(hb, VT);                          \
+    }                                                                      \
+    uint64_t sum = 0;                                                      \
+    for (size_t l = 0; l < LANES; l++) sum += acc[l];                      \
+    for (; i < n; i++) sum += (uint64_t)a[i] * (uint64_t)b[i];             \
+    return sum;                                                            \
+  }
+
+/* Requires `n` to be at least one. */
+#define DEFINE_MIN_MAX(isa, ATTR, name, T, VT, MT)                         \
+  ATTR static void name##_##isa(const T *const p, const size_t n,          \
+                                T *const min, T *const max) {              \
+    const size_t LANES = sizeof(VT) / sizeof(T);                           \
+    T lo = p[0], hi = p[0];                                                \
+    size_t i = 0;                                                          \
+    if (n >= LANES) {                                                      \
+      VT vlo, vhi;                                                         \
+      LOAD(vlo, p);                                                        \
+      vhi = vlo;                                                           \
+      for (i = LANES; i + LANES <= n; i += LANES) {                        \
+        VT v;                                                              \
+        LOAD(v, p + i);                                                    \
+        const MT LESS = v < vlo;                                           \
+        const MT GREATER = v > vhi;                                        \
+        vlo = BLEND(VT, MT, LESS, v, vlo);                                 \
+        vhi = BLEND(VT, MT, GREATER, v, vhi);                              \
+      }                                                                    \
+      lo = vlo[0];                                                         \
+      hi = vhi[0];                                                         \
+      for (size_t l = 1; l < LANES; l++) {                                 \
+        if (vlo[l] < lo) lo = vlo[l];                                      \
+        if (vhi[l] > hi) hi = vhi[l];                                      \
+      }                                                                    \
+    }                                                                      \
+    for (; i < n; i++) {                                                   \
+      if (p[i] < lo) lo = p[i];                                            \
+      if (p[i] > hi) hi = p[i];                                            \
+    }                                                                      \
+    *min = lo;                                                             \
+    *max = hi;                                                             \
+  }
+
+#define DEFINE_FILL(isa, ATTR, name, T, VT)                                \
+  ATTR static void name##_##isa(T *const p, const size_t n,                \
+                                const T value) {                           \
+    const size_t LANES = sizeof(VT) / sizeof(T);                           \
+    const VT V = (VT){0} + value;                                          \
+    size_t i = 0;                                                          \
+    for (; i + LANES <= n; i += LANES) STORE(p + i, V);                    \
+    for (; i < n; i++) p[i] = value;                                       \
+  }
+
+#define DEFINE_SCALE(isa, ATTR, name, T, VT, U)                            \
+  ATTR static void name##_##isa(T *const p, const size_t n,                \
+                                const T factor) {                          \
+    const size_t LANES = sizeof(VT) / sizeof(T);                           \
+    const VT FACTOR = (VT){0} + (U)factor;                                 \
+    size_t i = 0;                                                          \
+    for (; i + LANES <= n; i += LANES) {                                   \
+      VT v;                                                                \
+      LOAD(v, p + i);                                                      \
+      v *= FACTOR;                                                         \
+      STORE(p + i, v);                                                     \
+    }                                                                      \
+    for (; i < n; i++) p[i] = WRAPPING_MUL(T, U, p[i], factor);            \
+  }
+
+/* Only floating-point equality needs comparing; integers use `memcmp()`. */
+#define DEFINE_EQUAL(isa, ATTR, name, T, VT, MT)                           \
+  ATTR static bool name##_##isa(const T *const a, const T *const b,        \
+                                const size_t n) {                          \
+    const size_t LANES = sizeof(VT) / sizeof(T);                           \
+    size_t i = 0;                                                          \
+    for (; i + LANES <= n; i += LANES) {                                   \
+      VT va, vb;                                                           \
+      LOAD(va, a + i);                                                     \
+      LOAD(vb, b + i);                                                     \
+      const MT DIFFERENT = va != vb;                                       \
+      MT any = DIFFERENT;                                                  \
+      for (size_t l = 1; l < LANES; l++) any[0] |= DIFFERENT[l];           \
+      if (any[0] != 0) return false;                                       \
+    }                                                                      \
+    for (; i < n; i++)                                                     \
+      if (a[i] != b[i]) return false;                                      \
+    return true;                                                           \
+  }
+
+/*
+ * Instantiates every kernel for vectors of `B` bytes, suffixing each name
+ * with `isa` and marking each function with `ATTR`. `H` is half of `B`.
+ */
+#define DEFINE_KERNELS(isa, ATTR, B, H)                                    \
+  DEFINE_SUM_I32(isa, ATTR, i64_v##B, i32_v##H)                            \
+  DEFINE_SUM(isa, ATTR, sum_i64, int64_t, u64_v##B, uint64_t)              \
+  DEFINE_SUM(isa, ATTR, sum_f32, float, f32_v##B, float)                   \
+  DEFINE_SUM(isa, ATTR, sum_f64, double, f64_v##B, double)                 \
+  DEFINE_MIN_MAX(isa, ATTR, min_max_i32, int32_t, i32_v##B, i32_v##B)      \
+  DEFINE_MIN_MAX(isa, ATTR, min_max_i64, int64_t, i64_v##B, i64_v##B)      \
+  DEFINE_MIN_MAX(isa, ATTR, min_max_f32, float, f32_v##B, i32_v##B)        \
+  DEFINE_MIN_MAX(isa, ATTR, min_max_f64, double, f64_v##B, i64_v##B)       \
+  DEFINE_FILL(isa, ATTR, fill_i32, int32_t, i32_v##B)                      \
+  DEFINE_FILL(isa, ATTR, fill_i64, int64_t, i64_v##B)                      \
+  DEFINE_FILL(isa, ATTR, fill_f32, float, f32_v##B)                        \
+  DEFINE_FILL(isa, ATTR, fill_f64, double, f64_v##B)                       \
+  DEFINE_SCALE(isa, ATTR, scale_i32, int32_t, u32_v##B, uint32_t)          \
+  DEFINE_SCALE(isa, ATTR, scale_i64, int64_t, u64_v##B, uint64_t)          \
+  DEFINE_SCALE(isa, ATTR, scale_f32, float, f32_v##B, float)               \
+  DEFINE_SCALE(isa, ATTR, scale_f64, double, f64_v##B, double)             \
+  DEFINE_DOT_I32(isa, ATTR, i64_v##B, u64_v##B, i32_v##H)                  \
+  DEFINE_DOT(isa, ATTR, dot_i64, int64_t, u64_v##B, uint64_t)              \
+  DEFINE_DOT(isa, ATTR, dot_f32, float, f32_v##B, float)                   \
+  DEFINE_DOT(isa, ATTR, dot_f64, double, f64_v##B, double)                 \
+  DEFINE_EQUAL(isa, ATTR, equal_f32, float, f32_v##B, i32_v##B)            \
+  DEFINE_EQUAL(isa, ATTR, equal_f64, double, f64_v##B, i64_v##B)
+/* clang-format on */
+
+DEFINE_KERNELS(sse2, , 16, 8)
+DEFINE_KERNELS(avx2, __attribute__((target("avx2"))), 32, 16)
+DEFINE_KERNELS(avx512,
+               __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl"))),
+               64, 32)
+#endif
+
+/* - DISPATCH - */
+
+typedef struct array_kernels {
+  int64_t (*sum_i32)(const int32_t *, size_t);
+  uint64_t (*sum_i64)(const int64_t *, size_t);
+  float (*sum_f32)(const float *, size_t);
+  double (*sum_f64)(const double *, size_t);
+  void (*min_max_i32)(const int32_t *, size_t, int32_t *, int32_t *);
+  void (*min_max_i64)(const int64_t *, size_t, int64_t *, int64_t *);
+  void (*min_max_f32)(const float *, size_t, float *, float *);
+  void (*min_max_f64)(const double *, size_t, double *, double *);
+  void (*fill_i32)(int32_t *, size_t, int32_t);
+  void (*fill_i64)(int64_t *, size_t, int64_t);
+  void (*fill_f32)(float *, size_t, float);
+  void (*fill_f64)(double *, size_t, double);
+  void (*scale_i32)(int32_t *, size_t, int32_t);
+  void (*scale_i64)(int64_t *, size_t, int64_t);
+  void (*scale_f32)(float *, size_t, float);
+  void (*scale_f64)(double *, size_t, double);
+  uint64_t (*dot_i32)(const int32_t *, const int32_t *, size_t);
+  uint64_t (*dot_i64)(const int64_t *, const int64_t *, size_t);
+  float (*dot_f32)(const float *, const float *, size_t);
+  double (*dot_f64)(const double *, const double *, size_t);
+  bool (*equal_f32)(const float *, const float *, size_t);
+  bool (*equal_f64)(const double *, const double *, size_t);
+} array_kernels;
+
+/* clang-format off */
+#define KERNEL_TABLE(isa)                                                  \
+  {sum_i32_##isa,     sum_i64_##isa,     sum_f32_##isa,                    \
+   sum_f64_##isa,     min_max_i32_##isa, min_max_i64_##isa,                \
+   min_max_f32_##isa, min_max_f64_##isa, fill_i32_##isa,                   \
+   fill_i64_##isa,    fill_f32_##isa,    fill_f64_##isa,                   \
+   scale_i32_##isa,   scale_i64_##isa,   scale_f32_##isa,                  \
+   scale_f64_##isa,   dot_i32_##isa,     dot_i64_##isa,                    \
+   dot_f32_##isa,     dot_f64_##isa,     equal_f32_##isa,                  \
+   equal_f64_##isa}
+/* clang-format on */
+
+/* Levels without kernels on this architecture are never selected. */
+static const array_kernels KERNELS[SIMD_LEVEL_COUNT] = {
+    [SIMD_SCALAR] = KERNEL_TABLE(scalar),
+#if HAVE_X86_KERNELS
+    [SIMD_SSE2] = KERNEL_TABLE(sse2),
+    [SIMD_AVX2] = KERNEL_TABLE(avx2),
+    [SIMD_AVX512] = KERNEL_TABLE(avx512),
+#endif
+};
+
+#define SELECT_KERNEL(name) (KERNELS[get_simd_level()].name)
+
+/* - PUBLIC INTERFACE - */
+
+int64_t array_sum_i32(const array_t *const arr) {
+  return SELECT_KERNEL(sum_i32)(arr->data, arr->length);
+}
+
+int64_t array_sum_i64(const array_t *const arr) {
+  return (int64_t)SELECT_KERNEL(sum_i64)(arr->data, arr->length);
+}
+
+float array_sum_f32(const array_t *const arr) {
+  return SELECT_KERNEL(sum_f32)(arr->data, arr->length);
+}
+
+double array_sum_f64(const array_t *const arr) {
+  return SELECT_KERNEL(sum_f64)(arr->data, arr->length);
+}
+
+/* clang-format off */
+#define DEFINE_PUBLIC_MIN_MAX(suffix, T)                                   \
+  bool array_min_max_##suffix(const array_t *const arr, T *const min,      \
+                              T *const max) {                              \
+    if (arr->length == 0) return false;                                    \
+    SELECT_KERNEL(min_max_##suffix)(arr->data, arr->length, min, max);     \
+    return true;                                                           \
+  }
+
+#define DEFINE_PUBLIC_FILL_SCALE(suffix, T)                                \
+  void array_fill_##suffix(array_t *const arr, const T value) {            \
+    SELECT_KERNEL(fill_##suffix)(arr->data, arr->length, value);           \
+  }                                                                        \
+  void array_scale_##suffix(array_t *const arr, const T factor) {          \
+    SELECT_KERNEL(scale_##suffix)(arr->data, arr->length, factor);         \
+  }
+
+#define DEFINE_PUBLIC_DOT(suffix, T)                                       \
+  bool array_dot_##suffix(const array_t *const a, const array_t *const b,  \
+                          T *const out) {                                  \
+    if (a->length != b->length) return false;                              \
+    *out = (T)SELECT_KERNEL(dot_##suffix)(a->data, b->data, a->length);    \
+    return true;                                                           \
+  }
+/* clang-format on */
+
+DEFINE_PUBLIC_MIN_MAX(i32, int32_t)
+DEFINE_PUBLIC_MIN_MAX(i64, int64_t)
+DEFINE_PUBLIC_MIN_MAX(f32, float)
+DEFINE_PUBLIC_MIN_MAX(f64, double)
+DEFINE_PUBLIC_FILL_SCALE(i32, int32_t)
+DEFINE_PUBLIC_FILL_SCALE(i64, int64_t)
+DEFINE_PUBLIC_FILL_SCALE(f32, float)
+DEFINE_PUBLIC_FILL_SCALE(f64, double)
+DEFINE_PUBLIC_DOT(i32, int64_t)
+DEFINE_PUBLIC_DOT(i64, int64_t)
+DEFINE_PUBLIC_DOT(f32, float)
+DEFINE_PUBLIC_DOT(f64, double)
+
+/* Integers are equal exactly when their bytes are. */
+static bool same_bytes(const array_t *const a, const array_t *const b) {
+  return a->length == b->length &&
+         memcmp(a->data, b->data, a->length * a->elem_size) == 0;
+}
+
+bool array_equal_i32(const array_t *const a, const array_t *const b) {
+  return same_bytes(a, b);
+}
+
+bool array_equal_i64(const array_t *const a, const array_t *const b) {
+  return same_bytes(a, b);
+}
+
+bool array_equal_f32(const array_t *const a, const array_t *const b) {
+  return a->length == b->length &&
+         SELECT_KERNEL(equal_f32)(a->data, b->data, a->length);
+}
+
+bool array_equal_f64(const array_t *const a, const array_t *const b) {
+  return a->length == b->length &&
+         SELECT_KERNEL(equal_f64)(a->data, b->data, a->length);
+}
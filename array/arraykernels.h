@@ -0,0 +1,69 @@
+#ifndef ARRAYKERNELS_H
+#define ARRAYKERNELS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/*
+ * Numeric kernels over arrays of `int32_t`, `int64_t`, `float` and `double`,
+ * named by the suffixes `_i32`, `_i64`, `_f32` and `_f64`. Each array must
+ * hold elements of the suffix's type.
+ *
+ * Each kernel has a scalar version and, on x86, SSE2, AVX2 and AVX-512
+ * versions, chosen on every call by `get_simd_level()`. Integer results
+ * wrap around on overflow. Floating-point sums and dot products are
+ * accumulated in several lanes at once, so they may differ from a sequential
+ * loop in the last bits, and results involving NaNs are unspecified.
+ */
+
+int64_t array_sum_i32(const array_t *arr);
+int64_t array_sum_i64(const array_t *arr);
+float array_sum_f32(const array_t *arr);
+double array_sum_f64(const array_t *arr);
+
+/*
+ * Finds the smallest and largest elements of `arr`.
+ *
+ * \return `true` upon success or `false` if `arr` is empty.
+ */
+bool array_min_max_i32(const array_t *arr, int32_t *min, int32_t *max);
+bool array_min_max_i64(const array_t *arr, int64_t *min, int64_t *max);
+bool array_min_max_f32(const array_t *arr, float *min, float *max);
+bool array_min_max_f64(const array_t *arr, double *min, double *max);
+
+/* Sets every element of `arr` to `value`. */
+void array_fill_i32(array_t *arr, int32_t value);
+void array_fill_i64(array_t *arr, int64_t value);
+void array_fill_f32(array_t *arr, float value);
+void array_fill_f64(array_t *arr, double value);
+
+/* Multiplies every element of `arr` by `factor`. */
+void array_scale_i32(array_t *arr, int32_t factor);
+void array_scale_i64(array_t *arr, int64_t factor);
+void array_scale_f32(array_t *arr, float factor);
+void array_scale_f64(array_t *arr, double factor);
+
+/*
+ * Computes the dot product of `a` and `b` into `out`. Products of `int32_t`
+ * elements are summed as `int64_t`.
+ *
+ * \return `true` upon success or `false` if the lengths of `a` and `b` differ.
+ */
+bool array_dot_i32(const array_t *a, const array_t *b, int64_t *out);
+bool array_dot_i64(const array_t *a, const array_t *b, int64_t *out);
+bool array_dot_f32(const array_t *a, const array_t *b, float *out);
+bool array_dot_f64(const array_t *a, const array_t *b, double *out);
+
+/*
+ * Returns `true` if `a` and `b` have the same length and equal elements.
+ * Floating-point elements are compared as numbers, so `-0.0` equals `0.0`
+ * and NaNs equal nothing.
+ */
+bool array_equal_i32(const array_t *a, const array_t *b);
+bool array_equal_i64(const array_t *a, const array_t *b);
+bool array_equal_f32(const array_t *a, const array_t *b);
+bool array_equal_f64(const array_t *a, const array_t *b);
+
+#endif
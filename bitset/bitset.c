@@ -0,0 +1,368 @@
+#include "bitset.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../dispatch/dispatch.h"
+#include "../hugealloc/hugealloc.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS (1)
+#include <immintrin.h>
+#else
+#define HAVE_X86_KERNELS (0)
+#endif
+
+#define WORD_BITS ((size_t)64)
+
+/* The words start at this offset from the header, keeping them 16-aligned. */
+#define WORDS_OFFSET ((size_t)32)
+
+static size_t words_for(const size_t num_bits) {
+  return (num_bits + WORD_BITS - 1) / WORD_BITS;
+}
+
+/* Returns a mask of the bits of the last word which lie within the bitset. */
+static uint64_t last_word_mask(const size_t num_bits) {
+  const size_t USED = num_bits % WORD_BITS;
+  return (USED == 0) ? ~(uint64_t)0 : ((uint64_t)1 << USED) - 1;
+}
+
+static unsigned count_trailing_zeros(const uint64_t word) {
+#if defined(__GNUC__)
+  return (unsigned)__builtin_ctzll(word);
+#else
+  unsigned i = 0;
+  while (!(word & ((uint64_t)1 << i))) i++;
+  return i;
+#endif
+}
+
+static size_t popcount_word(uint64_t word) {
+#if defined(__GNUC__)
+  return (size_t)__builtin_popcountll(word);
+#else
+  word = word - ((word >> 1) & 0x5555555555555555ULL);
+  word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+  word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (size_t)((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* - KERNELS - */
+
+typedef void (*word_op_t)(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                          size_t num_words);
+
+#define AND_WORD(x, y) ((x) & (y))
+#define OR_WORD(x, y) ((x) | (y))
+#define XOR_WORD(x, y) ((x) ^ (y))
+#define ANDNOT_WORD(x, y) ((x) & ~(y))
+
+static size_t popcount_scalar(const uint64_t *const words, const size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) count += popcount_word(words[i]);
+  return count;
+}
+
+/* clang-format off */
+#define DEFINE_SCALAR_OP(name, OP)                                        \
+  static void name##_scalar(uint64_t *const dst, const uint64_t *const a, \
+                            const uint64_t *const b, const size_t n) {    \
+    for (size_t i = 0; i < n; i++) dst[i] = OP(a[i], b[i]);               \
+  }
+/* clang-format on */
+
+DEFINE_SCALAR_OP(and, AND_WORD)
+DEFINE_SCALAR_OP(or, OR_WORD)
+DEFINE_SCALAR_OP(xor, XOR_WORD)
+DEFINE_SCALAR_OP(andnot, ANDNOT_WORD)
+
+#if HAVE_X86_KERNELS
+/*
+ * The `_mm*_andnot_*` intrinsics negate their first operand, hence the
+ * swapped arguments.
+ */
+#define ANDNOT_SSE2(x, y) _mm_andnot_si128(y, x)
+#define ANDNOT_AVX2(x, y) _mm256_andnot_si256(y, x)
+#define ANDNOT_AVX512(x, y) _mm512_andnot_si512(y, x)
+
+/* clang-format off */
+#define DEFINE_SSE2_OP(name, OP, SCALAR_OP)                                \
+  static void name##_sse2(uint64_t *const dst, const uint64_t *const a,    \
+                          const uint64_t *const b, const size_t n) {       \
+    size_t i = 0;                                                          \
+    for (; i + 2 <= n; i += 2) {                                           \
+      const __m128i A = _mm_loadu_si128((const __m128i *)(a + i));         \
+      const __m128i B = _mm_loadu_si128((const __m128i *)(b + i));         \
+      _mm_storeu_si128((__m128i *)(dst + i), OP(A, B));                    \
+    }                                                                      \
+    for (; i < n; i++) dst[i] = SCALAR_OP(a[i], b[i]);                     \
+  }
+
+#define DEFINE_AVX2_OP(name, OP, SCALAR_OP)                                \
+  __attribute__((target("avx2")))                                          \
+  static void name##_avx2(uint64_t *const dst, const uint64_t *const a,    \
+                          const uint64_t *const b, const size_t n) {       \
+    size_t i = 0;                                                          \
+    for (; i + 4 <= n; i += 4) {                                           \
+      const __m256i A = _mm256_loadu_si256((const __m256i *)(a + i));      \
+      const __m256i B = _mm256_loadu_si256((const __m256i *)(b + i));      \
+      _mm256_storeu_si256((__m256i *)(dst + i), OP(A, B));                 \
+    }                                                                      \
+    for (; i < n; i++) dst[i] = SCALAR_OP(a[i], b[i]);                     \
+  }
+
+#define DEFINE_AVX512_OP(name, OP, SCALAR_OP)                              \
+  __attribute__((target("avx512f")))                                       \
+  static void name##_avx512(uint64_t *const dst, const uint64_t *const a,  \
+                            const uint64_t *const b, const size_t n) {     \
+    size_t i = 0;                                                          \
+    for (; i + 8 <= n; i += 8) {                                           \
+      const __m512i A = _mm512_loadu_si512((const void *)(a + i));         \
+      const __m512i B = _mm512_loadu_si512((const void *)(b + i));         \
+      _mm512_storeu_si512((void *)(dst + i), OP(A, B));                    \
+    }                                                                      \
+    for (; i < n; i++) dst[i] = SCALAR_OP(a[i], b[i]);                     \
+  }
+/* clang-format on */
+
+DEFINE_SSE2_OP(and, _mm_and_si128, AND_WORD)
+DEFINE_SSE2_OP(or, _mm_or_si128, OR_WORD)
+DEFINE_SSE2_OP(xor, _mm_xor_si128, XOR_WORD)
+DEFINE_SSE2_OP(andnot, ANDNOT_SSE2, ANDNOT_WORD)
+DEFINE_AVX2_OP(and, _mm256_and_si256, AND_WORD)
+DEFINE_AVX2_OP(or, _mm256_or_si256, OR_WORD)
+DEFINE_AVX2_OP(xor, _mm256_xor_si256, XOR_WORD)
+DEFINE_AVX2_OP(andnot, ANDNOT_AVX2, ANDNOT_WORD)
+DEFINE_AVX512_OP(and, _mm512_and_si512, AND_WORD)
+DEFINE_AVX512_OP(or, _mm512_or_si512, OR_WORD)
+DEFINE_AVX512_OP(xor, _mm512_xor_si512, XOR_WORD)
+DEFINE_AVX512_OP(andnot, ANDNOT_AVX512, ANDNOT_WORD)
+
+__attribute__((target("popcnt"))) static size_t popcount_popcnt(
+    const uint64_t *const words, const size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+    count += (size_t)__builtin_popcountll(words[i]);
+  return count;
+}
+
+/* `popcnt` is not part of SSE2, so it is checked for separately. */
+static size_t popcount_sse2(const uint64_t *const words, const size_t n) {
+  if (__builtin_cpu_supports("popcnt")) return popcount_popcnt(words, n);
+  return popcount_scalar(words, n);
+}
+
+/*
+ * Counts bits four words at a time by looking up the count of each nibble
+ * with a byte shuffle and summing the byte counts with `_mm256_sad_epu8()`.
+ */
+__attribute__((target("avx2"))) static size_t popcount_avx2(
+    const uint64_t *const words, const size_t n) {
+  const __m256i NIBBLE_COUNTS =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i LOW_NIBBLES = _mm256_set1_epi8(0x0F);
+  __m256i totals = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256i V = _mm256_loadu_si256((const __m256i *)(words + i));
+    const __m256i LO = _mm256_and_si256(V, LOW_NIBBLES);
+    const __m256i HI = _mm256_and_si256(_mm256_srli_epi16(V, 4), LOW_NIBBLES);
+    const __m256i COUNTS =
+        _mm256_add_epi8(_mm256_shuffle_epi8(NIBBLE_COUNTS, LO),
+                        _mm256_shuffle_epi8(NIBBLE_COUNTS, HI));
+    totals = _mm256_add_epi64(
+        totals, _mm256_sad_epu8(COUNTS, _mm256_setzero_si256()));
+  }
+  uint64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, totals);
+  size_t count = (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+  for (; i < n; i++) count += (size_t)__builtin_popcountll(words[i]);
+  return count;
+}
+
+/* The same nibble lookup as `popcount_avx2()`, eight words at a time. */
+__attribute__((target("avx512f,avx512bw"))) static size_t popcount_avx512(
+    const uint64_t *const words, const size_t n) {
+  const __m512i NIBBLE_COUNTS = _mm512_broadcast_i32x4(
+      _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+  const __m512i LOW_NIBBLES = _mm512_set1_epi8(0x0F);
+  __m512i totals = _mm512_setzero_si512();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m512i V = _mm512_loadu_si512((const void *)(words + i));
+    const __m512i LO = _mm512_and_si512(V, LOW_NIBBLES);
+    const __m512i HI = _mm512_and_si512(_mm512_srli_epi16(V, 4), LOW_NIBBLES);
+    const __m512i COUNTS =
+        _mm512_add_epi8(_mm512_shuffle_epi8(NIBBLE_COUNTS, LO),
+                        _mm512_shuffle_epi8(NIBBLE_COUNTS, HI));
+    totals = _mm512_add_epi64(
+        totals, _mm512_sad_epu8(COUNTS, _mm512_setzero_si512()));
+  }
+  size_t count = (size_t)_mm512_reduce_add_epi64(totals);
+  for (; i < n; i++) count += (size_t)__builtin_popcountll(words[i]);
+  return count;
+}
+#endif
+
+/* - DISPATCH - */
+
+typedef struct bitset_kernels {
+  word_op_t and_op, or_op, xor_op, andnot_op;
+  size_t (*popcount)(const uint64_t *words, size_t num_words);
+} bitset_kernels;
+
+/* Levels without kernels on this architecture are never selected. */
+static const bitset_kernels KERNELS[SIMD_LEVEL_COUNT] = {
+    [SIMD_SCALAR] = {and_scalar, or_scalar, xor_scalar, andnot_scalar,
+                     popcount_scalar},
+#if HAVE_X86_KERNELS
+    [SIMD_SSE2] = {and_sse2, or_sse2, xor_sse2, andnot_sse2, popcount_sse2},
+    [SIMD_AVX2] = {and_avx2, or_avx2, xor_avx2, andnot_avx2, popcount_avx2},
+    [SIMD_AVX512] = {and_avx512, or_avx512, xor_avx512, andnot_avx512,
+                     popcount_avx512},
+#endif
+};
+
+#define SELECT_OP(name) (KERNELS[get_simd_level()].name##_op)
+
+static size_t count_bits(const uint64_t *const words, const size_t n) {
+  return KERNELS[get_simd_level()].popcount(words, n);
+}
+
+/* - PUBLIC INTERFACE - */
+
+bitset_t *new_bitset(const size_t num_bits) {
+  const size_t NUM_WORDS = words_for(num_bits);
+  bitset_t *const bs = huge_alloc(WORDS_OFFSET + NUM_WORDS * sizeof(uint64_t));
+  if (bs == NULL) return NULL;
+  bs->words = (uint64_t *)((unsigned char *)bs + WORDS_OFFSET);
+  bs->num_bits = num_bits;
+  bs->num_words = NUM_WORDS;
+  memset(bs->words, 0, NUM_WORDS * sizeof(uint64_t));
+  return bs;
+}
+
+void _delete_bitset(bitset_t **const bs) {
+  huge_free(*bs);
+  *bs = NULL;
+}
+
+bitset_t *resize_bitset(bitset_t *bs, const size_t num_bits) {
+  const size_t NUM_WORDS = words_for(num_bits);
+  bs = huge_realloc(bs, WORDS_OFFSET + NUM_WORDS * sizeof(uint64_t));
+  if (bs == NULL) return NULL;
+  bs->words = (uint64_t *)((unsigned char *)bs + WORDS_OFFSET);
+  if (NUM_WORDS > bs->num_words) {
+    memset(bs->words + bs->num_words, 0,
+           (NUM_WORDS - bs->num_words) * sizeof(uint64_t));
+  }
+  bs->num_bits = num_bits;
+  bs->num_words = NUM_WORDS;
+  if (NUM_WORDS != 0) bs->words[NUM_WORDS - 1] &= last_word_mask(num_bits);
+  return bs;
+}
+
+void bitset_set(bitset_t *const bs, const size_t index) {
+  bs->words[index / WORD_BITS] |= (uint64_t)1 << (index % WORD_BITS);
+}
+
+void bitset_clear(bitset_t *const bs, const size_t index) {
+  bs->words[index / WORD_BITS] &= ~((uint64_t)1 << (index % WORD_BITS));
+}
+
+void bitset_flip(bitset_t *const bs, const size_t index) {
+  bs->words[index / WORD_BITS] ^= (uint64_t)1 << (index % WORD_BITS);
+}
+
+bool bitset_test(const bitset_t *const bs, const size_t index) {
+  return (bs->words[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+}
+
+/* Sets or clears every bit in `[begin, end)` a word at a time. */
+static void fill_range(bitset_t *const bs, const size_t begin, size_t end,
+                       const bool value) {
+  if (end > bs->num_bits) end = bs->num_bits;
+  if (begin >= end) return;
+  const size_t FIRST = begin / WORD_BITS;
+  const size_t LAST = (end - 1) / WORD_BITS;
+  const uint64_t FIRST_MASK = ~(uint64_t)0 << (begin % WORD_BITS);
+  const uint64_t LAST_MASK = last_word_mask(end);
+  if (FIRST == LAST) {
+    const uint64_t MASK = FIRST_MASK & LAST_MASK;
+    bs->words[FIRST] =
+        value ? bs->words[FIRST] | MASK : bs->words[FIRST] & ~MASK;
+    return;
+  }
+  bs->words[FIRST] =
+      value ? bs->words[FIRST] | FIRST_MASK : bs->words[FIRST] & ~FIRST_MASK;
+  memset(bs->words + FIRST + 1, value ? 0xFF : 0,
+         (LAST - FIRST - 1) * sizeof(uint64_t));
+  bs->words[LAST] =
+      value ? bs->words[LAST] | LAST_MASK : bs->words[LAST] & ~LAST_MASK;
+}
+
+void bitset_set_range(bitset_t *const bs, const size_t begin,
+                      const size_t end) {
+  fill_range(bs, begin, end, true);
+}
+
+void bitset_clear_range(bitset_t *const bs, const size_t begin,
+                        const size_t end) {
+  fill_range(bs, begin, end, false);
+}
+
+size_t bitset_popcount(const bitset_t *const bs) {
+  return count_bits(bs->words, bs->num_words);
+}
+
+size_t bitset_rank(const bitset_t *const bs, size_t index) {
+  if (index > bs->num_bits) index = bs->num_bits;
+  const size_t FULL_WORDS = index / WORD_BITS;
+  size_t rank = count_bits(bs->words, FULL_WORDS);
+  if (index % WORD_BITS != 0)
+    rank += popcount_word(bs->words[FULL_WORDS] & last_word_mask(index));
+  return rank;
+}
+
+size_t bitset_find_next_set(const bitset_t *const bs, const size_t from) {
+  if (from >= bs->num_bits) return BITSET_NPOS;
+  size_t word_index = from / WORD_BITS;
+  uint64_t word = bs->words[word_index] & (~(uint64_t)0 << (from % WORD_BITS));
+  while (word == 0) {
+    if (++word_index == bs->num_words) return BITSET_NPOS;
+    word = bs->words[word_index];
+  }
+  return word_index * WORD_BITS + count_trailing_zeros(word);
+}
+
+static bool apply_op(const word_op_t op, bitset_t *const dst,
+                     const bitset_t *const a, const bitset_t *const b) {
+  if (dst->num_bits != a->num_bits || a->num_bits != b->num_bits) return false;
+  op(dst->words, a->words, b->words, dst->num_words);
+  return true;
+}
+
+bool bitset_and(bitset_t *const dst, const bitset_t *const a,
+                const bitset_t *const b) {
+  return apply_op(SELECT_OP(and), dst, a, b);
+}
+
+bool bitset_or(bitset_t *const dst, const bitset_t *const a,
+               const bitset_t *const b) {
+  return apply_op(SELECT_OP(or), dst, a, b);
+}
+
+bool bitset_xor(bitset_t *const dst, const bitset_t *const a,
+                const bitset_t *const b) {
+  return apply_op(SELECT_OP(xor), dst, a, b);
+}
+
+bool bitset_andnot(bitset_t *const dst, const bitset_t *const a,
+                   const bitset_t *const b) {
+  return apply_op(SELECT_OP(andnot), dst, a, b);
+}
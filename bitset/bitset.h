@@ -0,0 +1,95 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Returned by the search functions when no bit was found. */
+#define BITSET_NPOS SIZE_MAX
+
+#define delete_bitset(bs) _delete_bitset(&(bs))
+
+/*
+ * A fixed-size set of bits packed into 64-bit words. Like `array_t`, the
+ * header and the words share one allocation. Bits past `num_bits` within the
+ * last word are always zero.
+ */
+typedef struct bitset_t {
+  uint64_t *words;
+  size_t num_bits;
+  size_t num_words;
+} bitset_t;
+
+/*
+ * Creates a `bitset_t` of `num_bits` bits, all of which are clear.
+ *
+ * \return A pointer to the new `bitset_t` or `NULL` upon failure.
+ */
+bitset_t *new_bitset(size_t num_bits);
+
+/*
+ * Frees the memory used by `bs` and invalidates the passed pointer.
+ */
+void _delete_bitset(bitset_t **bs);
+
+/*
+ * Resizes `bs` to hold `num_bits` bits. Added bits are clear.
+ *
+ * \return A (possibly new) pointer associated with the contents of `bs`, or
+ * `NULL` upon failure in which case `bs` is unmodified.
+ */
+bitset_t *resize_bitset(bitset_t *bs, size_t num_bits);
+
+/* Sets the bit at `index`, which must be less than `bs->num_bits`. */
+void bitset_set(bitset_t *bs, size_t index);
+
+/* Clears the bit at `index`, which must be less than `bs->num_bits`. */
+void bitset_clear(bitset_t *bs, size_t index);
+
+/* Flips the bit at `index`, which must be less than `bs->num_bits`. */
+void bitset_flip(bitset_t *bs, size_t index);
+
+/* Returns the bit at `index`, which must be less than `bs->num_bits`. */
+bool bitset_test(const bitset_t *bs, size_t index);
+
+/*
+ * Sets every bit within `[begin, end)`. The range is clamped to the size of
+ * `bs`.
+ */
+void bitset_set_range(bitset_t *bs, size_t begin, size_t end);
+
+/*
+ * Clears every bit within `[begin, end)`. The range is clamped to the size of
+ * `bs`.
+ */
+void bitset_clear_range(bitset_t *bs, size_t begin, size_t end);
+
+/* Returns the number of set bits within `bs`. */
+size_t bitset_popcount(const bitset_t *bs);
+
+/*
+ * Returns the number of set bits within `[0, index)`. `index` is clamped to
+ * the size of `bs`.
+ */
+size_t bitset_rank(const bitset_t *bs, size_t index);
+
+/*
+ * Returns the index of the first set bit at or after `from`, or `BITSET_NPOS`
+ * if there is none.
+ */
+size_t bitset_find_next_set(const bitset_t *bs, size_t from);
+
+/*
+ * Computes `a & b`, `a | b`, `a ^ b` or `a & ~b` into `dst`. `dst` may be the
+ * same bitset as either operand.
+ *
+ * \return `true` upon success, or `false` if the three bitsets differ in size,
+ * in which case `dst` is unmodified.
+ */
+bool bitset_and(bitset_t *dst, const bitset_t *a, const bitset_t *b);
+bool bitset_or(bitset_t *dst, const bitset_t *a, const bitset_t *b);
+bool bitset_xor(bitset_t *dst, const bitset_t *a, const bitset_t *b);
+bool bitset_andnot(bitset_t *dst, const bitset_t *a, const bitset_t *b);
+
+#endif
@@ -0,0 +1,334 @@
+#include "lrucache.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../allocator/allocator.h"
+#include "../hashmap/hashmap.h"
+#include "../strext/strext.h"
+
+/* The fewest slots the index has. */
+#define MIN_INDEX_SLOTS ((size_t)8)
+
+typedef unsigned char byte_t;
+
+/*
+ * The start of every entry. The entry's value follows at `value_offset()`,
+ * then room for `max_key_len` bytes of key.
+ */
+typedef struct lru_entry {
+  uint32_t next; /* Toward the least recently used entry, or the next free. */
+  union {
+    uint32_t prev;       /* `CACHE_LRU`: toward the most recently used. */
+    uint32_t referenced; /* `CACHE_CLOCK`: whether used since the hand. */
+  };
+  uint32_t hash;
+  uint32_t key_len;
+} lru_entry;
+
+static size_t round_to_alignment(const size_t size, const size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+static size_t header_size(void) {
+  return round_to_alignment(sizeof(lru_cache_t), DEFAULT_ALIGNMENT);
+}
+
+static size_t value_offset(void) {
+  return round_to_alignment(sizeof(lru_entry), DEFAULT_ALIGNMENT);
+}
+
+static size_t allocation_size(const lru_cache_t *const cache) {
+  return header_size() + cache->capacity * cache->entry_size +
+         (cache->index_mask + 1) * sizeof(uint32_t);
+}
+
+static lru_entry *entry_at(const lru_cache_t *const cache,
+                           const uint32_t entry) {
+  return (lru_entry *)(cache->entries + (size_t)entry * cache->entry_size);
+}
+
+static void *entry_value(const lru_entry *const entry) {
+  return (byte_t *)entry + value_offset();
+}
+
+static byte_t *entry_key(const lru_cache_t *const cache,
+                         const lru_entry *const entry) {
+  return (byte_t *)entry + value_offset() + cache->value_size;
+}
+
+static uint32_t hash_key(const void *const key, const size_t key_len) {
+  return (uint32_t)hash_bytes(key, key_len);
+}
+
+/* - INDEX - */
+
+/*
+ * Returns the slot of the index holding the entry for `key`, or the empty
+ * slot at which the probe for it ended. At most half of the slots are ever
+ * full, so every probe ends.
+ */
+static size_t find_slot(const lru_cache_t *const cache,
+                        const void *const key, const size_t key_len,
+                        const uint32_t hash) {
+  const size_t MASK = cache->index_mask;
+  for (size_t slot = hash & MASK;; slot = (slot + 1) & MASK) {
+    const uint32_t ENTRY = cache->index[slot];
+    if (ENTRY == CACHE_NO_ENTRY) return slot;
+    const lru_entry *const entry = entry_at(cache, ENTRY);
+    if (entry->hash == hash && entry->key_len == key_len &&
+        memcmp(entry_key(cache, entry), key, key_len) == 0)
+      return slot;
+  }
+}
+
+/* Returns the slot of the index holding `entry`, which must be indexed. */
+static size_t slot_of(const lru_cache_t *const cache, const uint32_t entry) {
+  const size_t MASK = cache->index_mask;
+  size_t slot = entry_at(cache, entry)->hash & MASK;
+  while (cache->index[slot] != entry) slot = (slot + 1) & MASK;
+  return slot;
+}
+
+/*
+ * Empties `slot` of the index, moving later entries of its probe run back
+ * into the gap so that no tombstones are left behind for probes to skip.
+ */
+static void clear_slot(lru_cache_t *const cache, size_t slot) {
+  const size_t MASK = cache->index_mask;
+  for (size_t next = (slot + 1) & MASK; cache->index[next] != CACHE_NO_ENTRY;
+       next = (next + 1) & MASK) {
+    const size_t HOME = entry_at(cache, cache->index[next])->hash & MASK;
+    /* The entry may move back only if the gap lies on its probe path. */
+    if (((next - HOME) & MASK) >= ((next - slot) & MASK)) {
+      cache->index[slot] = cache->index[next];
+      slot = next;
+    }
+  }
+  cache->index[slot] = CACHE_NO_ENTRY;
+}
+
+/* - RECENCY - */
+
+static void unlink_entry(lru_cache_t *const cache, const uint32_t entry) {
+  const lru_entry *const node = entry_at(cache, entry);
+  if (node->prev != CACHE_NO_ENTRY)
+    entry_at(cache, node->prev)->next = node->next;
+  else
+    cache->head = node->next;
+  if (node->next != CACHE_NO_ENTRY)
+    entry_at(cache, node->next)->prev = node->prev;
+  else
+    cache->tail = node->prev;
+}
+
+static void push_front(lru_cache_t *const cache, const uint32_t entry) {
+  lru_entry *const node = entry_at(cache, entry);
+  node->prev = CACHE_NO_ENTRY;
+  node->next = cache->head;
+  if (cache->head != CACHE_NO_ENTRY)
+    entry_at(cache, cache->head)->prev = entry;
+  else
+    cache->tail = entry;
+  cache->head = entry;
+}
+
+/* Marks `entry` as just used. */
+static void touch(lru_cache_t *const cache, const uint32_t entry) {
+  if (cache->policy == CACHE_CLOCK) {
+    entry_at(cache, entry)->referenced = 1;
+  } else if (cache->head != entry) {
+    unlink_entry(cache, entry);
+    push_front(cache, entry);
+  }
+}
+
+/* Returns the entry of the full `cache` which is to be evicted next. */
+static uint32_t choose_victim(lru_cache_t *const cache) {
+  if (cache->policy == CACHE_LRU) return cache->tail;
+  /* Every entry is in use, so the hand may visit each in turn. */
+  while (true) {
+    const uint32_t ENTRY = cache->hand;
+    lru_entry *const node = entry_at(cache, ENTRY);
+    cache->hand = (ENTRY + 1 == cache->capacity) ? 0 : ENTRY + 1;
+    if (!node->referenced) return ENTRY;
+    node->referenced = 0;
+  }
+}
+
+/* Unlinks and unindexes `entry` and returns it to the free list. */
+static void release_entry(lru_cache_t *const cache, const uint32_t entry) {
+  clear_slot(cache, slot_of(cache, entry));
+  if (cache->policy == CACHE_LRU) unlink_entry(cache, entry);
+  entry_at(cache, entry)->next = cache->free_list;
+  cache->free_list = entry;
+  cache->length--;
+}
+
+static void evict(lru_cache_t *const cache) {
+  const uint32_t VICTIM = choose_victim(cache);
+  if (cache->on_evict != NULL) {
+    const lru_entry *const node = entry_at(cache, VICTIM);
+    cache->on_evict(entry_key(cache, node), node->key_len, entry_value(node),
+                    cache->evict_ctx);
+  }
+  release_entry(cache, VICTIM);
+  cache->evictions++;
+}
+
+/* - CREATION AND DELETION - */
+
+lru_cache_t *new_lru_cache(const size_t capacity, const size_t max_key_len,
+                           const size_t value_size) {
+  return new_lru_cache_with(capacity, max_key_len, value_size, CACHE_LRU,
+                            NULL);
+}
+
+lru_cache_t *new_lru_cache_with(const size_t capacity,
+                                const size_t max_key_len,
+                                const size_t value_size,
+                                const cache_policy policy,
+                                const allocator_t *const allocator) {
+  if (capacity == 0 || capacity > CACHE_MAX_ENTRIES) return NULL;
+  if (max_key_len > UINT32_MAX || value_size > SIZE_MAX / 4 - max_key_len)
+    return NULL;
+  const size_t ENTRY_SIZE = round_to_alignment(
+      value_offset() + value_size + max_key_len, DEFAULT_ALIGNMENT);
+  size_t index_slots = MIN_INDEX_SLOTS;
+  while (index_slots < 2 * capacity) index_slots *= 2;
+  const size_t INDEX_SIZE = index_slots * sizeof(uint32_t);
+  if (capacity > (SIZE_MAX - header_size() - INDEX_SIZE) / ENTRY_SIZE)
+    return NULL;
+
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  const size_t SIZE = header_size() + capacity * ENTRY_SIZE + INDEX_SIZE;
+  lru_cache_t *const cache =
+      ALLOCATOR->alloc(ALLOCATOR->ctx, SIZE, DEFAULT_ALIGNMENT);
+  if (cache == NULL) return NULL;
+  cache->entries = (byte_t *)cache + header_size();
+  cache->index = (uint32_t *)(cache->entries + capacity * ENTRY_SIZE);
+  cache->capacity = capacity;
+  cache->index_mask = index_slots - 1;
+  cache->max_key_len = max_key_len;
+  cache->value_size = value_size;
+  cache->entry_size = ENTRY_SIZE;
+  cache->policy = policy;
+  cache->on_evict = NULL;
+  cache->evict_ctx = NULL;
+  cache->hits = cache->misses = cache->evictions = 0;
+  cache->allocator = ALLOCATOR;
+  clear_lru_cache(cache);
+  return cache;
+}
+
+void _delete_lru_cache(lru_cache_t **const cache) {
+  const allocator_t *const ALLOCATOR = (*cache)->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, *cache, allocation_size(*cache),
+                  DEFAULT_ALIGNMENT);
+  *cache = NULL;
+}
+
+void lru_cache_on_evict(lru_cache_t *const cache,
+                        const cache_evict_t on_evict, void *const ctx) {
+  cache->on_evict = on_evict;
+  cache->evict_ctx = ctx;
+}
+
+void clear_lru_cache(lru_cache_t *const cache) {
+  /* Every byte of `CACHE_NO_ENTRY` is 0xFF. */
+  memset(cache->index, 0xFF, (cache->index_mask + 1) * sizeof(uint32_t));
+  for (size_t i = 0; i < cache->capacity; i++) {
+    entry_at(cache, (uint32_t)i)->next =
+        (i + 1 < cache->capacity) ? (uint32_t)(i + 1) : CACHE_NO_ENTRY;
+  }
+  cache->free_list = 0;
+  cache->head = cache->tail = CACHE_NO_ENTRY;
+  cache->hand = 0;
+  cache->length = 0;
+}
+
+/* - LOOKUP AND INSERTION - */
+
+void *lru_cache_get(lru_cache_t *const cache, const void *const key,
+                    const size_t key_len) {
+  const uint32_t ENTRY =
+      cache->index[find_slot(cache, key, key_len, hash_key(key, key_len))];
+  if (ENTRY == CACHE_NO_ENTRY) {
+    cache->misses++;
+    return NULL;
+  }
+  cache->hits++;
+  touch(cache, ENTRY);
+  return entry_value(entry_at(cache, ENTRY));
+}
+
+void *lru_cache_peek(const lru_cache_t *const cache, const void *const key,
+                     const size_t key_len) {
+  const uint32_t ENTRY =
+      cache->index[find_slot(cache, key, key_len, hash_key(key, key_len))];
+  return (ENTRY != CACHE_NO_ENTRY) ? entry_value(entry_at(cache, ENTRY))
+                                   : NULL;
+}
+
+void *lru_cache_put(lru_cache_t *const cache, const void *const key,
+                    const size_t key_len, const void *const value) {
+  if (key_len > cache->max_key_len) return NULL;
+  const uint32_t HASH = hash_key(key, key_len);
+  size_t slot = find_slot(cache, key, key_len, HASH);
+  if (cache->index[slot] != CACHE_NO_ENTRY) {
+    const uint32_t ENTRY = cache->index[slot];
+    touch(cache, ENTRY);
+    return memcpy(entry_value(entry_at(cache, ENTRY)), value,
+                  cache->value_size);
+  }
+  if (cache->length == cache->capacity) {
+    evict(cache);
+    /* Evicting may have moved entries back into the slot found. */
+    slot = find_slot(cache, key, key_len, HASH);
+  }
+
+  const uint32_t ENTRY = cache->free_list;
+  lru_entry *const node = entry_at(cache, ENTRY);
+  cache->free_list = node->next;
+  node->hash = HASH;
+  node->key_len = (uint32_t)key_len;
+  memcpy(entry_key(cache, node), key, key_len);
+  if (cache->policy == CACHE_CLOCK)
+    node->referenced = 0;
+  else
+    push_front(cache, ENTRY);
+  cache->index[slot] = ENTRY;
+  cache->length++;
+  return memcpy(entry_value(node), value, cache->value_size);
+}
+
+bool lru_cache_erase(lru_cache_t *const cache, const void *const key,
+                     const size_t key_len) {
+  const uint32_t ENTRY =
+      cache->index[find_slot(cache, key, key_len, hash_key(key, key_len))];
+  if (ENTRY == CACHE_NO_ENTRY) return false;
+  release_entry(cache, ENTRY);
+  return true;
+}
+
+/* - STRING KEYS - */
+
+void *lru_cache_get_str(lru_cache_t *const cache, const string_t *const key) {
+  return lru_cache_get(cache, key->data, key->length);
+}
+
+void *lru_cache_peek_str(const lru_cache_t *const cache,
+                         const string_t *const key) {
+  return lru_cache_peek(cache, key->data, key->length);
+}
+
+void *lru_cache_put_str(lru_cache_t *const cache, const string_t *const key,
+                        const void *const value) {
+  return lru_cache_put(cache, key->data, key->length, value);
+}
+
+bool lru_cache_erase_str(lru_cache_t *const cache, const string_t *const key) {
+  return lru_cache_erase(cache, key->data, key->length);
+}
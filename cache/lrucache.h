@@ -0,0 +1,159 @@
+#ifndef LRUCACHE_H
+#define LRUCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../allocator/allocator.h"
+#include "../strext/strext.h"
+
+/* Marks the end of an entry list and an empty slot of the index. */
+#define CACHE_NO_ENTRY (UINT32_MAX)
+
+/* The greatest number of entries a cache may hold. */
+#define CACHE_MAX_ENTRIES ((size_t)UINT32_MAX / 2)
+
+#define delete_lru_cache(cache) _delete_lru_cache(&(cache))
+
+/* How a full cache chooses the entry to evict. */
+typedef enum cache_policy {
+  /* The least recently used entry. Every hit moves its entry to the front. */
+  CACHE_LRU,
+  /*
+   * An approximation of LRU: a hit only marks its entry, and a hand sweeping
+   * the entries evicts the first unmarked one, clearing marks as it passes.
+   * Hits write one byte instead of relinking the list.
+   */
+  CACHE_CLOCK
+} cache_policy;
+
+/*
+ * Receives each entry a full cache evicts, along with the `ctx` given to
+ * `lru_cache_on_evict()`. The key is not null-terminated.
+ */
+typedef void (*cache_evict_t)(const void *key, size_t key_len, void *value,
+                              void *ctx);
+
+/*
+ * A cache of at most `capacity` entries, each a key of up to `max_key_len`
+ * bytes and a `value_size`-byte value, which evicts an entry to make room
+ * once full.
+ *
+ * Entries are fixed-size records in one array, linked into a recency list by
+ * 32-bit indices rather than pointers, and found through an open-addressing
+ * index of entry numbers placed after them. Both are sized once, at creation,
+ * along with the header, so a cache never allocates again and its memory use
+ * is known up front. Keys are stored inline in their entries.
+ *
+ * Pointers to values are invalidated by any later insertion, which may evict
+ * their entry.
+ */
+typedef struct lru_cache_t {
+  unsigned char *entries;
+  uint32_t *index;
+  size_t capacity;
+  size_t index_mask; /* The index has `index_mask + 1` slots. */
+  size_t length;
+  size_t max_key_len;
+  size_t value_size;
+  size_t entry_size;
+  uint32_t head; /* The most recently used entry. */
+  uint32_t tail; /* The least recently used entry. */
+  uint32_t free_list;
+  uint32_t hand; /* The next entry `CACHE_CLOCK` considers evicting. */
+  cache_policy policy;
+  cache_evict_t on_evict;
+  void *evict_ctx;
+  size_t hits;      /* Lookups by `lru_cache_get()` which found their key. */
+  size_t misses;    /* Lookups by `lru_cache_get()` which did not. */
+  size_t evictions; /* Entries evicted to make room for others. */
+  const allocator_t *allocator;
+} lru_cache_t;
+
+/*
+ * Creates an empty LRU cache of at most `capacity` entries with keys of up to
+ * `max_key_len` bytes and `value_size`-byte values.
+ *
+ * \return A pointer to the new cache or `NULL` upon failure or if `capacity`
+ * is zero or exceeds `CACHE_MAX_ENTRIES`.
+ */
+lru_cache_t *new_lru_cache(size_t capacity, size_t max_key_len,
+                           size_t value_size);
+
+/*
+ * Same as `new_lru_cache()`, except entries are evicted by `policy` and the
+ * cache's memory is obtained from and returned to `allocator`, or the default
+ * allocator if it is `NULL`.
+ */
+lru_cache_t *new_lru_cache_with(size_t capacity, size_t max_key_len,
+                                size_t value_size, cache_policy policy,
+                                const allocator_t *allocator);
+
+/*
+ * Frees the memory used by `cache` and invalidates the passed pointer. The
+ * eviction callback is not called.
+ */
+void _delete_lru_cache(lru_cache_t **cache);
+
+/*
+ * Has `cache` pass each entry it evicts to `on_evict` with `ctx`, or stops
+ * it doing so if `on_evict` is `NULL`.
+ */
+void lru_cache_on_evict(lru_cache_t *cache, cache_evict_t on_evict,
+                        void *ctx);
+
+/*
+ * Removes every entry from `cache` without calling the eviction callback. The
+ * counters are kept.
+ */
+void clear_lru_cache(lru_cache_t *cache);
+
+/*
+ * Looks up the `key_len` bytes of `key`, marking its entry as just used and
+ * counting a hit or a miss.
+ *
+ * \return A pointer to the key's value or `NULL` if it is not cached.
+ */
+void *lru_cache_get(lru_cache_t *cache, const void *key, size_t key_len);
+
+/*
+ * Same as `lru_cache_get()`, except the entry's recency and the counters are
+ * left as they are.
+ */
+void *lru_cache_peek(const lru_cache_t *cache, const void *key,
+                     size_t key_len);
+
+/*
+ * Caches a copy of `value` for the `key_len` bytes of `key`, replacing any
+ * value the key already had and marking its entry as just used. If the cache
+ * is full and the key is new, an entry is evicted first.
+ *
+ * \return A pointer to the stored value or `NULL` if `key_len` exceeds the
+ * cache's `max_key_len`.
+ */
+void *lru_cache_put(lru_cache_t *cache, const void *key, size_t key_len,
+                    const void *value);
+
+/*
+ * Removes the `key_len` bytes of `key` from `cache` without calling the
+ * eviction callback.
+ *
+ * \return `true` if the key was removed or `false` if it was not cached.
+ */
+bool lru_cache_erase(lru_cache_t *cache, const void *key, size_t key_len);
+
+/* Same as `lru_cache_get()`, but keyed by the characters of `key`. */
+void *lru_cache_get_str(lru_cache_t *cache, const string_t *key);
+
+/* Same as `lru_cache_peek()`, but keyed by the characters of `key`. */
+void *lru_cache_peek_str(const lru_cache_t *cache, const string_t *key);
+
+/* Same as `lru_cache_put()`, but keyed by the characters of `key`. */
+void *lru_cache_put_str(lru_cache_t *cache, const string_t *key,
+                        const void *value);
+
+/* Same as `lru_cache_erase()`, but keyed by the characters of `key`. */
+bool lru_cache_erase_str(lru_cache_t *cache, const string_t *key);
+
+#endif
@@ -0,0 +1,65 @@
+#include "dispatch.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS (1)
+#else
+#define HAVE_X86_KERNELS (0)
+#endif
+
+/* Negative until the level has been chosen. */
+static atomic_int current_level = -1;
+
+static const char *const LEVEL_NAMES[SIMD_LEVEL_COUNT] = {"scalar", "sse2",
+                                                          "avx2", "avx512"};
+
+simd_level get_supported_simd_level(void) {
+#if HAVE_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+    return SIMD_AVX512;
+  if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+  if (__builtin_cpu_supports("sse2")) return SIMD_SSE2;
+#endif
+  return SIMD_SCALAR;
+}
+
+/* Applies `MYCLIB_SIMD` to the detected level. Unknown values are ignored. */
+static simd_level initial_level(void) {
+  const simd_level SUPPORTED = get_supported_simd_level();
+  const char *const OVERRIDE = getenv(SIMD_LEVEL_ENV);
+  if (OVERRIDE == NULL) return SUPPORTED;
+  for (int level = 0; level < SIMD_LEVEL_COUNT; level++) {
+    if (strcmp(OVERRIDE, LEVEL_NAMES[level]) == 0)
+      return ((simd_level)level < SUPPORTED) ? (simd_level)level : SUPPORTED;
+  }
+  return SUPPORTED;
+}
+
+simd_level get_simd_level(void) {
+  int level = atomic_load_explicit(&current_level, memory_order_relaxed);
+  if (level < 0) {
+    /* Racing threads compute the same level, so the first store wins. */
+    int expected = -1;
+    level = (int)initial_level();
+    if (!atomic_compare_exchange_strong(&current_level, &expected, level))
+      level = expected;
+  }
+  return (simd_level)level;
+}
+
+simd_level set_simd_level(simd_level level) {
+  const simd_level SUPPORTED = get_supported_simd_level();
+  if (level > SUPPORTED) level = SUPPORTED;
+  atomic_store(&current_level, (int)level);
+  return level;
+}
+
+const char *simd_level_name(const simd_level level) {
+  if (level >= SIMD_LEVEL_COUNT) return "unknown";
+  return LEVEL_NAMES[level];
+}
@@ -0,0 +1,42 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+/* The environment variable which overrides the detected instruction set. */
+#define SIMD_LEVEL_ENV "MYCLIB_SIMD"
+
+/*
+ * The instruction sets for which vectorized kernels are built, from least to
+ * most capable. Each level implies the ones below it.
+ */
+typedef enum simd_level {
+  SIMD_SCALAR,
+  SIMD_SSE2,
+  SIMD_AVX2,
+  SIMD_AVX512, /* AVX-512 F, BW, DQ and VL. */
+  SIMD_LEVEL_COUNT
+} simd_level;
+
+/*
+ * Returns the instruction set whose kernels are in use. On first use, this is
+ * the most capable set the CPU supports, lowered to the value of
+ * `MYCLIB_SIMD` (one of "scalar", "sse2", "avx2" or "avx512") if it is set.
+ * Kernels look this up on every call, so changing it takes effect at once.
+ */
+simd_level get_simd_level(void);
+
+/* Returns the most capable instruction set the CPU supports. */
+simd_level get_supported_simd_level(void);
+
+/*
+ * Selects the kernels for `level`, such as to benchmark each variant within
+ * one process. Levels the CPU does not support are lowered to the most
+ * capable one it does.
+ *
+ * \return The level now in use.
+ */
+simd_level set_simd_level(simd_level level);
+
+/* Returns the name of `level` as accepted by `MYCLIB_SIMD`. */
+const char *simd_level_name(simd_level level);
+
+#endif
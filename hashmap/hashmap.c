@@ -0,0 +1,425 @@
+#include "hashmap.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../hugealloc/hugealloc.h"
+#include "../strext/strext.h"
+
+/* Control byte values. Full slots store the low 7 bits of their hash. */
+#define CTRL_EMPTY ((signed char)-128)
+#define CTRL_DELETED ((signed char)-2)
+
+/* Hashes computed ahead of their insertion by `hashmap_insert_bulk()`. */
+#define PREFETCH_DISTANCE ((size_t)8)
+
+#if defined(__GNUC__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr) ((void)(addr))
+#endif
+
+#define NOT_FOUND SIZE_MAX
+
+typedef unsigned char byte_t;
+
+/* - GROUP MATCHING - */
+
+/* Returns a bitmask of the control bytes in `group` which equal `byte`. */
+static uint32_t match_byte(const signed char *const group,
+                           const signed char byte) {
+#ifdef __SSE2__
+  const __m128i CTRL = _mm_loadu_si128((const __m128i *)group);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(CTRL, _mm_set1_epi8(byte)));
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < HASHMAP_GROUP_WIDTH; i++)
+    mask |= (uint32_t)(group[i] == byte) << i;
+  return mask;
+#endif
+}
+
+/* Returns a bitmask of the slots in `group` which are empty or deleted. */
+static uint32_t match_free(const signed char *const group) {
+#ifdef __SSE2__
+  /* Only `CTRL_EMPTY` and `CTRL_DELETED` have their sign bit set. */
+  return (uint32_t)_mm_movemask_epi8(
+      _mm_loadu_si128((const __m128i *)group));
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < HASHMAP_GROUP_WIDTH; i++)
+    mask |= (uint32_t)(group[i] < 0) << i;
+  return mask;
+#endif
+}
+
+static unsigned lowest_bit(const uint32_t mask) {
+#if defined(__GNUC__)
+  return (unsigned)__builtin_ctz(mask);
+#else
+  unsigned i = 0;
+  while (!(mask & (1u << i))) i++;
+  return i;
+#endif
+}
+
+/* - HASHING - */
+
+/* MurmurHash64A, reading eight bytes at a time. */
+uint64_t hash_bytes(const void *const data, size_t len) {
+  const uint64_t M = 0xC6A4A7935BD1E995ULL;
+  const byte_t *bytes = data;
+  uint64_t hash = 0x9E3779B97F4A7C15ULL ^ (len * M);
+  for (; len >= 8; len -= 8, bytes += 8) {
+    uint64_t k;
+    memcpy(&k, bytes, sizeof(k));
+    k *= M;
+    k ^= k >> 47;
+    k *= M;
+    hash ^= k;
+    hash *= M;
+  }
+  if (len != 0) {
+    uint64_t k = 0;
+    memcpy(&k, bytes, len);
+    hash ^= k;
+    hash *= M;
+  }
+  hash ^= hash >> 47;
+  hash *= M;
+  hash ^= hash >> 47;
+  return hash;
+}
+
+static signed char hash_tag(const uint64_t hash) {
+  return (signed char)(hash & 0x7F);
+}
+
+static size_t first_group(const hashmap_t *const map, const uint64_t hash) {
+  return (size_t)(hash >> 7) & (map->capacity / HASHMAP_GROUP_WIDTH - 1);
+}
+
+/* - TABLE MANAGEMENT - */
+
+static size_t max_load(const size_t capacity) {
+  return capacity / HASHMAP_MAX_LOAD_DEN * HASHMAP_MAX_LOAD_NUM;
+}
+
+static size_t capacity_for(const size_t num_elems) {
+  size_t capacity = HASHMAP_GROUP_WIDTH;
+  while (max_load(capacity) < num_elems) capacity *= 2;
+  return capacity;
+}
+
+static size_t natural_alignment(const size_t size) {
+  const size_t LOWEST_BIT = size & (~size + 1);
+  return (LOWEST_BIT == 0 || LOWEST_BIT > 8) ? 8 : LOWEST_BIT;
+}
+
+static byte_t *slot_at(const hashmap_t *const map, const size_t index) {
+  return map->slots + index * map->slot_size;
+}
+
+static const string_t *slot_string(const hashmap_t *const map,
+                                   const size_t index) {
+  const string_t *str;
+  memcpy(&str, slot_at(map, index), sizeof(str));
+  return str;
+}
+
+static uint64_t slot_hash(const hashmap_t *const map, const size_t index) {
+  if (map->string_keys) {
+    const string_t *const str = slot_string(map, index);
+    return hash_bytes(str->data, str->length);
+  }
+  return hash_bytes(slot_at(map, index), map->key_size);
+}
+
+/*
+ * Allocates a table of `capacity` slots, placing the slots after the control
+ * bytes, and marks every slot as empty.
+ */
+static bool alloc_table(hashmap_t *const map, const size_t capacity) {
+  signed char *const ctrl = huge_alloc(capacity + capacity * map->slot_size);
+  if (ctrl == NULL) return false;
+  memset(ctrl, CTRL_EMPTY, capacity);
+  map->ctrl = ctrl;
+  map->slots = (byte_t *)ctrl + capacity;
+  map->capacity = capacity;
+  map->growth_left = max_load(capacity) - map->length;
+  return true;
+}
+
+/* Returns the first empty or deleted slot on the probe sequence of `hash`. */
+static size_t find_free_slot(const hashmap_t *const map, const uint64_t hash) {
+  const size_t GROUP_MASK = map->capacity / HASHMAP_GROUP_WIDTH - 1;
+  size_t group = first_group(map, hash);
+  for (size_t step = 1;; step++) {
+    const size_t BASE = group * HASHMAP_GROUP_WIDTH;
+    const uint32_t FREE = match_free(map->ctrl + BASE);
+    if (FREE != 0) return BASE + lowest_bit(FREE);
+    /* Triangular probing visits every group of a power-of-two table. */
+    group = (group + step) & GROUP_MASK;
+  }
+}
+
+/*
+ * Moves every element into a new table of `capacity` slots, discarding the
+ * deleted markers left behind by erasures.
+ */
+static bool rebuild(hashmap_t *const map, const size_t capacity) {
+  hashmap_t old = *map;
+  if (!alloc_table(map, capacity)) return false;
+  for (size_t i = 0; i < old.capacity; i++) {
+    if (old.ctrl[i] < 0) continue;
+    const uint64_t HASH = slot_hash(&old, i);
+    const size_t DST = find_free_slot(map, HASH);
+    map->ctrl[DST] = hash_tag(HASH);
+    memcpy(slot_at(map, DST), slot_at(&old, i), map->slot_size);
+  }
+  huge_free(old.ctrl);
+  return true;
+}
+
+static bool keys_equal(const hashmap_t *const map, const size_t index,
+                       const void *const key, const size_t key_len) {
+  if (map->string_keys) {
+    const string_t *const str = slot_string(map, index);
+    return str->length == key_len && memcmp(str->data, key, key_len) == 0;
+  }
+  return memcmp(slot_at(map, index), key, key_len) == 0;
+}
+
+static size_t find_index(const hashmap_t *const map, const void *const key,
+                         const size_t key_len, const uint64_t hash) {
+  const size_t GROUP_MASK = map->capacity / HASHMAP_GROUP_WIDTH - 1;
+  const signed char TAG = hash_tag(hash);
+  size_t group = first_group(map, hash);
+  for (size_t step = 1; step <= GROUP_MASK + 1; step++) {
+    const size_t BASE = group * HASHMAP_GROUP_WIDTH;
+    const signed char *const ctrl = map->ctrl + BASE;
+    for (uint32_t match = match_byte(ctrl, TAG); match != 0;
+         match &= match - 1) {
+      const size_t INDEX = BASE + lowest_bit(match);
+      if (keys_equal(map, INDEX, key, key_len)) return INDEX;
+    }
+    /* An empty slot means no insertion ever probed past this group. */
+    if (match_byte(ctrl, CTRL_EMPTY) != 0) return NOT_FOUND;
+    group = (group + step) & GROUP_MASK;
+  }
+  return NOT_FOUND;
+}
+
+static void *insert_hashed(hashmap_t *const map, const void *const key,
+                           const size_t key_len, const uint64_t hash,
+                           const void *const value) {
+  size_t index = find_index(map, key, key_len, hash);
+  if (index == NOT_FOUND) {
+    index = find_free_slot(map, hash);
+    /* Reusing a deleted slot does not bring the table closer to rebuilding. */
+    if (map->ctrl[index] == CTRL_EMPTY && map->growth_left == 0) {
+      /* Grow unless most of the load is made up of deleted slots. */
+      const size_t CAPACITY = (map->length + 1 > max_load(map->capacity) / 2)
+                                  ? map->capacity * 2
+                                  : map->capacity;
+      if (!rebuild(map, CAPACITY)) return NULL;
+      index = find_free_slot(map, hash);
+    }
+    if (map->string_keys) {
+      string_t *const str = string_of_capacity(key_len + 1);
+      if (str == NULL) return NULL;
+      memcpy(str->data, key, key_len);
+      str->data[key_len] = '\0';
+      str->length = key_len;
+      memcpy(slot_at(map, index), &str, sizeof(str));
+    } else {
+      memcpy(slot_at(map, index), key, key_len);
+    }
+    if (map->ctrl[index] == CTRL_EMPTY) map->growth_left--;
+    map->ctrl[index] = hash_tag(hash);
+    map->length++;
+  }
+  byte_t *const value_slot = slot_at(map, index) + map->value_offset;
+  memcpy(value_slot, value, map->value_size);
+  return value_slot;
+}
+
+static bool erase_index(hashmap_t *const map, const size_t index) {
+  if (index == NOT_FOUND) return false;
+  if (map->string_keys) {
+    string_t *str = (string_t *)slot_string(map, index);
+    delete_string(str);
+  }
+  /*
+   * If the slot's group still has an empty slot, no probe sequence continues
+   * past this group, so the slot can be marked empty rather than deleted.
+   */
+  const size_t BASE = index & ~(HASHMAP_GROUP_WIDTH - 1);
+  if (match_byte(map->ctrl + BASE, CTRL_EMPTY) != 0) {
+    map->ctrl[index] = CTRL_EMPTY;
+    map->growth_left++;
+  } else {
+    map->ctrl[index] = CTRL_DELETED;
+  }
+  map->length--;
+  return true;
+}
+
+static hashmap_t *create_hashmap(const size_t key_size, const size_t value_size,
+                                 const size_t capacity,
+                                 const bool string_keys) {
+  hashmap_t *const map = malloc(sizeof(hashmap_t));
+  if (map == NULL) return NULL;
+  const size_t VALUE_ALIGNMENT = natural_alignment(value_size);
+  const size_t SLOT_ALIGNMENT = (natural_alignment(key_size) > VALUE_ALIGNMENT)
+                                    ? natural_alignment(key_size)
+                                    : VALUE_ALIGNMENT;
+  map->key_size = key_size;
+  map->value_size = value_size;
+  map->value_offset =
+      (key_size + VALUE_ALIGNMENT - 1) / VALUE_ALIGNMENT * VALUE_ALIGNMENT;
+  map->slot_size = (map->value_offset + value_size + SLOT_ALIGNMENT - 1) /
+                   SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+  map->string_keys = string_keys;
+  map->length = 0;
+  if (!alloc_table(map, capacity_for(capacity))) {
+    free(map);
+    return NULL;
+  }
+  return map;
+}
+
+/* - PUBLIC INTERFACE - */
+
+hashmap_t *new_hashmap(const size_t key_size, const size_t value_size,
+                       const size_t capacity) {
+  return create_hashmap(key_size, value_size, capacity, false);
+}
+
+hashmap_t *new_str_hashmap(const size_t value_size, const size_t capacity) {
+  return create_hashmap(sizeof(string_t *), value_size, capacity, true);
+}
+
+void _delete_hashmap(hashmap_t **const map) {
+  clear_hashmap(*map);
+  huge_free((*map)->ctrl);
+  free(*map);
+  *map = NULL;
+}
+
+void clear_hashmap(hashmap_t *const map) {
+  if (map->string_keys) {
+    for (size_t i = 0; i < map->capacity; i++) {
+      if (map->ctrl[i] < 0) continue;
+      string_t *str = (string_t *)slot_string(map, i);
+      delete_string(str);
+    }
+  }
+  memset(map->ctrl, CTRL_EMPTY, map->capacity);
+  map->length = 0;
+  map->growth_left = max_load(map->capacity);
+}
+
+bool hashmap_reserve(hashmap_t *const map, const size_t num_elems) {
+  const size_t CAPACITY = capacity_for(num_elems);
+  if (CAPACITY <= map->capacity) return true;
+  return rebuild(map, CAPACITY);
+}
+
+void *hashmap_insert(hashmap_t *const map, const void *const key,
+                     const void *const value) {
+  return insert_hashed(map, key, map->key_size,
+                       hash_bytes(key, map->key_size), value);
+}
+
+/* Returns the bytes and length of the `index`th key passed in bulk. */
+static const void *bulk_key(const hashmap_t *const map, const void *const keys,
+                            const size_t index, size_t *const key_len) {
+  if (map->string_keys) {
+    const string_t *const str = ((const string_t *const *)keys)[index];
+    *key_len = str->length;
+    return str->data;
+  }
+  *key_len = map->key_size;
+  return (const byte_t *)keys + index * map->key_size;
+}
+
+/* Hashes the `index`th key passed in bulk and prefetches its first group. */
+static uint64_t prefetch_bulk_key(const hashmap_t *const map,
+                                  const void *const keys, const size_t index) {
+  size_t key_len;
+  const void *const key = bulk_key(map, keys, index, &key_len);
+  const uint64_t HASH = hash_bytes(key, key_len);
+  PREFETCH(map->ctrl + first_group(map, HASH) * HASHMAP_GROUP_WIDTH);
+  return HASH;
+}
+
+size_t hashmap_insert_bulk(hashmap_t *const map, const void *const keys,
+                           const void *const values, const size_t num_elems) {
+  if (!hashmap_reserve(map, map->length + num_elems)) return 0;
+  /* Keys are hashed `PREFETCH_DISTANCE` ahead so their groups are cached. */
+  uint64_t hashes[PREFETCH_DISTANCE];
+  for (size_t i = 0; i < num_elems && i < PREFETCH_DISTANCE; i++)
+    hashes[i] = prefetch_bulk_key(map, keys, i);
+  for (size_t i = 0; i < num_elems; i++) {
+    const uint64_t HASH = hashes[i % PREFETCH_DISTANCE];
+    if (i + PREFETCH_DISTANCE < num_elems)
+      hashes[i % PREFETCH_DISTANCE] =
+          prefetch_bulk_key(map, keys, i + PREFETCH_DISTANCE);
+    size_t key_len;
+    const void *const key = bulk_key(map, keys, i, &key_len);
+    const void *const value = (const byte_t *)values + i * map->value_size;
+    if (insert_hashed(map, key, key_len, HASH, value) == NULL) return i;
+  }
+  return num_elems;
+}
+
+void *hashmap_find(const hashmap_t *const map, const void *const key) {
+  const size_t INDEX =
+      find_index(map, key, map->key_size, hash_bytes(key, map->key_size));
+  if (INDEX == NOT_FOUND) return NULL;
+  return slot_at(map, INDEX) + map->value_offset;
+}
+
+bool hashmap_erase(hashmap_t *const map, const void *const key) {
+  return erase_index(
+      map, find_index(map, key, map->key_size, hash_bytes(key, map->key_size)));
+}
+
+void *hashmap_insert_str(hashmap_t *const map, const string_t *const key,
+                         const void *const value) {
+  return insert_hashed(map, key->data, key->length,
+                       hash_bytes(key->data, key->length), value);
+}
+
+void *hashmap_find_str(const hashmap_t *const map, const string_t *const key) {
+  const size_t INDEX = find_index(map, key->data, key->length,
+                                  hash_bytes(key->data, key->length));
+  if (INDEX == NOT_FOUND) return NULL;
+  return slot_at(map, INDEX) + map->value_offset;
+}
+
+bool hashmap_erase_str(hashmap_t *const map, const string_t *const key) {
+  return erase_index(map, find_index(map, key->data, key->length,
+                                     hash_bytes(key->data, key->length)));
+}
+
+bool hashmap_next(const hashmap_t *const map, size_t *const iter,
+                  void **const key, void **const value) {
+  for (size_t i = *iter; i < map->capacity; i++) {
+    if (map->ctrl[i] < 0) continue;
+    *key = map->string_keys ? (void *)slot_string(map, i) : slot_at(map, i);
+    *value = slot_at(map, i) + map->value_offset;
+    *iter = i + 1;
+    return true;
+  }
+  *iter = map->capacity;
+  return false;
+}
@@ -0,0 +1,141 @@
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../strext/strext.h"
+
+/*
+ * The number of control bytes probed at once. Each slot has one control byte
+ * recording whether it is empty, deleted, or full along with 7 bits of the
+ * key's hash, so one SSE2 comparison filters a whole group of slots.
+ */
+#define HASHMAP_GROUP_WIDTH ((size_t)16)
+
+/*
+ * The maximum load factor is `HASHMAP_MAX_LOAD_NUM / HASHMAP_MAX_LOAD_DEN`,
+ * counting deleted slots as occupied.
+ */
+#define HASHMAP_MAX_LOAD_NUM ((size_t)7)
+#define HASHMAP_MAX_LOAD_DEN ((size_t)8)
+
+#define delete_hashmap(map) _delete_hashmap(&(map))
+
+/*
+ * An open-addressing hash map storing fixed-size keys and values inline.
+ * Pointers to keys and values are invalidated by any insertion which causes
+ * the table to grow or be rebuilt.
+ */
+typedef struct hashmap_t {
+  signed char *ctrl; /* One control byte per slot. */
+  unsigned char *slots;
+  size_t capacity; /* Number of slots; a power-of-two multiple of a group. */
+  size_t length;
+  size_t growth_left; /* Empty slots which may be filled before rebuilding. */
+  size_t key_size;
+  size_t value_size;
+  size_t value_offset; /* Offset of the value within a slot. */
+  size_t slot_size;
+  bool string_keys;
+} hashmap_t;
+
+/*
+ * Creates an empty map for keys of `key_size` bytes and values of `value_size`
+ * bytes with room for at least `capacity` elements. Keys are hashed and
+ * compared bytewise, so they must not contain uninitialized padding.
+ *
+ * \return A pointer to the new map or `NULL` upon failure.
+ */
+hashmap_t *new_hashmap(size_t key_size, size_t value_size, size_t capacity);
+
+/*
+ * Creates an empty map keyed by strings with values of `value_size` bytes and
+ * room for at least `capacity` elements. The map stores its own copy of every
+ * key, so only the `_str` functions may be used with it.
+ *
+ * \return A pointer to the new map or `NULL` upon failure.
+ */
+hashmap_t *new_str_hashmap(size_t value_size, size_t capacity);
+
+/*
+ * Frees the memory used by `map`, including any copied keys, and invalidates
+ * the passed pointer.
+ */
+void _delete_hashmap(hashmap_t **map);
+
+/* Removes every element from `map` without shrinking its table. */
+void clear_hashmap(hashmap_t *map);
+
+/*
+ * Grows the table of `map` so that it can hold `num_elems` elements without
+ * being rebuilt.
+ *
+ * \return `true` upon success or `false` if memory could not be allocated, in
+ * which case `map` is unmodified.
+ */
+bool hashmap_reserve(hashmap_t *map, size_t num_elems);
+
+/*
+ * Associates `value` with `key`, overwriting the value of an existing element.
+ *
+ * \return A pointer to the stored value or `NULL` upon failure.
+ */
+void *hashmap_insert(hashmap_t *map, const void *key, const void *value);
+
+/*
+ * Inserts `num_elems` elements, reading keys and values from the arrays `keys`
+ * and `values`. The table is grown once up front and probes are prefetched
+ * ahead of each insertion.
+ *
+ * \return The number of elements processed, which is less than `num_elems`
+ * only upon failure.
+ */
+size_t hashmap_insert_bulk(hashmap_t *map, const void *keys,
+                           const void *values, size_t num_elems);
+
+/*
+ * Returns the value associated with `key`.
+ *
+ * \return A pointer to the value or `NULL` if `key` is not present.
+ */
+void *hashmap_find(const hashmap_t *map, const void *key);
+
+/*
+ * Removes the element associated with `key`.
+ *
+ * \return `true` if an element was removed or `false` if `key` was not present.
+ */
+bool hashmap_erase(hashmap_t *map, const void *key);
+
+/* Same as `hashmap_insert()`, but for maps created by `new_str_hashmap()`. */
+void *hashmap_insert_str(hashmap_t *map, const string_t *key,
+                         const void *value);
+
+/* Same as `hashmap_find()`, but for maps created by `new_str_hashmap()`. */
+void *hashmap_find_str(const hashmap_t *map, const string_t *key);
+
+/* Same as `hashmap_erase()`, but for maps created by `new_str_hashmap()`. */
+bool hashmap_erase_str(hashmap_t *map, const string_t *key);
+
+/*
+ * Hashes the `len` bytes of `data` with the function maps use for their
+ * keys, for other tables keyed by bytes or strings.
+ */
+uint64_t hash_bytes(const void *data, size_t len);
+
+/*
+ * Advances `*iter`, which must be `0` before the first call, to the next
+ * element of `map` and retrieves pointers to its key and value. For maps
+ * created by `new_str_hashmap()`, `*key` is set to the map's `string_t`.
+ * Elements must not be inserted during iteration, but the current element may
+ * be erased.
+ *
+ * \return `true` if an element was retrieved or `false` once every element has
+ * been visited.
+ */
+bool hashmap_next(const hashmap_t *map, size_t *iter, void **key,
+                  void **value);
+
+#endif
@@ -0,0 +1,178 @@
+#include "heap.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "../array/array.h"
+#include "../hugealloc/hugealloc.h"
+
+#if defined(__GNUC__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr) ((void)(addr))
+#endif
+
+typedef unsigned char byte_t;
+
+/*
+ * One extra element is allocated past `capacity` to hold the element being
+ * sifted, letting it be moved once instead of swapped at every level.
+ */
+static size_t heap_bytes(const size_t capacity, const size_t elem_size) {
+  return sizeof(heap_t) + (capacity + 1) * elem_size;
+}
+
+static byte_t *elem_at(const heap_t *const heap, const size_t index) {
+  return (byte_t *)heap->data + index * heap->elem_size;
+}
+
+static byte_t *scratch(const heap_t *const heap) {
+  return elem_at(heap, heap->capacity);
+}
+
+static heap_t *resize_heap(heap_t *heap, const size_t new_capacity) {
+  heap = huge_realloc(heap, heap_bytes(new_capacity, heap->elem_size));
+  if (heap == NULL) return NULL;
+  heap->data = heap + 1; /* Increment past the heap header. */
+  heap->capacity = new_capacity;
+  return heap;
+}
+
+static void sift_up(const heap_t *const heap, size_t index) {
+  const size_t ELEM_SIZE = heap->elem_size;
+  byte_t *const hole = scratch(heap);
+  memcpy(hole, elem_at(heap, index), ELEM_SIZE);
+  while (index > 0) {
+    const size_t PARENT = (index - 1) >> heap->arity_shift;
+    if (heap->cmp(hole, elem_at(heap, PARENT)) >= 0) break;
+    memcpy(elem_at(heap, index), elem_at(heap, PARENT), ELEM_SIZE);
+    index = PARENT;
+  }
+  memcpy(elem_at(heap, index), hole, ELEM_SIZE);
+}
+
+static void sift_down(const heap_t *const heap, size_t index) {
+  const size_t ELEM_SIZE = heap->elem_size;
+  const size_t LENGTH = heap->length;
+  const size_t ARITY = (size_t)1 << heap->arity_shift;
+  byte_t *const hole = scratch(heap);
+  memcpy(hole, elem_at(heap, index), ELEM_SIZE);
+  while (true) {
+    const size_t FIRST_CHILD = (index << heap->arity_shift) + 1;
+    if (FIRST_CHILD >= LENGTH) break;
+    const size_t END =
+        (LENGTH - FIRST_CHILD < ARITY) ? LENGTH : FIRST_CHILD + ARITY;
+    size_t best = FIRST_CHILD;
+    for (size_t child = FIRST_CHILD + 1; child < END; child++)
+      if (heap->cmp(elem_at(heap, child), elem_at(heap, best)) < 0)
+        best = child;
+    if (heap->cmp(elem_at(heap, best), hole) >= 0) break;
+    /* Fetch the grandchildren while the move below is carried out. */
+    if ((best << heap->arity_shift) + 1 < LENGTH)
+      PREFETCH(elem_at(heap, (best << heap->arity_shift) + 1));
+    memcpy(elem_at(heap, index), elem_at(heap, best), ELEM_SIZE);
+    index = best;
+  }
+  memcpy(elem_at(heap, index), hole, ELEM_SIZE);
+}
+
+/* Arranges every element into heap order in O(n) time. */
+static void heapify(const heap_t *const heap) {
+  if (heap->length < 2) return;
+  const size_t LAST_PARENT = (heap->length - 2) >> heap->arity_shift;
+  for (size_t i = LAST_PARENT + 1; i > 0; i--) sift_down(heap, i - 1);
+}
+
+heap_t *new_heap(const size_t elem_size, const size_t arity,
+                 const size_t capacity, const heap_cmp_t cmp) {
+  if (arity < 2 || (arity & (arity - 1)) != 0) return NULL;
+  heap_t *const heap = huge_alloc(heap_bytes(capacity, elem_size));
+  if (heap == NULL) return NULL;
+  heap->data = heap + 1; /* Increment past the heap header. */
+  heap->length = 0;
+  heap->capacity = capacity;
+  heap->elem_size = elem_size;
+  heap->arity_shift = 0;
+  while (((size_t)1 << heap->arity_shift) < arity) heap->arity_shift++;
+  heap->cmp = cmp;
+  return heap;
+}
+
+heap_t *heap_from_array(const array_t *const arr, const size_t arity,
+                        const heap_cmp_t cmp) {
+  heap_t *const heap = new_heap(arr->elem_size, arity, arr->length, cmp);
+  if (heap == NULL) return NULL;
+  memcpy(heap->data, arr->data, arr->length * arr->elem_size);
+  heap->length = arr->length;
+  heapify(heap);
+  return heap;
+}
+
+void _delete_heap(heap_t **const heap) {
+  huge_free(*heap);
+  *heap = NULL;
+}
+
+void *heap_peek(const heap_t *const heap) {
+  if (heap->length == 0) return NULL;
+  return heap->data;
+}
+
+heap_t *heap_push(heap_t *heap, const void *const elem) {
+  if (heap->length == heap->capacity) {
+    const size_t NEW_CAPACITY =
+        (heap->capacity != 0) ? heap->capacity * HEAP_EXPANSION_FACTOR : 1;
+    heap = resize_heap(heap, NEW_CAPACITY);
+    if (heap == NULL) return NULL;
+  }
+  memcpy(elem_at(heap, heap->length), elem, heap->elem_size);
+  heap->length++;
+  sift_up(heap, heap->length - 1);
+  return heap;
+}
+
+heap_t *heap_push_n(heap_t *heap, const void *const elems,
+                    const size_t num_elems) {
+  const size_t NEW_LENGTH = heap->length + num_elems;
+  if (NEW_LENGTH > heap->capacity) {
+    size_t new_capacity = (heap->capacity != 0) ? heap->capacity : 1;
+    while (new_capacity < NEW_LENGTH) new_capacity *= HEAP_EXPANSION_FACTOR;
+    heap = resize_heap(heap, new_capacity);
+    if (heap == NULL) return NULL;
+  }
+  const size_t OLD_LENGTH = heap->length;
+  memcpy(elem_at(heap, OLD_LENGTH), elems, num_elems * heap->elem_size);
+  heap->length = NEW_LENGTH;
+  /*
+   * Sifting each element up costs O(k log n), whereas rebuilding costs O(n),
+   * so the rebuild wins once the batch is a sizeable fraction of the heap.
+   */
+  if (num_elems > OLD_LENGTH / 4) {
+    heapify(heap);
+  } else {
+    for (size_t i = OLD_LENGTH; i < NEW_LENGTH; i++) sift_up(heap, i);
+  }
+  return heap;
+}
+
+bool heap_pop(heap_t *const heap, void *const out) {
+  if (heap->length == 0) return false;
+  if (out != NULL) memcpy(out, heap->data, heap->elem_size);
+  heap->length--;
+  if (heap->length != 0) {
+    memcpy(heap->data, elem_at(heap, heap->length), heap->elem_size);
+    sift_down(heap, 0);
+  }
+  return true;
+}
+
+size_t heap_pop_n(heap_t *const heap, void *const out, const size_t num_elems) {
+  size_t popped = 0;
+  for (; popped < num_elems; popped++) {
+    byte_t *const dst =
+        (out != NULL) ? (byte_t *)out + popped * heap->elem_size : NULL;
+    if (!heap_pop(heap, dst)) break;
+  }
+  return popped;
+}
@@ -0,0 +1,100 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../array/array.h"
+
+/* The factor by which a full heap scales its capacity when expanding. */
+#define HEAP_EXPANSION_FACTOR (2)
+
+#define delete_heap(heap) _delete_heap(&(heap))
+
+/*
+ * Orders two elements, returning a negative value if `a` should leave the heap
+ * before `b`, a positive value if after, and zero if either order will do.
+ */
+typedef int (*heap_cmp_t)(const void *a, const void *b);
+
+/*
+ * A priority queue stored as an implicit d-ary tree: the children of the
+ * element at index `i` sit at indices `i * arity + 1` through
+ * `i * arity + arity`, so no links are stored at all. With an arity of 4 or 8,
+ * all children of a node usually share a cache line.
+ *
+ * Like `stack`, the header and the elements share one allocation.
+ */
+typedef struct heap_t {
+  void *data;
+  size_t length;
+  size_t capacity; /* In elements. */
+  size_t elem_size;
+  size_t arity_shift; /* log2 of the number of children per node. */
+  heap_cmp_t cmp;
+} heap_t;
+
+/*
+ * Creates an empty heap of `elem_size`-byte elements with room for `capacity`
+ * elements. `arity` must be a power of two no less than 2.
+ *
+ * \return A pointer to the new heap or `NULL` upon failure.
+ */
+heap_t *new_heap(size_t elem_size, size_t arity, size_t capacity,
+                 heap_cmp_t cmp);
+
+/*
+ * Creates a heap holding every element of `arr`, arranged in O(n) time by
+ * sifting down from the last parent to the root.
+ *
+ * \return A pointer to the new heap or `NULL` upon failure.
+ */
+heap_t *heap_from_array(const array_t *arr, size_t arity, heap_cmp_t cmp);
+
+/*
+ * Frees the memory used by `heap` and invalidates the passed pointer.
+ */
+void _delete_heap(heap_t **heap);
+
+/*
+ * Returns the element which would be popped next without removing it.
+ *
+ * \return A pointer to the top element, or `NULL` if `heap` is empty.
+ */
+void *heap_peek(const heap_t *heap);
+
+/*
+ * Adds `elem` to `heap`, expanding if necessary.
+ *
+ * \return A pointer associated with the contents of `heap` or `NULL` upon
+ * failure.
+ */
+heap_t *heap_push(heap_t *heap, const void *elem);
+
+/*
+ * Adds the `num_elems` elements of `elems` to `heap`, expanding at most once.
+ * When the batch is large relative to the heap, the whole heap is rebuilt in
+ * linear time instead of sifting each element up.
+ *
+ * \return A pointer associated with the contents of `heap` or `NULL` upon
+ * failure.
+ */
+heap_t *heap_push_n(heap_t *heap, const void *elems, size_t num_elems);
+
+/*
+ * Removes the top element of `heap`, copying it into `out` unless `out` is
+ * `NULL`.
+ *
+ * \return `true` if an element was removed, or `false` if `heap` was empty.
+ */
+bool heap_pop(heap_t *heap, void *out);
+
+/*
+ * Removes up to `num_elems` elements from `heap` in order, copying them into
+ * consecutive slots of `out` unless `out` is `NULL`.
+ *
+ * \return The number of elements removed.
+ */
+size_t heap_pop_n(heap_t *heap, void *out, size_t num_elems);
+
+#endif
@@ -0,0 +1,124 @@
+#define _GNU_SOURCE
+#include "hugealloc.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ * Precedes every block so `huge_realloc()` and `huge_free()` know how the
+ * block was obtained. The alignment keeps the user's memory suitably aligned
+ * for any object type.
+ */
+typedef struct alloc_header {
+  _Alignas(max_align_t) size_t mapping; /* Bytes mapped, or 0 for `malloc()`. */
+  size_t size;                          /* Bytes requested by the user. */
+} alloc_header;
+
+static atomic_size_t threshold = HUGE_ALLOC_THRESHOLD;
+
+static size_t round_up(const size_t size, const size_t multiple) {
+  return (size + multiple - 1) / multiple * multiple;
+}
+
+/*
+ * Every thread that finds the cache empty stores the same value, so relaxed
+ * accesses suffice.
+ */
+static size_t page_size(void) {
+  static atomic_size_t cached_page_size = 0;
+  size_t size = atomic_load_explicit(&cached_page_size, memory_order_relaxed);
+  if (size == 0) {
+    size = (size_t)sysconf(_SC_PAGESIZE);
+    atomic_store_explicit(&cached_page_size, size, memory_order_relaxed);
+  }
+  return size;
+}
+
+/*
+ * Maps at least `bytes` bytes starting on a `HUGE_PAGE_SIZE` boundary by
+ * over-mapping and trimming the excess on both sides.
+ */
+static alloc_header *map_block(const size_t bytes) {
+  const size_t MAPPING = round_up(bytes, page_size());
+  unsigned char *const raw =
+      mmap(NULL, MAPPING + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) return NULL;
+  unsigned char *const aligned =
+      (unsigned char *)round_up((uintptr_t)raw, HUGE_PAGE_SIZE);
+  const size_t HEAD = (size_t)(aligned - raw);
+  if (HEAD != 0) munmap(raw, HEAD);
+  munmap(aligned + MAPPING, HUGE_PAGE_SIZE - HEAD);
+
+  /* Transparent huge pages are only advisory; failure is not an error. */
+  madvise(aligned, MAPPING, MADV_HUGEPAGE);
+  alloc_header *const header = (alloc_header *)aligned;
+  header->mapping = MAPPING;
+  return header;
+}
+
+void set_huge_alloc_threshold(const size_t new_threshold) {
+  atomic_store_explicit(&threshold, new_threshold, memory_order_relaxed);
+}
+
+size_t get_huge_alloc_threshold(void) {
+  return atomic_load_explicit(&threshold, memory_order_relaxed);
+}
+
+void *huge_alloc(const size_t size) {
+  const size_t TOTAL = size + sizeof(alloc_header);
+  alloc_header *header;
+  if (size >= get_huge_alloc_threshold()) {
+    header = map_block(TOTAL);
+  } else {
+    header = malloc(TOTAL);
+    if (header != NULL) header->mapping = 0;
+  }
+  if (header == NULL) return NULL;
+  header->size = size;
+  return header + 1;
+}
+
+void *huge_realloc(void *const ptr, const size_t new_size) {
+  if (ptr == NULL) return huge_alloc(new_size);
+  alloc_header *header = (alloc_header *)ptr - 1;
+  const size_t TOTAL = new_size + sizeof(alloc_header);
+
+  if (header->mapping != 0) {
+    const size_t MAPPING = round_up(TOTAL, page_size());
+    if (MAPPING != header->mapping) {
+      void *const remapped =
+          mremap(header, header->mapping, MAPPING, MREMAP_MAYMOVE);
+      if (remapped == MAP_FAILED) return NULL;
+      header = remapped;
+      header->mapping = MAPPING;
+      madvise(header, MAPPING, MADV_HUGEPAGE);
+    }
+  } else if (new_size >= get_huge_alloc_threshold()) {
+    alloc_header *const mapped = map_block(TOTAL);
+    if (mapped == NULL) return NULL;
+    const size_t KEPT = (header->size < new_size) ? header->size : new_size;
+    memcpy(mapped + 1, ptr, KEPT);
+    free(header);
+    header = mapped;
+  } else {
+    header = realloc(header, TOTAL);
+    if (header == NULL) return NULL;
+  }
+  header->size = new_size;
+  return header + 1;
+}
+
+void huge_free(void *const ptr) {
+  if (ptr == NULL) return;
+  alloc_header *const header = (alloc_header *)ptr - 1;
+  if (header->mapping != 0)
+    munmap(header, header->mapping);
+  else
+    free(header);
+}
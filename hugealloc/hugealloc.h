@@ -0,0 +1,50 @@
+#ifndef HUGEALLOC_H
+#define HUGEALLOC_H
+
+#include <stddef.h>
+
+/*
+ * The default size in bytes at or above which allocations are served by
+ * `mmap()` instead of `malloc()`. Can be changed at runtime with
+ * `set_huge_alloc_threshold()`.
+ */
+#define HUGE_ALLOC_THRESHOLD ((size_t)32 << 20)
+
+/* The boundary to which mappings are aligned so huge pages can back them. */
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+/*
+ * Sets the size in bytes at or above which allocations are mapped directly.
+ * Blocks which were already allocated keep their current backing.
+ */
+void set_huge_alloc_threshold(size_t threshold);
+
+/* Returns the current threshold for mapping allocations directly. */
+size_t get_huge_alloc_threshold(void);
+
+/*
+ * Allocates `size` bytes. Blocks below the threshold come from `malloc()`;
+ * blocks at or above it are mapped directly with `mmap()`, aligned to
+ * `HUGE_PAGE_SIZE` and advised to use transparent huge pages.
+ *
+ * \return A pointer to the block, aligned for any object type, or `NULL` upon
+ * failure.
+ * \note Blocks must only be passed to `huge_realloc()` and `huge_free()`.
+ */
+void *huge_alloc(size_t size);
+
+/*
+ * Resizes a block returned by `huge_alloc()` or `huge_realloc()` to `new_size`
+ * bytes. Mapped blocks are grown and shrunk with `mremap()`, so the kernel
+ * moves page table entries instead of copying the contents. A `malloc()`
+ * block which grows past the threshold is copied into a mapping once.
+ *
+ * \return A (possibly new) pointer to the block, or `NULL` upon failure in
+ * which case `ptr` is unmodified.
+ */
+void *huge_realloc(void *ptr, size_t new_size);
+
+/* Frees a block returned by `huge_alloc()` or `huge_realloc()`. */
+void huge_free(void *ptr);
+
+#endif
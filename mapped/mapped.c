@@ -0,0 +1,285 @@
+#define _GNU_SOURCE
+#include "mapped.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "../allocator/allocator.h"
+#include "../array/array.h"
+#include "../vector/vector.h"
+
+typedef unsigned char byte_t;
+
+static size_t round_up(const size_t size, const size_t multiple) {
+  return (size + multiple - 1) / multiple * multiple;
+}
+
+/* Validates `alignment`, substituting the default for zero. */
+static bool normalize_alignment(size_t *const alignment) {
+  if (*alignment == 0) *alignment = DEFAULT_ALIGNMENT;
+  return (*alignment & (*alignment - 1)) == 0 &&
+         *alignment <= (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static uint64_t rotate_left(const uint64_t x, const unsigned bits) {
+  return (x << bits) | (x >> (64 - bits));
+}
+
+/*
+ * A fast, non-cryptographic checksum which mixes four words per step in
+ * independent lanes, so it runs at close to memory bandwidth.
+ */
+static uint64_t checksum(const byte_t *const bytes, const size_t size) {
+  const uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+  const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+  uint64_t lanes[4] = {PRIME_1, PRIME_2, ~PRIME_1, ~PRIME_2};
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    for (size_t l = 0; l < 4; l++) {
+      uint64_t word;
+      memcpy(&word, bytes + i + l * 8, sizeof(word));
+      lanes[l] = rotate_left(lanes[l] + word * PRIME_2, 31) * PRIME_1;
+    }
+  }
+  uint64_t hash = (uint64_t)size * PRIME_1 ^ lanes[0] ^
+                  rotate_left(lanes[1], 7) ^ rotate_left(lanes[2], 12) ^
+                  rotate_left(lanes[3], 18);
+  for (; i < size; i++) hash = (hash ^ bytes[i]) * PRIME_1;
+  hash ^= hash >> 33;
+  hash *= PRIME_2;
+  hash ^= hash >> 29;
+  return hash;
+}
+
+bool write_fully(const int fd, struct iovec *iov, int count) {
+  while (count > 0) {
+    const ssize_t WRITTEN = writev(fd, iov, count);
+    if (WRITTEN < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    size_t remaining = (size_t)WRITTEN;
+    while (count > 0 && remaining >= iov->iov_len) {
+      remaining -= iov->iov_len;
+      iov++;
+      count--;
+    }
+    if (count > 0) {
+      iov->iov_base = (byte_t *)iov->iov_base + remaining;
+      iov->iov_len -= remaining;
+    }
+  }
+  return true;
+}
+
+static bool save_mapped(const char *const path, const void *const data,
+                        const size_t elem_size, const size_t length,
+                        size_t alignment) {
+  if (!normalize_alignment(&alignment)) return false;
+  const size_t DATA_OFFSET = round_up(sizeof(mapped_header), alignment);
+  const size_t PAYLOAD = length * elem_size;
+  const mapped_header HEADER = {
+      MAPPED_MAGIC, MAPPED_VERSION, MAPPED_CHECKSUM_VALID,
+      elem_size,    length,         length,
+      alignment,    DATA_OFFSET,    checksum(data, PAYLOAD)};
+  byte_t *const padding = calloc(1, DATA_OFFSET - sizeof(HEADER) + 1);
+  if (padding == NULL) return false;
+  const int FD = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  if (FD < 0) {
+    free(padding);
+    return false;
+  }
+  /* The header, padding and elements go out in a single system call. */
+  struct iovec iov[3] = {{(void *)&HEADER, sizeof(HEADER)},
+                         {padding, DATA_OFFSET - sizeof(HEADER)},
+                         {(void *)data, PAYLOAD}};
+  const bool OK = write_fully(FD, iov, 3);
+  free(padding);
+  return (close(FD) == 0) && OK;
+}
+
+bool save_array_mapped(const char *const path, const array_t *const arr,
+                       const size_t alignment) {
+  return save_mapped(path, arr->data, arr->elem_size, arr->length, alignment);
+}
+
+bool save_vector_mapped(const char *const path, const vector_t *const vec,
+                        const size_t alignment) {
+  return save_mapped(path, vec->data, vec->elem_size, vec->length, alignment);
+}
+
+/* Points the `array_t` view of `arr` at its mapping. */
+static void update_view(mapped_array_t *const arr) {
+  const mapped_header *const HEADER = arr->header;
+  arr->array.data = (byte_t *)arr->header + HEADER->data_offset;
+  arr->array.capacity = HEADER->capacity * HEADER->elem_size;
+  arr->array.length = HEADER->length;
+  arr->array.elem_size = HEADER->elem_size;
+  arr->array.allocator = NULL;
+  arr->array.alignment = HEADER->alignment;
+}
+
+/* Maps all `size` bytes of `fd` and wraps the mapping in a handle. */
+static mapped_array_t *map_file(const int fd, const size_t size,
+                                const bool writable) {
+  mapped_array_t *const arr = malloc(sizeof(mapped_array_t));
+  if (arr == NULL) return NULL;
+  const int PROT = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *const mapping = mmap(NULL, size, PROT, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    free(arr);
+    return NULL;
+  }
+  arr->header = mapping;
+  arr->mapping_size = size;
+  arr->fd = fd;
+  arr->writable = writable;
+  return arr;
+}
+
+static void unmap_file(mapped_array_t *const arr) {
+  munmap(arr->header, arr->mapping_size);
+  close(arr->fd);
+  free(arr);
+}
+
+/*
+ * Whether a file of `capacity` elements of `elem_size` bytes after
+ * `data_offset` bytes of header has a size representable in a `size_t`.
+ */
+static bool fits_in_file(const size_t data_offset, const size_t capacity,
+                         const size_t elem_size) {
+  return elem_size == 0 || capacity <= (SIZE_MAX - data_offset) / elem_size;
+}
+
+mapped_array_t *create_mapped_array(const char *const path,
+                                    const size_t elem_size, size_t alignment,
+                                    const size_t capacity) {
+  if (!normalize_alignment(&alignment)) return NULL;
+  const size_t DATA_OFFSET = round_up(sizeof(mapped_header), alignment);
+  if (!fits_in_file(DATA_OFFSET, capacity, elem_size)) return NULL;
+  const size_t SIZE = DATA_OFFSET + capacity * elem_size;
+  const int FD = open(path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+  if (FD < 0) return NULL;
+  mapped_array_t *arr = NULL;
+  if (ftruncate(FD, (off_t)SIZE) == 0) arr = map_file(FD, SIZE, true);
+  if (arr == NULL) {
+    close(FD);
+    return NULL;
+  }
+  const mapped_header HEADER = {MAPPED_MAGIC, MAPPED_VERSION, 0, elem_size, 0,
+                                capacity,     alignment,      DATA_OFFSET, 0};
+  *arr->header = HEADER;
+  update_view(arr);
+  return arr;
+}
+
+/* Checks that `header` describes a file of `size` bytes this code can read. */
+static bool valid_header(const mapped_header *const header, const size_t size) {
+  if (header->magic != MAPPED_MAGIC || header->version != MAPPED_VERSION)
+    return false;
+  const uint64_t ALIGNMENT = header->alignment;
+  if (ALIGNMENT == 0 || (ALIGNMENT & (ALIGNMENT - 1)) != 0 ||
+      header->data_offset % ALIGNMENT != 0 ||
+      header->data_offset < sizeof(mapped_header) ||
+      header->data_offset > size || header->length > header->capacity)
+    return false;
+  /* Guard the size computation against overflow from a corrupt header. */
+  if (header->elem_size != 0 &&
+      header->capacity > (size - header->data_offset) / header->elem_size)
+    return false;
+  return true;
+}
+
+mapped_array_t *open_mapped_array(const char *const path, const int flags) {
+  const bool WRITABLE = (flags & MAPPED_WRITABLE) != 0;
+  const int FD = open(path, WRITABLE ? O_RDWR : O_RDONLY);
+  if (FD < 0) return NULL;
+  struct stat info;
+  mapped_array_t *arr = NULL;
+  if (fstat(FD, &info) == 0 && (size_t)info.st_size >= sizeof(mapped_header))
+    arr = map_file(FD, (size_t)info.st_size, WRITABLE);
+  if (arr == NULL) {
+    close(FD);
+    return NULL;
+  }
+  const mapped_header *const HEADER = arr->header;
+  bool ok = valid_header(HEADER, arr->mapping_size);
+  if (ok && (flags & MAPPED_VERIFY)) {
+    ok = (HEADER->flags & MAPPED_CHECKSUM_VALID) &&
+         checksum((const byte_t *)HEADER + HEADER->data_offset,
+                  HEADER->length * HEADER->elem_size) == HEADER->checksum;
+  }
+  if (!ok) {
+    unmap_file(arr);
+    return NULL;
+  }
+  /* The checksum goes stale with the first write until the next sync. */
+  if (WRITABLE) arr->header->flags &= ~MAPPED_CHECKSUM_VALID;
+  update_view(arr);
+  return arr;
+}
+
+bool mapped_array_sync(mapped_array_t *const arr) {
+  if (!arr->writable) return false;
+  mapped_header *const header = arr->header;
+  header->checksum =
+      checksum(arr->array.data, header->length * header->elem_size);
+  header->flags |= MAPPED_CHECKSUM_VALID;
+  return msync(arr->header, arr->mapping_size, MS_SYNC) == 0;
+}
+
+void _close_mapped_array(mapped_array_t **const arr) {
+  if ((*arr)->writable) mapped_array_sync(*arr);
+  unmap_file(*arr);
+  *arr = NULL;
+}
+
+bool mapped_array_reserve(mapped_array_t *const arr, const size_t capacity) {
+  if (!arr->writable) return false;
+  mapped_header *const header = arr->header;
+  if (capacity <= header->capacity) return true;
+  if (!fits_in_file(header->data_offset, capacity, header->elem_size))
+    return false;
+  const size_t NEW_SIZE = header->data_offset + capacity * header->elem_size;
+  if (ftruncate(arr->fd, (off_t)NEW_SIZE) != 0) return false;
+  /* The kernel moves the page tables rather than copying the contents. */
+  void *const mapping =
+      mremap(arr->header, arr->mapping_size, NEW_SIZE, MREMAP_MAYMOVE);
+  if (mapping == MAP_FAILED) return false;
+  arr->header = mapping;
+  arr->mapping_size = NEW_SIZE;
+  arr->header->capacity = capacity;
+  update_view(arr);
+  return true;
+}
+
+bool mapped_array_push_n(mapped_array_t *const arr, const void *const elems,
+                         const size_t num_elems) {
+  if (!arr->writable) return false;
+  const size_t NEW_LENGTH = arr->header->length + num_elems;
+  if (NEW_LENGTH > arr->header->capacity) {
+    size_t new_capacity = REALLOC_FACTOR * arr->header->capacity;
+    if (new_capacity < NEW_LENGTH) new_capacity = NEW_LENGTH;
+    if (!mapped_array_reserve(arr, new_capacity)) return false;
+  }
+  const size_t ELEM_SIZE = arr->header->elem_size;
+  memcpy((byte_t *)arr->array.data + arr->header->length * ELEM_SIZE, elems,
+         num_elems * ELEM_SIZE);
+  arr->header->length = NEW_LENGTH;
+  arr->array.length = NEW_LENGTH;
+  return true;
+}
+
+bool mapped_array_push(mapped_array_t *const arr, const void *const elem) {
+  return mapped_array_push_n(arr, elem, 1);
+}
@@ -0,0 +1,142 @@
+#ifndef MAPPED_H
+#define MAPPED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include "../array/array.h"
+#include "../vector/vector.h"
+
+/* Identifies a mapped array file; the bytes spell "MYCLIBMA". */
+#define MAPPED_MAGIC ((uint64_t)0x414D42494C43594DULL)
+
+/* Bumped whenever the layout of `mapped_header` changes. */
+#define MAPPED_VERSION (1)
+
+/* Flags for `open_mapped_array()`. */
+#define MAPPED_READ_ONLY (0)
+#define MAPPED_WRITABLE (1 << 0)
+#define MAPPED_VERIFY (1 << 1) /* Check the payload against its checksum. */
+
+#define close_mapped_array(arr) _close_mapped_array(&(arr))
+
+/*
+ * The header at the start of every mapped array file. Fields are stored in
+ * the byte order of the machine which wrote them, which the magic number
+ * catches if it differs. The elements start at `data_offset`, a multiple of
+ * `alignment`.
+ */
+typedef struct mapped_header {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t flags; /* `MAPPED_CHECKSUM_VALID` if `checksum` is current. */
+  uint64_t elem_size;
+  uint64_t length;
+  uint64_t capacity; /* The number of elements the file has room for. */
+  uint64_t alignment;
+  uint64_t data_offset;
+  uint64_t checksum; /* Of the `length * elem_size` bytes of elements. */
+} mapped_header;
+
+#define MAPPED_CHECKSUM_VALID (1u << 0)
+
+/*
+ * An array whose elements live in a file mapped into memory, so opening it
+ * costs the same regardless of its size and pages are only read once touched.
+ *
+ * `array` is a view of the elements which may be passed to any function
+ * taking a `const array_t *`, but must not be deleted, resized or outlive the
+ * mapped array. In writable mode, the array grows like a `vector_t` by
+ * extending the file and remapping it, which may move `array.data`.
+ */
+typedef struct mapped_array_t {
+  array_t array;
+  mapped_header *header; /* The start of the mapping. */
+  size_t mapping_size;
+  int fd;
+  bool writable;
+} mapped_array_t;
+
+/*
+ * Writes `arr` to a new file at `path`, replacing any existing file, with its
+ * elements aligned to `alignment` within the file, which must be a power of
+ * two no greater than the page size. Zero selects `DEFAULT_ALIGNMENT`.
+ *
+ * \return `true` upon success or `false` upon failure.
+ */
+bool save_array_mapped(const char *path, const array_t *arr, size_t alignment);
+
+/* Same as `save_array_mapped()`, but for a `vector_t`. */
+bool save_vector_mapped(const char *path, const vector_t *vec,
+                        size_t alignment);
+
+/*
+ * Creates an empty, writable mapped array of `elem_size`-byte elements at
+ * `path`, replacing any existing file, with room for `capacity` elements.
+ *
+ * \return A pointer to the mapped array or `NULL` upon failure or if
+ * `capacity` elements would not fit in a `size_t`-sized file, in which case
+ * any existing file is left as is.
+ */
+mapped_array_t *create_mapped_array(const char *path, size_t elem_size,
+                                    size_t alignment, size_t capacity);
+
+/*
+ * Maps the array saved at `path`. `flags` is `MAPPED_READ_ONLY` or
+ * `MAPPED_WRITABLE`, optionally combined with `MAPPED_VERIFY` to reject files
+ * whose elements do not match their checksum, which reads every element.
+ *
+ * \return A pointer to the mapped array or `NULL` if the file could not be
+ * mapped or is not a valid mapped array.
+ */
+mapped_array_t *open_mapped_array(const char *path, int flags);
+
+/*
+ * Unmaps `arr`, closes its file and invalidates the passed pointer. A
+ * writable array is synchronized first, as by `mapped_array_sync()`.
+ */
+void _close_mapped_array(mapped_array_t **arr);
+
+/*
+ * Ensures a writable `arr` has room for `capacity` elements, extending its
+ * file with `ftruncate()` and its mapping with `mremap()`.
+ *
+ * \return `true` upon success or `false` upon failure, if `arr` is read-only,
+ * or if `capacity` elements would not fit in a `size_t`-sized file.
+ */
+bool mapped_array_reserve(mapped_array_t *arr, size_t capacity);
+
+/*
+ * Appends the `num_elems` elements of `elems` to a writable `arr`, doubling
+ * its capacity as needed.
+ *
+ * \return `true` upon success or `false` upon failure or if `arr` is
+ * read-only.
+ */
+bool mapped_array_push_n(mapped_array_t *arr, const void *elems,
+                         size_t num_elems);
+
+/* Same as `mapped_array_push_n()` for a single element. */
+bool mapped_array_push(mapped_array_t *arr, const void *elem);
+
+/*
+ * Records the checksum of a writable `arr` in its header and flushes the
+ * mapping to its file.
+ *
+ * \return `true` upon success or `false` upon failure or if `arr` is
+ * read-only.
+ */
+bool mapped_array_sync(mapped_array_t *arr);
+
+/*
+ * Writes every buffer of `iov` to `fd`, retrying after partial writes and
+ * interruptions, for other modules saving files in parts. The entries of
+ * `iov` are advanced past what was written.
+ *
+ * \return `true` upon success or `false` upon failure.
+ */
+bool write_fully(int fd, struct iovec *iov, int count);
+
+#endif
@@ -0,0 +1,156 @@
+#include "pool.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "../allocator/allocator.h"
+
+typedef unsigned char byte_t;
+
+/* Precedes the blocks of each slab, linking the slabs for releasing. */
+typedef struct pool_slab {
+  _Alignas(max_align_t) struct pool_slab *next;
+  size_t size; /* In bytes, including this header. */
+} pool_slab;
+
+static void *next_free(void *const block) { return *(void **)block; }
+
+static void set_next_free(void *const block, void *const next) {
+  *(void **)block = next;
+}
+
+static void lock_pool(pool_t *const pool) {
+  while (atomic_flag_test_and_set_explicit(&pool->lock, memory_order_acquire))
+    ;
+}
+
+static void unlock_pool(pool_t *const pool) {
+  atomic_flag_clear_explicit(&pool->lock, memory_order_release);
+}
+
+/*
+ * Takes a block from the free list, the newest slab or a new slab, in that
+ * order. The caller must hold the lock.
+ */
+static void *take_block(pool_t *const pool) {
+  void *const block = pool->free_list;
+  if (block != NULL) {
+    pool->free_list = next_free(block);
+    return block;
+  }
+  if (pool->bump == pool->bump_end) {
+    const size_t SIZE =
+        sizeof(pool_slab) + pool->next_slab_blocks * pool->block_size;
+    pool_slab *const slab =
+        pool->allocator->alloc(pool->allocator->ctx, SIZE, DEFAULT_ALIGNMENT);
+    if (slab == NULL) return NULL;
+    slab->next = pool->slabs;
+    slab->size = SIZE;
+    pool->slabs = slab;
+    /* Blocks are only touched once they are handed out. */
+    pool->bump = (byte_t *)(slab + 1);
+    pool->bump_end = (byte_t *)slab + SIZE;
+    if (pool->next_slab_blocks < POOL_MAX_SLAB_BLOCKS)
+      pool->next_slab_blocks *= 2;
+  }
+  void *const fresh = pool->bump;
+  pool->bump += pool->block_size;
+  return fresh;
+}
+
+void pool_init(pool_t *const pool, const size_t block_size,
+               const allocator_t *const allocator) {
+  size_t size = (block_size < sizeof(void *)) ? sizeof(void *) : block_size;
+  size = (size + DEFAULT_ALIGNMENT - 1) / DEFAULT_ALIGNMENT * DEFAULT_ALIGNMENT;
+  pool->free_list = NULL;
+  pool->bump = pool->bump_end = NULL;
+  pool->slabs = NULL;
+  pool->block_size = size;
+  pool->next_slab_blocks = POOL_BASE_SLAB_BLOCKS;
+  pool->allocator = allocator_or_default(allocator);
+  atomic_flag_clear(&pool->lock);
+}
+
+void pool_release(pool_t *const pool) {
+  pool_slab *slab = pool->slabs;
+  while (slab != NULL) {
+    pool_slab *const next = slab->next;
+    pool->allocator->free(pool->allocator->ctx, slab, slab->size,
+                          DEFAULT_ALIGNMENT);
+    slab = next;
+  }
+  pool->free_list = NULL;
+  pool->bump = pool->bump_end = NULL;
+  pool->slabs = NULL;
+  pool->next_slab_blocks = POOL_BASE_SLAB_BLOCKS;
+}
+
+void *pool_alloc(pool_t *const pool) {
+  lock_pool(pool);
+  void *const block = take_block(pool);
+  unlock_pool(pool);
+  return block;
+}
+
+void pool_free(pool_t *const pool, void *const block) {
+  lock_pool(pool);
+  set_next_free(block, pool->free_list);
+  pool->free_list = block;
+  unlock_pool(pool);
+}
+
+/* - PER-THREAD CACHES - */
+
+void pool_cache_init(pool_cache *const cache, pool_t *const pool) {
+  cache->pool = pool;
+  cache->free_list = NULL;
+  cache->length = 0;
+}
+
+void *pool_cache_alloc(pool_cache *const cache) {
+  if (cache->free_list == NULL) {
+    pool_t *const pool = cache->pool;
+    lock_pool(pool);
+    for (size_t i = 0; i < POOL_CACHE_BATCH; i++) {
+      void *const block = take_block(pool);
+      if (block == NULL) break;
+      set_next_free(block, cache->free_list);
+      cache->free_list = block;
+      cache->length++;
+    }
+    unlock_pool(pool);
+    if (cache->free_list == NULL) return NULL;
+  }
+  void *const block = cache->free_list;
+  cache->free_list = next_free(block);
+  cache->length--;
+  return block;
+}
+
+/* Splices the first `count` blocks of `cache` onto its pool's free list. */
+static void return_blocks(pool_cache *const cache, const size_t count) {
+  if (count == 0) return;
+  void *const first = cache->free_list;
+  void *last = first;
+  for (size_t i = 1; i < count; i++) last = next_free(last);
+  cache->free_list = next_free(last);
+  cache->length -= count;
+  pool_t *const pool = cache->pool;
+  lock_pool(pool);
+  set_next_free(last, pool->free_list);
+  pool->free_list = first;
+  unlock_pool(pool);
+}
+
+void pool_cache_free(pool_cache *const cache, void *const block) {
+  set_next_free(block, cache->free_list);
+  cache->free_list = block;
+  cache->length++;
+  /* Keep one batch so alternating frees and allocations stay local. */
+  if (cache->length >= 2 * POOL_CACHE_BATCH)
+    return_blocks(cache, POOL_CACHE_BATCH);
+}
+
+void pool_cache_release(pool_cache *const cache) {
+  return_blocks(cache, cache->length);
+}
@@ -0,0 +1,97 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "../allocator/allocator.h"
+
+/* The number of blocks within a pool's first slab. Each further doubles. */
+#define POOL_BASE_SLAB_BLOCKS ((size_t)64)
+
+/* The number of blocks past which slabs stop doubling. */
+#define POOL_MAX_SLAB_BLOCKS ((size_t)1 << 16)
+
+/* The number of blocks a `pool_cache` moves to or from its pool at once. */
+#define POOL_CACHE_BATCH ((size_t)32)
+
+/*
+ * A source of fixed-size blocks, such as tree nodes.
+ *
+ * Blocks are carved out of slabs which are never moved or freed before the
+ * pool is released, so a block's address is stable. Freed blocks are kept on
+ * an intrusive free list (each free block stores the address of the next) and
+ * handed out again before any new slab is allocated, so steady-state use never
+ * reaches the underlying allocator.
+ *
+ * `pool_alloc()` and `pool_free()` may be called from any thread; they take
+ * a spinlock which is cheap when uncontended. Threads which allocate heavily
+ * should each use a `pool_cache` instead, which only touches the pool once per
+ * `POOL_CACHE_BATCH` blocks.
+ */
+typedef struct pool_t {
+  void *free_list;
+  unsigned char *bump;     /* The next never-used block of the newest slab. */
+  unsigned char *bump_end; /* The end of the newest slab. */
+  struct pool_slab *slabs;
+  size_t block_size;
+  size_t next_slab_blocks;
+  const allocator_t *allocator;
+  atomic_flag lock;
+} pool_t;
+
+/* A single thread's private stock of blocks taken from a `pool_t`. */
+typedef struct pool_cache {
+  pool_t *pool;
+  void *free_list;
+  size_t length; /* The number of blocks within `free_list`. */
+} pool_cache;
+
+/*
+ * Prepares `pool` to hand out blocks of `block_size` bytes, which is rounded
+ * up so every block is aligned for any object type. Slabs are obtained from
+ * `allocator`, or the default allocator if it is `NULL`, once the first block
+ * is requested.
+ */
+void pool_init(pool_t *pool, size_t block_size, const allocator_t *allocator);
+
+/*
+ * Frees every slab of `pool`, invalidating all of its blocks, and empties it.
+ * No `pool_cache` may still be using `pool`.
+ */
+void pool_release(pool_t *pool);
+
+/*
+ * Takes a block from `pool`.
+ *
+ * \return A pointer to the block or `NULL` if a slab could not be allocated.
+ */
+void *pool_alloc(pool_t *pool);
+
+/*
+ * Returns `block` to `pool`. `block` must hold at least `pool->block_size`
+ * bytes, be aligned for any object type and stay valid until `pool` is
+ * released; it need not have come from `pool_alloc()`.
+ */
+void pool_free(pool_t *pool, void *block);
+
+/* Prepares `cache` to take blocks from `pool` on behalf of one thread. */
+void pool_cache_init(pool_cache *cache, pool_t *pool);
+
+/*
+ * Same as `pool_alloc()`, but refills `cache` from its pool in batches.
+ *
+ * \return A pointer to the block or `NULL` if a slab could not be allocated.
+ */
+void *pool_cache_alloc(pool_cache *cache);
+
+/*
+ * Same as `pool_free()`, but keeps `block` in `cache` until enough blocks
+ * have accumulated to return a batch to the pool.
+ */
+void pool_cache_free(pool_cache *cache, void *block);
+
+/* Returns every block held by `cache` to its pool. */
+void pool_cache_release(pool_cache *cache);
+
+#endif
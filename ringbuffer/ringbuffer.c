@@ -0,0 +1,111 @@
+#include "ringbuffer.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned char byte_t;
+
+spsc_ring_t *new_spsc_ring(const size_t capacity, const size_t elem_size) {
+  size_t rounded = 1;
+  while (rounded < capacity) rounded *= 2;
+  /* `aligned_alloc()` requires the size to be a multiple of the alignment. */
+  const size_t BYTES = (sizeof(spsc_ring_t) + rounded * elem_size +
+                        CACHE_LINE_SIZE - 1) /
+                       CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+  spsc_ring_t *const ring = aligned_alloc(CACHE_LINE_SIZE, BYTES);
+  if (ring == NULL) return NULL;
+  ring->data = ring + 1; /* Increment past the ring header. */
+  ring->capacity = rounded;
+  ring->elem_size = elem_size;
+  atomic_init(&ring->head, 0);
+  ring->cached_tail = 0;
+  atomic_init(&ring->tail, 0);
+  ring->cached_head = 0;
+  return ring;
+}
+
+void _delete_spsc_ring(spsc_ring_t **const ring) {
+  free(*ring);
+  *ring = NULL;
+}
+
+/*
+ * Copies `count` elements between `buf` and the ring starting at the free
+ * running index `pos`, splitting the copy where the ring wraps around.
+ */
+static void copy_in(spsc_ring_t *const ring, const size_t pos,
+                    const byte_t *const buf, const size_t count) {
+  const size_t ELEM_SIZE = ring->elem_size;
+  const size_t OFFSET = pos & (ring->capacity - 1);
+  const size_t FIRST = (ring->capacity - OFFSET < count)
+                           ? ring->capacity - OFFSET
+                           : count;
+  memcpy((byte_t *)ring->data + OFFSET * ELEM_SIZE, buf, FIRST * ELEM_SIZE);
+  memcpy(ring->data, buf + FIRST * ELEM_SIZE, (count - FIRST) * ELEM_SIZE);
+}
+
+static void copy_out(const spsc_ring_t *const ring, const size_t pos,
+                     byte_t *const buf, const size_t count) {
+  const size_t ELEM_SIZE = ring->elem_size;
+  const size_t OFFSET = pos & (ring->capacity - 1);
+  const size_t FIRST = (ring->capacity - OFFSET < count)
+                           ? ring->capacity - OFFSET
+                           : count;
+  memcpy(buf, (byte_t *)ring->data + OFFSET * ELEM_SIZE, FIRST * ELEM_SIZE);
+  memcpy(buf + FIRST * ELEM_SIZE, ring->data, (count - FIRST) * ELEM_SIZE);
+}
+
+size_t spsc_enqueue_n(spsc_ring_t *const ring, const void *const elems,
+                      const size_t num_elems) {
+  const size_t TAIL =
+      atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  size_t free_slots = ring->capacity - (TAIL - ring->cached_head);
+  if (free_slots < num_elems) {
+    /* Only look at the consumer's cache line when the ring seems full. */
+    ring->cached_head =
+        atomic_load_explicit(&ring->head, memory_order_acquire);
+    free_slots = ring->capacity - (TAIL - ring->cached_head);
+  }
+  const size_t COUNT = (free_slots < num_elems) ? free_slots : num_elems;
+  if (COUNT == 0) return 0;
+  copy_in(ring, TAIL, elems, COUNT);
+  atomic_store_explicit(&ring->tail, TAIL + COUNT, memory_order_release);
+  return COUNT;
+}
+
+size_t spsc_dequeue_n(spsc_ring_t *const ring, void *const out,
+                      const size_t num_elems) {
+  const size_t HEAD =
+      atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t available = ring->cached_tail - HEAD;
+  if (available < num_elems) {
+    /* Only look at the producer's cache line when the ring seems empty. */
+    ring->cached_tail =
+        atomic_load_explicit(&ring->tail, memory_order_acquire);
+    available = ring->cached_tail - HEAD;
+  }
+  const size_t COUNT = (available < num_elems) ? available : num_elems;
+  if (COUNT == 0) return 0;
+  copy_out(ring, HEAD, out, COUNT);
+  atomic_store_explicit(&ring->head, HEAD + COUNT, memory_order_release);
+  return COUNT;
+}
+
+bool spsc_enqueue(spsc_ring_t *const ring, const void *const elem) {
+  return spsc_enqueue_n(ring, elem, 1) == 1;
+}
+
+bool spsc_dequeue(spsc_ring_t *const ring, void *const out) {
+  return spsc_dequeue_n(ring, out, 1) == 1;
+}
+
+size_t spsc_size(const spsc_ring_t *const ring) {
+  const size_t HEAD = atomic_load_explicit(
+      (atomic_size_t *)&ring->head, memory_order_acquire);
+  const size_t TAIL = atomic_load_explicit(
+      (atomic_size_t *)&ring->tail, memory_order_acquire);
+  return TAIL - HEAD;
+}
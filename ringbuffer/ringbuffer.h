@@ -0,0 +1,88 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* The assumed size in bytes of a cache line. */
+#define CACHE_LINE_SIZE (64)
+
+#define delete_spsc_ring(ring) _delete_spsc_ring(&(ring))
+
+/*
+ * A bounded, lock-free queue of `elem_size`-byte elements for exactly one
+ * producer thread and one consumer thread.
+ *
+ * `head` is only written by the consumer and `tail` only by the producer.
+ * Each lives on its own cache line together with that thread's cached copy
+ * of the other index, so the threads only touch each other's line when the
+ * cached copy says the ring looks full or empty.
+ */
+typedef struct spsc_ring_t {
+  /* Read-only after creation. */
+  _Alignas(CACHE_LINE_SIZE) void *data;
+  size_t capacity; /* In elements; always a power of two. */
+  size_t elem_size;
+  /* Owned by the consumer. */
+  _Alignas(CACHE_LINE_SIZE) atomic_size_t head;
+  size_t cached_tail;
+  /* Owned by the producer. */
+  _Alignas(CACHE_LINE_SIZE) atomic_size_t tail;
+  size_t cached_head;
+} spsc_ring_t;
+
+/*
+ * Creates an empty ring able to hold `capacity` elements of `elem_size`
+ * bytes, with `capacity` rounded up to the next power of two.
+ *
+ * \return A pointer to the new ring or `NULL` upon failure.
+ */
+spsc_ring_t *new_spsc_ring(size_t capacity, size_t elem_size);
+
+/*
+ * Frees the memory used by `ring` and invalidates the passed pointer. Neither
+ * thread may be using `ring` any longer.
+ */
+void _delete_spsc_ring(spsc_ring_t **ring);
+
+/*
+ * Copies `elem` into `ring`. Must only be called by the producer.
+ *
+ * \return `true` upon success or `false` if `ring` is full.
+ */
+bool spsc_enqueue(spsc_ring_t *ring, const void *elem);
+
+/*
+ * Moves the oldest element of `ring` into `out`. Must only be called by the
+ * consumer.
+ *
+ * \return `true` upon success or `false` if `ring` is empty.
+ */
+bool spsc_dequeue(spsc_ring_t *ring, void *out);
+
+/*
+ * Copies as many of the `num_elems` elements of `elems` into `ring` as fit,
+ * publishing them all with a single store. Must only be called by the
+ * producer.
+ *
+ * \return The number of elements enqueued.
+ */
+size_t spsc_enqueue_n(spsc_ring_t *ring, const void *elems, size_t num_elems);
+
+/*
+ * Moves up to `num_elems` of the oldest elements of `ring` into `out`,
+ * releasing their slots with a single store. Must only be called by the
+ * consumer.
+ *
+ * \return The number of elements dequeued.
+ */
+size_t spsc_dequeue_n(spsc_ring_t *ring, void *out, size_t num_elems);
+
+/*
+ * Returns the number of elements within `ring`. The value may already be
+ * stale when other threads are using `ring`.
+ */
+size_t spsc_size(const spsc_ring_t *ring);
+
+#endif
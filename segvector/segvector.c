@@ -0,0 +1,211 @@
+#include "segvector.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The number of directory entries allocated for a new `segvector_t`. */
+#define BASE_DIR_CAPACITY ((size_t)8)
+
+typedef unsigned char byte_t;
+
+static size_t chunk_len(const segvector_t *const sv) {
+  return (size_t)1 << sv->chunk_shift;
+}
+
+static size_t chunk_bytes(const segvector_t *const sv) {
+  return chunk_len(sv) * sv->elem_size;
+}
+
+/* Places `start` at the beginning of the middle directory entry. */
+static void recenter_start(segvector_t *const sv) {
+  sv->start = (sv->dir_capacity / 2) << sv->chunk_shift;
+}
+
+static void *alloc_chunk(segvector_t *const sv) {
+  void *const chunk = sv->spare;
+  if (chunk != NULL) {
+    sv->spare = NULL;
+    return chunk;
+  }
+  return malloc(chunk_bytes(sv));
+}
+
+static void release_chunk(segvector_t *const sv, const size_t dir_index) {
+  if (sv->spare == NULL)
+    sv->spare = sv->chunks[dir_index];
+  else
+    free(sv->chunks[dir_index]);
+  sv->chunks[dir_index] = NULL;
+}
+
+/*
+ * Moves the directory entries in use to the middle of the directory, doubling
+ * its capacity first if at least half of it is in use. Only chunk pointers are
+ * moved; the chunks themselves stay where they are.
+ *
+ * \return `true` upon success or `false` if the directory could not grow.
+ */
+static bool make_directory_room(segvector_t *const sv) {
+  const size_t FIRST = sv->start >> sv->chunk_shift;
+  const size_t USED =
+      (sv->length == 0)
+          ? 0
+          : ((sv->start + sv->length - 1) >> sv->chunk_shift) - FIRST + 1;
+  size_t new_capacity = sv->dir_capacity;
+  if ((USED + 1) * 2 > new_capacity) new_capacity *= 2;
+
+  void **chunks = sv->chunks;
+  if (new_capacity != sv->dir_capacity) {
+    chunks = malloc(new_capacity * sizeof(void *));
+    if (chunks == NULL) return false;
+  }
+  const size_t NEW_FIRST = (new_capacity - USED) / 2;
+  memmove(chunks + NEW_FIRST, sv->chunks + FIRST, USED * sizeof(void *));
+  for (size_t i = 0; i < NEW_FIRST; i++) chunks[i] = NULL;
+  for (size_t i = NEW_FIRST + USED; i < new_capacity; i++) chunks[i] = NULL;
+  if (chunks != sv->chunks) free(sv->chunks);
+
+  sv->chunks = chunks;
+  sv->dir_capacity = new_capacity;
+  sv->start = (NEW_FIRST << sv->chunk_shift) |
+              (sv->start & (chunk_len(sv) - 1));
+  return true;
+}
+
+segvector_t *_new_segvector(const void *const data, const size_t elem_size,
+                            const size_t length) {
+  if (elem_size == 0) return NULL;
+  segvector_t *const sv = malloc(sizeof(segvector_t));
+  if (sv == NULL) return NULL;
+  sv->chunks = calloc(BASE_DIR_CAPACITY, sizeof(void *));
+  if (sv->chunks == NULL) {
+    free(sv);
+    return NULL;
+  }
+  sv->dir_capacity = BASE_DIR_CAPACITY;
+  sv->length = 0;
+  sv->elem_size = elem_size;
+  sv->spare = NULL;
+  sv->chunk_shift = 0;
+  while (((size_t)2 << sv->chunk_shift) * elem_size <= SEGVECTOR_CHUNK_SIZE)
+    sv->chunk_shift++;
+  recenter_start(sv);
+
+  for (size_t i = 0; i < length; i++) {
+    if (segvector_push_back(sv, (const byte_t *)data + i * elem_size) == NULL) {
+      _delete_segvector(&(segvector_t *){sv});
+      return NULL;
+    }
+  }
+  return sv;
+}
+
+void _delete_segvector(segvector_t **const sv) {
+  segvector_clear(*sv);
+  free((*sv)->spare);
+  free((*sv)->chunks);
+  free(*sv);
+  *sv = NULL;
+}
+
+void _delete_segvector_s(segvector_t **const sv) {
+  segvector_t *const s = *sv;
+  for (size_t i = 0; i < s->dir_capacity; i++)
+    if (s->chunks[i] != NULL) memset(s->chunks[i], 0, chunk_bytes(s));
+  if (s->spare != NULL) memset(s->spare, 0, chunk_bytes(s));
+  segvector_clear(s);
+  free(s->spare);
+  free(s->chunks);
+  memset(s, 0, sizeof(*s));
+  free(s);
+  *sv = NULL;
+}
+
+void *segvector_get(const segvector_t *const sv, const size_t index) {
+  if (index >= sv->length) return NULL;
+  const size_t POS = sv->start + index;
+  return (byte_t *)sv->chunks[POS >> sv->chunk_shift] +
+         (POS & (chunk_len(sv) - 1)) * sv->elem_size;
+}
+
+void *segvector_span(const segvector_t *const sv, const size_t index,
+                     size_t *const count) {
+  if (index >= sv->length) {
+    *count = 0;
+    return NULL;
+  }
+  const size_t IN_CHUNK = chunk_len(sv) - ((sv->start + index) &
+                                           (chunk_len(sv) - 1));
+  const size_t REMAINING = sv->length - index;
+  *count = (REMAINING < IN_CHUNK) ? REMAINING : IN_CHUNK;
+  return segvector_get(sv, index);
+}
+
+void *segvector_push_back(segvector_t *const sv, const void *const elem) {
+  size_t pos = sv->start + sv->length;
+  if ((pos >> sv->chunk_shift) >= sv->dir_capacity) {
+    if (!make_directory_room(sv)) return NULL;
+    pos = sv->start + sv->length;
+  }
+  const size_t DIR_INDEX = pos >> sv->chunk_shift;
+  if (sv->chunks[DIR_INDEX] == NULL) {
+    sv->chunks[DIR_INDEX] = alloc_chunk(sv);
+    if (sv->chunks[DIR_INDEX] == NULL) return NULL;
+  }
+  byte_t *const slot = (byte_t *)sv->chunks[DIR_INDEX] +
+                       (pos & (chunk_len(sv) - 1)) * sv->elem_size;
+  memcpy(slot, elem, sv->elem_size);
+  sv->length++;
+  return slot;
+}
+
+void *segvector_push_front(segvector_t *const sv, const void *const elem) {
+  if (sv->start == 0 && !make_directory_room(sv)) return NULL;
+  const size_t POS = sv->start - 1;
+  const size_t DIR_INDEX = POS >> sv->chunk_shift;
+  if (sv->chunks[DIR_INDEX] == NULL) {
+    sv->chunks[DIR_INDEX] = alloc_chunk(sv);
+    if (sv->chunks[DIR_INDEX] == NULL) return NULL;
+  }
+  byte_t *const slot = (byte_t *)sv->chunks[DIR_INDEX] +
+                       (POS & (chunk_len(sv) - 1)) * sv->elem_size;
+  memcpy(slot, elem, sv->elem_size);
+  sv->start = POS;
+  sv->length++;
+  return slot;
+}
+
+bool segvector_pop_back(segvector_t *const sv, void *const out) {
+  if (sv->length == 0) return false;
+  const size_t POS = sv->start + sv->length - 1;
+  if (out != NULL) memcpy(out, segvector_get(sv, sv->length - 1), sv->elem_size);
+  sv->length--;
+  /* The chunk is empty once its first slot, or the first element, is gone. */
+  if ((POS & (chunk_len(sv) - 1)) == 0 || sv->length == 0)
+    release_chunk(sv, POS >> sv->chunk_shift);
+  if (sv->length == 0) recenter_start(sv);
+  return true;
+}
+
+bool segvector_pop_front(segvector_t *const sv, void *const out) {
+  if (sv->length == 0) return false;
+  const size_t POS = sv->start;
+  if (out != NULL) memcpy(out, segvector_get(sv, 0), sv->elem_size);
+  sv->start++;
+  sv->length--;
+  /* The chunk is empty once its last slot, or the last element, is gone. */
+  if ((sv->start & (chunk_len(sv) - 1)) == 0 || sv->length == 0)
+    release_chunk(sv, POS >> sv->chunk_shift);
+  if (sv->length == 0) recenter_start(sv);
+  return true;
+}
+
+void segvector_clear(segvector_t *const sv) {
+  for (size_t i = 0; i < sv->dir_capacity; i++) {
+    if (sv->chunks[i] != NULL) release_chunk(sv, i);
+  }
+  sv->length = 0;
+  recenter_start(sv);
+}
@@ -0,0 +1,108 @@
+#ifndef SEGVECTOR_H
+#define SEGVECTOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The approximate number of bytes in each chunk. The number of elements per
+ * chunk is the largest power of two fitting within this size (at least one).
+ */
+#define SEGVECTOR_CHUNK_SIZE ((size_t)16384)
+
+/* clang-format off */
+#define new_segvector(data, length) _new_segvector(data, sizeof *(data), length)
+#define delete_segvector(sv) _delete_segvector(&(sv))
+#define delete_segvector_s(sv) _delete_segvector_s(&(sv))
+/* clang-format on */
+
+/*
+ * A double-ended sequence whose elements are stored in fixed-size chunks
+ * referenced through a directory of chunk pointers.
+ *
+ * Growing never moves the header or any element, so pointers to elements
+ * remain valid until those elements are removed. Only the directory, which
+ * holds one pointer per chunk, is ever reallocated.
+ */
+typedef struct segvector_t {
+  void **chunks; /* Directory of chunks; unused entries are `NULL`. */
+  size_t dir_capacity;
+  size_t start; /* Position of the first element, counted from `chunks[0]`. */
+  size_t length;
+  size_t elem_size;
+  size_t chunk_shift; /* log2 of the number of elements per chunk. */
+  void *spare;        /* A released chunk kept for the next allocation. */
+} segvector_t;
+
+/*
+ * Creates a `segvector_t` containing `length` elements copied from `data`.
+ * `data` may be `NULL` if `length` is `0`.
+ *
+ * \return A pointer to the new `segvector_t` or `NULL` upon failure or if
+ * `elem_size` is zero.
+ */
+segvector_t *_new_segvector(const void *data, size_t elem_size, size_t length);
+
+/*
+ * Frees the memory used by `sv` and all of its chunks and invalidates the
+ * passed pointer.
+ */
+void _delete_segvector(segvector_t **sv);
+
+/*
+ * Same as `_delete_segvector()`, except this function will write zeros to
+ * every chunk and the header before freeing.
+ */
+void _delete_segvector_s(segvector_t **sv);
+
+/*
+ * Returns the element at `index` within `sv` in constant time.
+ *
+ * \return A pointer to the element or `NULL` if `index` is out of bounds.
+ */
+void *segvector_get(const segvector_t *sv, size_t index);
+
+/*
+ * Returns the element at `index` along with the number of elements, starting
+ * from `index`, which are contiguous in memory. Useful for bulk processing of
+ * the elements one chunk at a time.
+ *
+ * \return A pointer to the element or `NULL` if `index` is out of bounds, in
+ * which case `*count` is set to `0`.
+ */
+void *segvector_span(const segvector_t *sv, size_t index, size_t *count);
+
+/*
+ * Appends `elem` to the back of `sv`.
+ *
+ * \return A pointer to the stored element or `NULL` upon failure.
+ */
+void *segvector_push_back(segvector_t *sv, const void *elem);
+
+/*
+ * Prepends `elem` to the front of `sv`.
+ *
+ * \return A pointer to the stored element or `NULL` upon failure.
+ */
+void *segvector_push_front(segvector_t *sv, const void *elem);
+
+/*
+ * Removes the last element of `sv`, copying it into `out` unless `out` is
+ * `NULL`.
+ *
+ * \return `true` if an element was removed, or `false` if `sv` was empty.
+ */
+bool segvector_pop_back(segvector_t *sv, void *out);
+
+/*
+ * Removes the first element of `sv`, copying it into `out` unless `out` is
+ * `NULL`.
+ *
+ * \return `true` if an element was removed, or `false` if `sv` was empty.
+ */
+bool segvector_pop_front(segvector_t *sv, void *out);
+
+/* Removes every element from `sv` and releases all of its chunks. */
+void segvector_clear(segvector_t *sv);
+
+#endif
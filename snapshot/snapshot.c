@@ -0,0 +1,387 @@
+#include "snapshot.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "../allocator/allocator.h"
+#include "../array/array.h"
+#include "../mapped/mapped.h"
+#include "../stack/stack.h"
+#include "../strext/strext.h"
+#include "../trees/binarytree/binarytree.h"
+#include "../vector/vector.h"
+
+/* The size of a binary tree node's pair of child indices. */
+#define LINKS_SIZE (2 * sizeof(uint64_t))
+
+typedef unsigned char byte_t;
+
+/* - SAVING - */
+
+/*
+ * Fills in `header` for the snapshot of `container` and points `payload` at
+ * its elements. A binary tree's payload must first be gathered by
+ * `stage_tree()`, so its `payload` is left `NULL`.
+ *
+ * \return `true` upon success or `false` if `kind` is not a valid kind.
+ */
+static bool describe(const snapshot_kind kind, const void *const container,
+                     snapshot_header *const header,
+                     const void **const payload) {
+  *header = (snapshot_header){SNAPSHOT_MAGIC, SNAPSHOT_VERSION, kind, 0, 0, 0,
+                              0};
+  switch (kind) {
+    case SNAPSHOT_ARRAY: {
+      const array_t *const arr = container;
+      header->elem_size = arr->elem_size;
+      header->length = arr->length;
+      header->alignment = arr->alignment;
+      *payload = arr->data;
+      break;
+    }
+    case SNAPSHOT_VECTOR: {
+      const vector_t *const vec = container;
+      header->elem_size = vec->elem_size;
+      header->length = vec->length;
+      header->alignment = vec->alignment;
+      *payload = vec->data;
+      break;
+    }
+    case SNAPSHOT_STACK: {
+      const stack *const stk = container;
+      header->elem_size = stk->elem_size;
+      header->length = stk->length;
+      *payload = stk->data;
+      break;
+    }
+    case SNAPSHOT_STRING: {
+      const string_t *const str = container;
+      header->elem_size = 1;
+      header->length = str->length;
+      *payload = str->data;
+      break;
+    }
+    case SNAPSHOT_BINARY_TREE: {
+      const binary_tree *const tree = container;
+      header->elem_size = tree->elem_size;
+      header->length = tree->num_nodes;
+      header->payload_size = tree->num_nodes * (LINKS_SIZE + tree->elem_size);
+      *payload = NULL;
+      return true;
+    }
+    default:
+      return false;
+  }
+  header->payload_size = header->length * header->elem_size;
+  return true;
+}
+
+/*
+ * Gathers the payload of `tree` by walking it in level order. The walk's
+ * queue shares the allocation, ahead of the payload.
+ *
+ * \return The allocation, to be freed by the caller, or `NULL` upon failure
+ * or if `tree` holds a different number of nodes than it records.
+ */
+static void *stage_tree(const binary_tree *const tree,
+                        const void **const payload) {
+  const size_t NUM_NODES = tree->num_nodes;
+  const size_t ELEM_SIZE = tree->elem_size;
+  const bt_node **const queue =
+      malloc(NUM_NODES * (sizeof(bt_node *) + LINKS_SIZE + ELEM_SIZE) + 1);
+  if (queue == NULL) return NULL;
+  uint64_t *const links = (uint64_t *)(queue + NUM_NODES);
+  byte_t *const values = (byte_t *)(links + 2 * NUM_NODES);
+  size_t queued = 0;
+  if (tree->root != NULL && NUM_NODES != 0) queue[queued++] = tree->root;
+  for (size_t i = 0; i < queued; i++) {
+    const bt_node *const node = queue[i];
+    memcpy(values + i * ELEM_SIZE, node->value, ELEM_SIZE);
+    const bt_node *const CHILDREN[2] = {node->left, node->right};
+    for (size_t c = 0; c < 2; c++) {
+      if (CHILDREN[c] == NULL) {
+        links[2 * i + c] = SNAPSHOT_NO_NODE;
+        continue;
+      }
+      if (queued == NUM_NODES) {
+        free(queue);
+        return NULL;
+      }
+      links[2 * i + c] = queued;
+      queue[queued++] = CHILDREN[c];
+    }
+  }
+  if (queued != NUM_NODES) {
+    free(queue);
+    return NULL;
+  }
+  *payload = links;
+  return queue;
+}
+
+bool _save_snapshot_fd(const int fd, const snapshot_kind kind,
+                       const void *const container) {
+  snapshot_header header;
+  const void *payload;
+  if (!describe(kind, container, &header, &payload)) return false;
+  void *staging = NULL;
+  if (kind == SNAPSHOT_BINARY_TREE) {
+    staging = stage_tree(container, &payload);
+    if (staging == NULL) return false;
+  }
+  struct iovec iov[2] = {{&header, sizeof(header)},
+                         {(void *)payload, header.payload_size}};
+  const bool OK = write_fully(fd, iov, 2);
+  free(staging);
+  return OK;
+}
+
+bool _save_snapshot_file(FILE *const stream, const snapshot_kind kind,
+                         const void *const container) {
+  snapshot_header header;
+  const void *payload;
+  if (!describe(kind, container, &header, &payload)) return false;
+  void *staging = NULL;
+  if (kind == SNAPSHOT_BINARY_TREE) {
+    staging = stage_tree(container, &payload);
+    if (staging == NULL) return false;
+  }
+  const bool OK = fwrite(&header, sizeof(header), 1, stream) == 1 &&
+                  (header.payload_size == 0 ||
+                   fwrite(payload, header.payload_size, 1, stream) == 1);
+  free(staging);
+  return OK;
+}
+
+size_t _save_snapshot_buffer(void *const buffer, const size_t size,
+                             const snapshot_kind kind,
+                             const void *const container) {
+  snapshot_header header;
+  const void *payload;
+  if (!describe(kind, container, &header, &payload)) return 0;
+  const size_t TOTAL = sizeof(header) + header.payload_size;
+  if (size < TOTAL) return TOTAL;
+  void *staging = NULL;
+  if (kind == SNAPSHOT_BINARY_TREE) {
+    staging = stage_tree(container, &payload);
+    if (staging == NULL) return 0;
+  }
+  memcpy(buffer, &header, sizeof(header));
+  if (header.payload_size != 0)
+    memcpy((byte_t *)buffer + sizeof(header), payload, header.payload_size);
+  free(staging);
+  return TOTAL;
+}
+
+/* - LOADING - */
+
+/* Where a snapshot is read from. */
+typedef struct source {
+  bool (*read)(struct source *src, void *dst, size_t size);
+  union {
+    int fd;
+    FILE *stream;
+    struct {
+      const byte_t *cursor;
+      size_t remaining;
+    } buffer;
+  };
+} source;
+
+static bool read_fd(source *const src, void *const dst, const size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t READ = read(src->fd, (byte_t *)dst + done, size - done);
+    if (READ < 0 && errno == EINTR) continue;
+    if (READ <= 0) return false;
+    done += (size_t)READ;
+  }
+  return true;
+}
+
+static bool read_file(source *const src, void *const dst, const size_t size) {
+  return size == 0 || fread(dst, size, 1, src->stream) == 1;
+}
+
+static bool read_buffer(source *const src, void *const dst,
+                        const size_t size) {
+  if (src->buffer.remaining < size) return false;
+  memcpy(dst, src->buffer.cursor, size);
+  src->buffer.cursor += size;
+  src->buffer.remaining -= size;
+  return true;
+}
+
+/*
+ * Returns a pointer to the next `size` bytes of a buffer source without
+ * copying them, or `NULL` for other sources or if too few bytes remain.
+ */
+static const void *borrow(source *const src, const size_t size) {
+  if (src->read != read_buffer || src->buffer.remaining < size) return NULL;
+  const void *const bytes = src->buffer.cursor;
+  src->buffer.cursor += size;
+  src->buffer.remaining -= size;
+  return bytes;
+}
+
+/* Checks `header` against `kind` and the payload size its fields imply. */
+static bool valid_header(const snapshot_header *const header,
+                         const snapshot_kind kind) {
+  if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION ||
+      header->kind != (uint32_t)kind)
+    return false;
+  if (kind == SNAPSHOT_STRING && header->elem_size != 1) return false;
+  uint64_t unit = header->elem_size;
+  if (kind == SNAPSHOT_BINARY_TREE) {
+    if (unit > SIZE_MAX - LINKS_SIZE) return false;
+    unit += LINKS_SIZE;
+  }
+  /* Guard the size computation against overflow from a corrupt header. */
+  if (header->length != 0 && unit > SIZE_MAX / header->length) return false;
+  return header->payload_size == unit * header->length;
+}
+
+/*
+ * Recreates a binary tree from a level order payload, building its nodes in a
+ * single allocation and then linking them as the payload describes.
+ */
+static binary_tree *build_tree(const byte_t *const payload,
+                               const size_t num_nodes, const size_t elem_size,
+                               const allocator_t *const allocator) {
+  /*
+   * Each child must take the next unused index in level order, which also
+   * ensures every node but the root has exactly one parent.
+   */
+  size_t next = 1;
+  for (size_t i = 0; i < 2 * num_nodes; i++) {
+    uint64_t link;
+    memcpy(&link, payload + i * sizeof(link), sizeof(link));
+    if (link == SNAPSHOT_NO_NODE) continue;
+    if (link != next) return NULL;
+    next++;
+  }
+  if (num_nodes != 0 && next != num_nodes) return NULL;
+
+  binary_tree *const tree = _new_binary_tree_with(
+      payload + num_nodes * LINKS_SIZE, elem_size, num_nodes, allocator);
+  if (tree == NULL) return NULL;
+  /* The constructor lays the nodes out contiguously, starting at the root. */
+  byte_t *const nodes = (byte_t *)tree->root;
+  for (size_t i = 0; i < num_nodes; i++) {
+    bt_node *const node = (bt_node *)(nodes + i * tree->node_size);
+    bt_node **const CHILDREN[2] = {&node->left, &node->right};
+    for (size_t c = 0; c < 2; c++) {
+      uint64_t link;
+      memcpy(&link, payload + (2 * i + c) * sizeof(link), sizeof(link));
+      *CHILDREN[c] = NULL;
+      if (link == SNAPSHOT_NO_NODE) continue;
+      bt_node *const child = (bt_node *)(nodes + link * tree->node_size);
+      child->parent = node;
+      *CHILDREN[c] = child;
+    }
+  }
+  return tree;
+}
+
+static binary_tree *load_tree(source *const src,
+                              const snapshot_header *const header,
+                              const allocator_t *const allocator) {
+  const size_t SIZE = header->payload_size;
+  /* A buffer's payload is used in place; otherwise it is read in first. */
+  const void *payload = borrow(src, SIZE);
+  void *staging = NULL;
+  if (payload == NULL) {
+    staging = malloc(SIZE + 1);
+    if (staging == NULL) return NULL;
+    if (!src->read(src, staging, SIZE)) {
+      free(staging);
+      return NULL;
+    }
+    payload = staging;
+  }
+  binary_tree *const tree =
+      build_tree(payload, header->length, header->elem_size, allocator);
+  free(staging);
+  return tree;
+}
+
+static void *load(source *const src, const snapshot_kind kind,
+                  const allocator_t *const allocator) {
+  snapshot_header header;
+  if (!src->read(src, &header, sizeof(header)) || !valid_header(&header, kind))
+    return NULL;
+  const size_t ELEM_SIZE = header.elem_size;
+  const size_t LENGTH = header.length;
+  const size_t SIZE = header.payload_size;
+  switch (kind) {
+    case SNAPSHOT_ARRAY: {
+      array_t *arr = _new_array_aligned(NULL, ELEM_SIZE, LENGTH,
+                                        header.alignment, allocator);
+      if (arr != NULL && !src->read(src, arr->data, SIZE)) delete_array(arr);
+      return arr;
+    }
+    case SNAPSHOT_VECTOR: {
+      vector_t *vec = _new_vector_aligned(NULL, ELEM_SIZE, LENGTH,
+                                          header.alignment, allocator);
+      if (vec != NULL && !src->read(src, vec->data, SIZE)) delete_vector(vec);
+      return vec;
+    }
+    case SNAPSHOT_STACK: {
+      stack *stk = create_stack_with(LENGTH, ELEM_SIZE, allocator);
+      if (stk == NULL) return NULL;
+      if (!src->read(src, stk->data, SIZE)) {
+        delete_stack(&stk);
+        return NULL;
+      }
+      stk->length = LENGTH;
+      stk->used_capacity = SIZE;
+      return stk;
+    }
+    case SNAPSHOT_STRING: {
+      /* The capacity includes the terminator, as strext expects. */
+      if (LENGTH == SIZE_MAX) return NULL;
+      string_t *str = string_of_capacity_with(LENGTH + 1, allocator);
+      if (str == NULL) return NULL;
+      if (!src->read(src, str->data, SIZE)) {
+        delete_string(str);
+        return NULL;
+      }
+      str->data[LENGTH] = '\0';
+      str->length = LENGTH;
+      return str;
+    }
+    case SNAPSHOT_BINARY_TREE:
+      return load_tree(src, &header, allocator);
+    default:
+      return NULL;
+  }
+}
+
+void *load_snapshot_fd(const int fd, const snapshot_kind kind,
+                       const allocator_t *const allocator) {
+  source src = {.read = read_fd, .fd = fd};
+  return load(&src, kind, allocator);
+}
+
+void *load_snapshot_file(FILE *const stream, const snapshot_kind kind,
+                         const allocator_t *const allocator) {
+  source src = {.read = read_file, .stream = stream};
+  return load(&src, kind, allocator);
+}
+
+void *load_snapshot_buffer(const void *const buffer, const size_t size,
+                           const snapshot_kind kind,
+                           const allocator_t *const allocator,
+                           size_t *const consumed) {
+  source src = {.read = read_buffer, .buffer = {buffer, size}};
+  void *const container = load(&src, kind, allocator);
+  if (consumed != NULL) *consumed = size - src.buffer.remaining;
+  return container;
+}
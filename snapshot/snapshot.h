@@ -0,0 +1,125 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../allocator/allocator.h"
+#include "../array/array.h"
+#include "../stack/stack.h"
+#include "../strext/strext.h"
+#include "../trees/binarytree/binarytree.h"
+#include "../vector/vector.h"
+
+/* Identifies a snapshot; the bytes spell "MYCLIBSN". */
+#define SNAPSHOT_MAGIC ((uint64_t)0x4E5342494C43594DULL)
+
+/* Bumped whenever the layout of a snapshot changes. */
+#define SNAPSHOT_VERSION (1)
+
+/* Marks a missing child within a binary tree snapshot. */
+#define SNAPSHOT_NO_NODE (UINT64_MAX)
+
+typedef enum snapshot_kind {
+  SNAPSHOT_ARRAY = 1,
+  SNAPSHOT_VECTOR,
+  SNAPSHOT_STACK,
+  SNAPSHOT_STRING,
+  SNAPSHOT_BINARY_TREE
+} snapshot_kind;
+
+/*
+ * The header preceding every snapshot's payload. Fields are stored in the
+ * byte order of the machine which wrote them, which the magic number catches
+ * if it differs.
+ *
+ * The payload of an array, vector or stack is its `length * elem_size` bytes
+ * of elements and that of a string its `length` characters.
+ *
+ * A binary tree's payload numbers its nodes in level order, with the root as
+ * node zero. It holds the indices of each node's left and right children as
+ * pairs of `uint64_t`, or `SNAPSHOT_NO_NODE`, followed by every node's value.
+ * Holding indices rather than pointers, it may be loaded from anywhere.
+ */
+typedef struct snapshot_header {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t kind; /* A `snapshot_kind`. */
+  uint64_t elem_size;
+  uint64_t length;    /* The number of elements, characters or nodes. */
+  uint64_t alignment; /* The alignment of an array or vector's data. */
+  uint64_t payload_size;
+} snapshot_header;
+
+/* clang-format off */
+#define snapshot_kind_of(container)                 \
+  (_Generic((container),                            \
+  array_t *: SNAPSHOT_ARRAY,                        \
+  const array_t *: SNAPSHOT_ARRAY,                  \
+  vector_t *: SNAPSHOT_VECTOR,                      \
+  const vector_t *: SNAPSHOT_VECTOR,                \
+  stack *: SNAPSHOT_STACK,                          \
+  const stack *: SNAPSHOT_STACK,                    \
+  string_t *: SNAPSHOT_STRING,                      \
+  const string_t *: SNAPSHOT_STRING,                \
+  binary_tree *: SNAPSHOT_BINARY_TREE,              \
+  const binary_tree *: SNAPSHOT_BINARY_TREE))
+
+#define save_snapshot_fd(fd, container) \
+  _save_snapshot_fd(fd, snapshot_kind_of(container), container)
+#define save_snapshot_file(stream, container) \
+  _save_snapshot_file(stream, snapshot_kind_of(container), container)
+#define save_snapshot_buffer(buffer, size, container) \
+  _save_snapshot_buffer(buffer, size, snapshot_kind_of(container), container)
+/* clang-format on */
+
+/*
+ * Writes a snapshot of `container`, a container of type `kind`, to the file
+ * descriptor `fd`. The header and payload are written together by `writev()`.
+ *
+ * \return `true` upon success or `false` upon failure.
+ */
+bool _save_snapshot_fd(int fd, snapshot_kind kind, const void *container);
+
+/* Same as `_save_snapshot_fd()`, but writes to `stream`. */
+bool _save_snapshot_file(FILE *stream, snapshot_kind kind,
+                         const void *container);
+
+/*
+ * Writes a snapshot of `container` to `buffer` if its `size` bytes suffice.
+ * Passing a `size` of zero measures the snapshot without writing it.
+ *
+ * \return The size of the snapshot in bytes, which was only written if it is
+ * no greater than `size`, or zero upon failure.
+ */
+size_t _save_snapshot_buffer(void *buffer, size_t size, snapshot_kind kind,
+                             const void *container);
+
+/*
+ * Reads a snapshot of a container of type `kind` from the file descriptor
+ * `fd` and recreates the container with memory obtained from `allocator`, or
+ * the default allocator if it is `NULL`. The container's elements are read
+ * straight into its single allocation.
+ *
+ * \return A pointer to the new container, to be cast to the type given by
+ * `kind`, or `NULL` upon failure or if the snapshot is not of type `kind`.
+ */
+void *load_snapshot_fd(int fd, snapshot_kind kind,
+                       const allocator_t *allocator);
+
+/* Same as `load_snapshot_fd()`, but reads from `stream`. */
+void *load_snapshot_file(FILE *stream, snapshot_kind kind,
+                         const allocator_t *allocator);
+
+/*
+ * Same as `load_snapshot_fd()`, but reads from the `size` bytes of `buffer`.
+ * If `consumed` is not `NULL`, it receives the size of the snapshot read, so
+ * that snapshots stored back to back can be loaded in turn.
+ */
+void *load_snapshot_buffer(const void *buffer, size_t size,
+                           snapshot_kind kind, const allocator_t *allocator,
+                           size_t *consumed);
+
+#endif
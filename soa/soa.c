@@ -0,0 +1,148 @@
+#include "soa.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned char byte_t;
+
+/* `aligned_alloc()` requires the size to be a multiple of the alignment. */
+static size_t column_bytes(const size_t rows, const size_t field_size) {
+  const size_t BYTES = rows * field_size;
+  return (BYTES + SOA_COLUMN_ALIGNMENT - 1) & ~(SOA_COLUMN_ALIGNMENT - 1);
+}
+
+static void *alloc_column(const size_t rows, const size_t field_size) {
+  const size_t BYTES = column_bytes(rows, field_size);
+  /* A zero-sized request would be allowed to return `NULL`. */
+  return aligned_alloc(SOA_COLUMN_ALIGNMENT,
+                       BYTES != 0 ? BYTES : SOA_COLUMN_ALIGNMENT);
+}
+
+soa_t *_new_soa(const size_t *const field_sizes, const size_t num_fields,
+                const size_t capacity) {
+  /* The column pointers and the schema are stored right after the header. */
+  soa_t *const soa = malloc(sizeof(soa_t) + num_fields * sizeof(void *) +
+                            num_fields * sizeof(size_t));
+  if (soa == NULL) return NULL;
+  soa->columns = (void **)(soa + 1);
+  soa->field_sizes = (size_t *)(soa->columns + num_fields);
+  soa->num_fields = num_fields;
+  soa->row_size = 0;
+  soa->length = 0;
+  soa->capacity = capacity;
+  memcpy(soa->field_sizes, field_sizes, num_fields * sizeof(size_t));
+
+  for (size_t i = 0; i < num_fields; i++) {
+    soa->row_size += field_sizes[i];
+    soa->columns[i] = alloc_column(capacity, field_sizes[i]);
+    if (soa->columns[i] == NULL) {
+      while (i > 0) free(soa->columns[--i]);
+      free(soa);
+      return NULL;
+    }
+  }
+  return soa;
+}
+
+void _delete_soa(soa_t **const soa) {
+  for (size_t i = 0; i < (*soa)->num_fields; i++) free((*soa)->columns[i]);
+  free(*soa);
+  *soa = NULL;
+}
+
+soa_t *resize_soa(soa_t *const soa, const size_t new_capacity) {
+  const size_t NUM_FIELDS = soa->num_fields;
+  const size_t KEPT = (soa->length < new_capacity) ? soa->length : new_capacity;
+  /*
+   * Every column is allocated before any is released so that a failure part
+   * way through leaves `soa` untouched. Even a schema without fields gets one
+   * slot, so that the allocation cannot spuriously fail.
+   */
+  void **const new_columns =
+      malloc((NUM_FIELDS != 0 ? NUM_FIELDS : 1) * sizeof(void *));
+  if (new_columns == NULL) return NULL;
+  for (size_t i = 0; i < NUM_FIELDS; i++) {
+    new_columns[i] = alloc_column(new_capacity, soa->field_sizes[i]);
+    if (new_columns[i] == NULL) {
+      while (i > 0) free(new_columns[--i]);
+      free(new_columns);
+      return NULL;
+    }
+  }
+  for (size_t i = 0; i < NUM_FIELDS; i++) {
+    memcpy(new_columns[i], soa->columns[i], KEPT * soa->field_sizes[i]);
+    free(soa->columns[i]);
+    soa->columns[i] = new_columns[i];
+  }
+  free(new_columns);
+  soa->length = KEPT;
+  soa->capacity = new_capacity;
+  return soa;
+}
+
+/* Makes room for one more row, expanding `soa` if it is full. */
+static soa_t *reserve_row(soa_t *const soa) {
+  if (soa->length < soa->capacity) return soa;
+  const size_t NEW_CAPACITY =
+      (soa->capacity != 0) ? soa->capacity * SOA_EXPANSION_FACTOR : 1;
+  return resize_soa(soa, NEW_CAPACITY);
+}
+
+soa_t *soa_push(soa_t *const soa, const void *const *const fields) {
+  if (reserve_row(soa) == NULL) return NULL;
+  const size_t ROW = soa->length;
+  for (size_t i = 0; i < soa->num_fields; i++) {
+    const size_t FIELD_SIZE = soa->field_sizes[i];
+    memcpy((byte_t *)soa->columns[i] + ROW * FIELD_SIZE, fields[i],
+           FIELD_SIZE);
+  }
+  soa->length++;
+  return soa;
+}
+
+soa_t *soa_push_row(soa_t *const soa, const void *const row) {
+  if (reserve_row(soa) == NULL) return NULL;
+  const size_t ROW = soa->length;
+  const byte_t *field = row;
+  for (size_t i = 0; i < soa->num_fields; i++) {
+    const size_t FIELD_SIZE = soa->field_sizes[i];
+    memcpy((byte_t *)soa->columns[i] + ROW * FIELD_SIZE, field, FIELD_SIZE);
+    field += FIELD_SIZE;
+  }
+  soa->length++;
+  return soa;
+}
+
+void *soa_get(const soa_t *const soa, const size_t row, const size_t field) {
+  if (row >= soa->length || field >= soa->num_fields) return NULL;
+  return (byte_t *)soa->columns[field] + row * soa->field_sizes[field];
+}
+
+bool soa_set(soa_t *const soa, const size_t row, const size_t field,
+             const void *const value) {
+  void *const dst = soa_get(soa, row, field);
+  if (dst == NULL) return false;
+  memcpy(dst, value, soa->field_sizes[field]);
+  return true;
+}
+
+bool soa_read_row(const soa_t *const soa, const size_t row, void *const out) {
+  if (row >= soa->length) return false;
+  byte_t *field = out;
+  for (size_t i = 0; i < soa->num_fields; i++) {
+    const size_t FIELD_SIZE = soa->field_sizes[i];
+    memcpy(field, (byte_t *)soa->columns[i] + row * FIELD_SIZE, FIELD_SIZE);
+    field += FIELD_SIZE;
+  }
+  return true;
+}
+
+soa_span soa_column(const soa_t *const soa, const size_t field) {
+  if (field >= soa->num_fields) return (soa_span){NULL, 0, 0};
+  return (soa_span){soa->columns[field], soa->length,
+                    soa->field_sizes[field]};
+}
+
+void clear_soa(soa_t *const soa) { soa->length = 0; }
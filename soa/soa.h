@@ -0,0 +1,119 @@
+#ifndef SOA_H
+#define SOA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* The alignment in bytes of every column. Must be a power of two. */
+#define SOA_COLUMN_ALIGNMENT ((size_t)64)
+
+/* The factor by which a full `soa_t` scales its capacity when expanding. */
+#define SOA_EXPANSION_FACTOR (2)
+
+/*
+ * This is a convenience macro for `_new_soa()` taking the schema from a C
+ * array of field sizes.
+ * Use with caution if `field_sizes` has side effects.
+ */
+#define new_soa(field_sizes, capacity) \
+  _new_soa(field_sizes, sizeof(field_sizes) / sizeof *(field_sizes), capacity)
+#define delete_soa(soa) _delete_soa(&(soa))
+
+/*
+ * A table of records stored as a structure of arrays: each field lives in its
+ * own contiguous column, so a scan over one field reads only that field.
+ * Every column shares the same `length` and `capacity`, measured in rows.
+ */
+typedef struct soa_t {
+  void **columns;
+  size_t *field_sizes;
+  size_t num_fields;
+  size_t row_size; /* The sum of all field sizes. */
+  size_t length;
+  size_t capacity;
+} soa_t;
+
+/*
+ * A view of one column. `data`, `length` and `elem_size` match the members of
+ * `array_t` and `vector_t`, so a span can be passed to macros written for
+ * those containers.
+ */
+typedef struct soa_span {
+  void *data;
+  size_t length;
+  size_t elem_size;
+} soa_span;
+
+/*
+ * Creates an empty `soa_t` with one column per entry in `field_sizes` and room
+ * for `capacity` rows.
+ *
+ * \return A pointer to the new `soa_t` or `NULL` upon failure.
+ */
+soa_t *_new_soa(const size_t *field_sizes, size_t num_fields, size_t capacity);
+
+/*
+ * Frees the memory used by `soa` and its columns and invalidates the passed
+ * pointer.
+ */
+void _delete_soa(soa_t **soa);
+
+/*
+ * Resizes every column of `soa` to hold `new_capacity` rows. Rows beyond the
+ * new capacity are discarded.
+ *
+ * \return `soa` or `NULL` upon failure, in which case `soa` is unmodified.
+ */
+soa_t *resize_soa(soa_t *soa, size_t new_capacity);
+
+/*
+ * Appends a row whose fields are read from `fields`, an array holding one
+ * pointer per field in schema order, expanding if necessary.
+ *
+ * \return `soa` or `NULL` upon failure.
+ */
+soa_t *soa_push(soa_t *soa, const void *const *fields);
+
+/*
+ * Appends a row read from `row`, in which the fields are packed back to back
+ * in schema order without padding, expanding if necessary.
+ *
+ * \return `soa` or `NULL` upon failure.
+ */
+soa_t *soa_push_row(soa_t *soa, const void *row);
+
+/*
+ * Returns the value of `field` within `row`.
+ *
+ * \return A pointer to the value or `NULL` if either index is out of bounds.
+ */
+void *soa_get(const soa_t *soa, size_t row, size_t field);
+
+/*
+ * Overwrites the value of `field` within `row` with `value`.
+ *
+ * \return `true` upon success or `false` if either index is out of bounds.
+ */
+bool soa_set(soa_t *soa, size_t row, size_t field, const void *value);
+
+/*
+ * Copies every field of `row` into `out`, packed back to back in schema order
+ * without padding.
+ *
+ * \return `true` upon success or `false` if `row` is out of bounds.
+ */
+bool soa_read_row(const soa_t *soa, size_t row, void *out);
+
+/*
+ * Returns a view of the column holding `field`. The view is invalidated by any
+ * operation which changes the capacity of `soa`.
+ *
+ * \return The column's span, or a span with a `NULL` `data` member if `field`
+ * is out of bounds.
+ */
+soa_span soa_column(const soa_t *soa, size_t field);
+
+/* Removes every row from `soa` without releasing any memory. */
+void clear_soa(soa_t *soa);
+
+#endif
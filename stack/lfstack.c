@@ -0,0 +1,266 @@
+#include "lfstack.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Links and list heads refer to nodes by their index plus one, which leaves
+ * zero free to mean "no node".
+ */
+#define NO_NODE ((uint32_t)0)
+
+/* The number of nodes all slabs hold together, 64 short of 2^32. */
+#define MAX_NODES \
+  (LFSTACK_BASE_SLAB_NODES * (((size_t)1 << LFSTACK_MAX_SLABS) - 1))
+
+typedef unsigned char byte_t;
+
+typedef struct lf_node {
+  atomic_uint_least32_t next;
+} lf_node;
+
+/* Element data follows the link, aligned for any type up to 8 bytes. */
+#define NODE_DATA_OFFSET ((size_t)8)
+
+static uint64_t pack_head(const uint64_t tag, const uint32_t link) {
+  return (tag << 32) | link;
+}
+
+static uint32_t head_link(const uint64_t head) { return (uint32_t)head; }
+
+static uint64_t head_tag(const uint64_t head) { return head >> 32; }
+
+static size_t slab_nodes(const size_t slab) {
+  return LFSTACK_BASE_SLAB_NODES << slab;
+}
+
+/* Finds the slab holding node `index` and the node's offset within it. */
+static size_t locate_node(const size_t index, size_t *const offset) {
+  const size_t SLAB_RANK = index / LFSTACK_BASE_SLAB_NODES + 1;
+  size_t slab = 0;
+  while ((SLAB_RANK >> (slab + 1)) != 0) slab++;
+  *offset = index - LFSTACK_BASE_SLAB_NODES * (((size_t)1 << slab) - 1);
+  return slab;
+}
+
+static lf_node *node_at(const lfstack_t *const stk, const uint32_t link) {
+  size_t offset;
+  const size_t SLAB = locate_node((size_t)link - 1, &offset);
+  byte_t *const slab = atomic_load_explicit(
+      (_Atomic(byte_t *) *)&stk->slabs[SLAB], memory_order_acquire);
+  return (lf_node *)(slab + offset * stk->node_size);
+}
+
+static void *node_data(lf_node *const node) {
+  return (byte_t *)node + NODE_DATA_OFFSET;
+}
+
+static uint32_t node_next(const lfstack_t *const stk, const uint32_t link) {
+  return atomic_load_explicit(&node_at(stk, link)->next, memory_order_relaxed);
+}
+
+static void set_node_next(const lfstack_t *const stk, const uint32_t link,
+                          const uint32_t next) {
+  atomic_store_explicit(&node_at(stk, link)->next, next, memory_order_relaxed);
+}
+
+/*
+ * Allocates slab `slab` unless another thread already has. Slabs are
+ * published with a compare-and-swap, so the loser of a race frees its copy.
+ */
+static bool ensure_slab(lfstack_t *const stk, const size_t slab) {
+  if (atomic_load_explicit(&stk->slabs[slab], memory_order_acquire) != NULL)
+    return true;
+  byte_t *const mem = malloc(slab_nodes(slab) * stk->node_size);
+  if (mem == NULL) return false;
+  byte_t *expected = NULL;
+  if (!atomic_compare_exchange_strong_explicit(&stk->slabs[slab], &expected,
+                                               mem, memory_order_acq_rel,
+                                               memory_order_acquire))
+    free(mem);
+  return true;
+}
+
+/* - TREIBER STACK PRIMITIVES - */
+
+/* Pops the first node of `head`, returning its link or `NO_NODE`. */
+static uint32_t pop_node(const lfstack_t *const stk,
+                         atomic_uint_least64_t *const head) {
+  uint64_t old = atomic_load_explicit(head, memory_order_acquire);
+  while (true) {
+    const uint32_t LINK = head_link(old);
+    if (LINK == NO_NODE) return NO_NODE;
+    /*
+     * The node may be popped and reused by another thread before our
+     * compare-and-swap, in which case `next` is stale, but the tag will have
+     * changed and the swap fails.
+     */
+    const uint64_t NEW = pack_head(head_tag(old) + 1, node_next(stk, LINK));
+    if (atomic_compare_exchange_weak_explicit(
+            head, &old, NEW, memory_order_acquire, memory_order_acquire))
+      return LINK;
+  }
+}
+
+/* Pushes the chain of nodes linked from `first` through `last` onto `head`. */
+static void push_chain(const lfstack_t *const stk,
+                       atomic_uint_least64_t *const head, const uint32_t first,
+                       const uint32_t last) {
+  uint64_t old = atomic_load_explicit(head, memory_order_relaxed);
+  do {
+    set_node_next(stk, last, head_link(old));
+  } while (!atomic_compare_exchange_weak_explicit(
+      head, &old, pack_head(head_tag(old) + 1, first), memory_order_release,
+      memory_order_relaxed));
+}
+
+/* Empties `head`, returning the link of the first detached node. */
+static uint32_t detach_all(atomic_uint_least64_t *const head) {
+  uint64_t old = atomic_load_explicit(head, memory_order_acquire);
+  while (head_link(old) != NO_NODE) {
+    if (atomic_compare_exchange_weak_explicit(
+            head, &old, pack_head(head_tag(old) + 1, NO_NODE),
+            memory_order_acquire, memory_order_acquire))
+      return head_link(old);
+  }
+  return NO_NODE;
+}
+
+/*
+ * Obtains a private chain of `count` nodes, preferring recycled nodes over
+ * never-used ones, and stores the ends of the chain in `first` and `last`.
+ *
+ * \return `true` upon success or `false` if nodes could not be allocated.
+ */
+static bool take_nodes(lfstack_t *const stk, const size_t count,
+                       uint32_t *const first, uint32_t *const last) {
+  uint32_t head = NO_NODE, tail = NO_NODE;
+  size_t taken = 0;
+  if (count == 1) {
+    head = tail = pop_node(stk, &stk->free_list);
+    taken = (head != NO_NODE);
+  } else {
+    /* Take the whole free list at once and hand back whatever is left. */
+    head = detach_all(&stk->free_list);
+    for (uint32_t link = head; link != NO_NODE && taken < count;
+         link = node_next(stk, link)) {
+      tail = link;
+      taken++;
+    }
+    if (taken != 0) {
+      const uint32_t REST = node_next(stk, tail);
+      if (REST != NO_NODE) {
+        uint32_t rest_tail = REST;
+        while (node_next(stk, rest_tail) != NO_NODE)
+          rest_tail = node_next(stk, rest_tail);
+        push_chain(stk, &stk->free_list, REST, rest_tail);
+      }
+    }
+  }
+
+  if (taken < count) {
+    const size_t NEEDED = count - taken;
+    const size_t BASE = atomic_fetch_add(&stk->next_fresh, NEEDED);
+    bool ok = BASE + NEEDED <= MAX_NODES;
+    for (size_t i = 0; ok && i < NEEDED; i++) {
+      size_t offset;
+      ok = ensure_slab(stk, locate_node(BASE + i, &offset));
+    }
+    if (!ok) {
+      /* The fresh indices are lost, but recycled nodes must be returned. */
+      if (taken != 0) push_chain(stk, &stk->free_list, head, tail);
+      return false;
+    }
+    for (size_t i = 0; i < NEEDED; i++) {
+      const uint32_t LINK = (uint32_t)(BASE + i + 1);
+      if (tail == NO_NODE)
+        head = LINK;
+      else
+        set_node_next(stk, tail, LINK);
+      tail = LINK;
+    }
+  }
+  set_node_next(stk, tail, NO_NODE);
+  *first = head;
+  *last = tail;
+  return true;
+}
+
+/* - PUBLIC INTERFACE - */
+
+lfstack_t *new_lfstack(const size_t elem_size) {
+  lfstack_t *const stk = malloc(sizeof(lfstack_t));
+  if (stk == NULL) return NULL;
+  atomic_init(&stk->top, pack_head(0, NO_NODE));
+  atomic_init(&stk->free_list, pack_head(0, NO_NODE));
+  atomic_init(&stk->next_fresh, 0);
+  stk->elem_size = elem_size;
+  stk->node_size = (NODE_DATA_OFFSET + elem_size + 7) / 8 * 8;
+  for (size_t i = 0; i < LFSTACK_MAX_SLABS; i++)
+    atomic_init(&stk->slabs[i], NULL);
+  return stk;
+}
+
+void _delete_lfstack(lfstack_t **const stk) {
+  for (size_t i = 0; i < LFSTACK_MAX_SLABS; i++)
+    free(atomic_load_explicit(&(*stk)->slabs[i], memory_order_relaxed));
+  free(*stk);
+  *stk = NULL;
+}
+
+bool lfstack_push(lfstack_t *const stk, const void *const elem) {
+  uint32_t link, unused;
+  if (!take_nodes(stk, 1, &link, &unused)) return false;
+  memcpy(node_data(node_at(stk, link)), elem, stk->elem_size);
+  push_chain(stk, &stk->top, link, link);
+  return true;
+}
+
+bool lfstack_pop(lfstack_t *const stk, void *const out) {
+  const uint32_t LINK = pop_node(stk, &stk->top);
+  if (LINK == NO_NODE) return false;
+  if (out != NULL) memcpy(out, node_data(node_at(stk, LINK)), stk->elem_size);
+  push_chain(stk, &stk->free_list, LINK, LINK);
+  return true;
+}
+
+bool lfstack_push_all(lfstack_t *const stk, const void *const elems,
+                      const size_t num_elems) {
+  if (num_elems == 0) return true;
+  uint32_t first, last;
+  if (!take_nodes(stk, num_elems, &first, &last)) return false;
+  /* The chain's first node becomes the top, so it takes the last element. */
+  size_t i = num_elems;
+  for (uint32_t link = first; link != NO_NODE; link = node_next(stk, link)) {
+    i--;
+    memcpy(node_data(node_at(stk, link)),
+           (const byte_t *)elems + i * stk->elem_size, stk->elem_size);
+  }
+  push_chain(stk, &stk->top, first, last);
+  return true;
+}
+
+size_t lfstack_pop_all(lfstack_t *const stk, const lfstack_visit_t visit,
+                       void *const ctx) {
+  const uint32_t FIRST = detach_all(&stk->top);
+  if (FIRST == NO_NODE) return 0;
+  size_t count = 0;
+  uint32_t last = FIRST;
+  for (uint32_t link = FIRST; link != NO_NODE; link = node_next(stk, link)) {
+    visit(node_data(node_at(stk, link)), ctx);
+    last = link;
+    count++;
+  }
+  push_chain(stk, &stk->free_list, FIRST, last);
+  return count;
+}
+
+bool lfstack_is_empty(const lfstack_t *const stk) {
+  return head_link(atomic_load_explicit(
+             (atomic_uint_least64_t *)&stk->top, memory_order_relaxed)) ==
+         NO_NODE;
+}
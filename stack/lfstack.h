@@ -0,0 +1,93 @@
+#ifndef LFSTACK_H
+#define LFSTACK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The number of nodes within the first slab. Each further slab doubles. */
+#define LFSTACK_BASE_SLAB_NODES ((size_t)64)
+
+/* The number of slabs, which together hold just under 2^32 nodes. */
+#define LFSTACK_MAX_SLABS (26)
+
+#define delete_lfstack(stk) _delete_lfstack(&(stk))
+
+/*
+ * A lock-free stack which any number of threads may push to and pop from
+ * concurrently, intended for free lists and work queues.
+ *
+ * Each element is copied into a node. Nodes live in slabs which are never
+ * freed or moved until the stack is deleted, and popped nodes are recycled
+ * through an internal free list, so steady-state use does not allocate.
+ *
+ * Both lists are Treiber stacks whose head packs a 32-bit node index with a
+ * 32-bit tag. The tag changes on every successful update, so a head that was
+ * popped and pushed back between a thread's read and its compare-and-swap
+ * (the ABA problem) is still detected.
+ */
+typedef struct lfstack_t {
+  atomic_uint_least64_t top;
+  atomic_uint_least64_t free_list;
+  atomic_size_t next_fresh; /* The next never-used node index. */
+  size_t elem_size;
+  size_t node_size;
+  _Atomic(unsigned char *) slabs[LFSTACK_MAX_SLABS];
+} lfstack_t;
+
+/* Receives each element removed by `lfstack_pop_all()`. */
+typedef void (*lfstack_visit_t)(void *elem, void *ctx);
+
+/*
+ * Creates an empty lock-free stack of `elem_size`-byte elements.
+ *
+ * \return A pointer to the new stack or `NULL` upon failure.
+ */
+lfstack_t *new_lfstack(size_t elem_size);
+
+/*
+ * Frees the memory used by `stk` and all of its nodes and invalidates the
+ * passed pointer. No other thread may be using `stk` any longer.
+ */
+void _delete_lfstack(lfstack_t **stk);
+
+/*
+ * Pushes a copy of `elem` onto `stk`.
+ *
+ * \return `true` upon success or `false` if a node could not be allocated.
+ */
+bool lfstack_push(lfstack_t *stk, const void *elem);
+
+/*
+ * Pops the top element of `stk` into `out` unless `out` is `NULL`.
+ *
+ * \return `true` if an element was popped or `false` if `stk` was empty.
+ */
+bool lfstack_pop(lfstack_t *stk, void *out);
+
+/*
+ * Pushes the `num_elems` elements of `elems` with a single atomic update, so
+ * the last element of `elems` ends up on top and no other push is
+ * interleaved with them.
+ *
+ * \return `true` upon success or `false` if nodes could not be allocated, in
+ * which case nothing is pushed.
+ */
+bool lfstack_push_all(lfstack_t *stk, const void *elems, size_t num_elems);
+
+/*
+ * Atomically detaches every element of `stk` and passes each to `visit`, from
+ * the top down, before recycling their nodes with a single atomic update.
+ *
+ * \return The number of elements removed.
+ */
+size_t lfstack_pop_all(lfstack_t *stk, lfstack_visit_t visit, void *ctx);
+
+/*
+ * Returns `true` if `stk` holds no elements. The value may already be stale
+ * when other threads are using `stk`.
+ */
+bool lfstack_is_empty(const lfstack_t *stk);
+
+#endif
@@ -4,19 +4,30 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../allocator/allocator.h"
+
 /* The factor by which to scale a stack's capacity by when expanding. */
 #define STACK_EXPANSION_FACTOR (2)
 
 typedef unsigned char byte_t;
 
-static stack *alloc_stack(const size_t stack_capacity) {
-  return malloc(stack_capacity + sizeof(stack));
+static stack *alloc_stack(const size_t stack_capacity,
+                          const allocator_t *const allocator) {
+  return allocator->alloc(allocator->ctx, stack_capacity + sizeof(stack),
+                          DEFAULT_ALIGNMENT);
 }
 
 stack *create_stack(const size_t num_elems, const size_t elem_size) {
+  return create_stack_with(num_elems, elem_size, NULL);
+}
+
+stack *create_stack_with(const size_t num_elems, const size_t elem_size,
+                         const allocator_t *const allocator) {
   const size_t STACK_CAPACITY = num_elems * elem_size;
-  stack *const stk = alloc_stack(STACK_CAPACITY);
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  stack *const stk = alloc_stack(STACK_CAPACITY, ALLOCATOR);
   if (stk == NULL) return NULL;
+  stk->allocator = ALLOCATOR;
   stk->capacity = STACK_CAPACITY;
   stk->used_capacity = 0;
   stk->elem_size = elem_size;
@@ -44,38 +55,48 @@ stack *_stack_from_arr(const void *const arr, const size_t len,
 }
 
 void delete_stack(stack **const stk) {
-  free(*stk);
+  const allocator_t *const ALLOCATOR = (*stk)->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, *stk, (*stk)->capacity + sizeof(stack),
+                  DEFAULT_ALIGNMENT);
   *stk = NULL;
 }
 
 void delete_stack_s(stack **stk) {
-  memset(*stk, 0, (*stk)->capacity);
-  delete_stack(stk);
+  /* The header is about to be zeroed, so keep what freeing it requires. */
+  const allocator_t *const ALLOCATOR = (*stk)->allocator;
+  const size_t SIZE = (*stk)->capacity + sizeof(stack);
+  memset(*stk, 0, SIZE);
+  ALLOCATOR->free(ALLOCATOR->ctx, *stk, SIZE, DEFAULT_ALIGNMENT);
+  *stk = NULL;
 }
 
 stack *expand_stack(stack *stk) {
-  stack *new_stk = resize_stack(stk, STACK_EXPANSION_FACTOR * stk->capacity);
+  size_t increment = (STACK_EXPANSION_FACTOR - 1) * stk->capacity;
+  if (increment < stk->elem_size) increment = stk->elem_size;
   /*
    * Reallocation may fail because the requested memory is too large.
-   * In this case, we fall back to the safer, yet generally less efficient
-   * option of only allocating enough memory for one new element in the stack.
-   * This has the likely side effect of requiring more later reallocations, but
-   * is more likely to ensure program stability.
-   * Of course, if this also fails, then chances are the system is out of
-   * memory, so it's fine to return `NULL`.
+   * In this case, we retry with half of the previous increment until even a
+   * single element cannot be allocated. Growing by a fraction of the capacity
+   * keeps later pushes amortized constant time, whereas growing by one element
+   * would force a reallocation on every subsequent push.
+   * Of course, if a single element cannot be allocated, then chances are the
+   * system is out of memory, so it's fine to return `NULL`.
    */
-  if (new_stk == NULL)
-    new_stk = resize_stack(stk, stk->capacity + stk->elem_size);
-  return new_stk;
+  while (true) {
+    stack *const new_stk = resize_stack(stk, stk->capacity + increment);
+    if (new_stk != NULL || increment <= stk->elem_size) return new_stk;
+    increment /= 2;
+  }
 }
 
 stack *resize_stack(stack *stk, size_t new_size) {
   {
-    const size_t ADDITIONAL_BYTES =
-        stk->elem_size - (new_size % stk->elem_size);
-    if (ADDITIONAL_BYTES != 0) new_size += ADDITIONAL_BYTES;
+    const size_t REMAINDER = new_size % stk->elem_size;
+    if (REMAINDER != 0) new_size += stk->elem_size - REMAINDER;
   }
-  stk = realloc(stk, new_size + sizeof(stack));
+  const allocator_t *const ALLOCATOR = stk->allocator;
+  stk = ALLOCATOR->realloc(ALLOCATOR->ctx, stk, stk->capacity + sizeof(stack),
+                           new_size + sizeof(stack), DEFAULT_ALIGNMENT);
   if (stk == NULL) return NULL;
   stk->capacity = new_size;
   stk->data = stk + 1; /* Increment past the stack header. */
@@ -101,6 +122,7 @@ void *stack_pop(stack *const stk) {
   if (stk->length == 0) return NULL;
   void *val = stack_peek(stk);
   stk->length--;
+  stk->used_capacity -= stk->elem_size;
   return val;
 }
 
@@ -116,3 +138,120 @@ stack *stack_push(stack *stk, const void *const elem) {
   stk->used_capacity += stk->elem_size;
   return stk;
 }
+
+stack *stack_push_n(stack *stk, const void *const elems,
+                    const size_t num_elems) {
+  const size_t BYTES = num_elems * stk->elem_size;
+  if (stk->used_capacity + BYTES > stk->capacity) {
+    size_t new_size = STACK_EXPANSION_FACTOR * stk->capacity;
+    if (new_size < stk->used_capacity + BYTES)
+      new_size = stk->used_capacity + BYTES;
+    stk = resize_stack(stk, new_size);
+    if (stk == NULL) return NULL;
+  }
+  memcpy((byte_t *)stk->data + stk->length * stk->elem_size, elems, BYTES);
+  stk->length += num_elems;
+  stk->used_capacity += BYTES;
+  return stk;
+}
+
+size_t stack_pop_n(stack *const stk, void *const out, size_t num_elems) {
+  if (num_elems > stk->length) num_elems = stk->length;
+  stk->length -= num_elems;
+  stk->used_capacity -= num_elems * stk->elem_size;
+  if (out != NULL) {
+    memcpy(out, (byte_t *)stk->data + stk->length * stk->elem_size,
+           num_elems * stk->elem_size);
+  }
+  return num_elems;
+}
+
+void small_stack_init(small_stack *const stk, void *const storage,
+                      const size_t num_elems, const size_t elem_size) {
+  small_stack_init_with(stk, storage, num_elems, elem_size, NULL);
+}
+
+void small_stack_init_with(small_stack *const stk, void *const storage,
+                           const size_t num_elems, const size_t elem_size,
+                           const allocator_t *const allocator) {
+  stk->data = storage;
+  stk->length = 0;
+  stk->capacity = num_elems;
+  stk->elem_size = elem_size;
+  stk->storage = storage;
+  stk->storage_capacity = num_elems;
+  stk->allocator = allocator_or_default(allocator);
+}
+
+void small_stack_release(small_stack *const stk) {
+  if (stk->data != stk->storage) {
+    const allocator_t *const ALLOCATOR = allocator_or_default(stk->allocator);
+    ALLOCATOR->free(ALLOCATOR->ctx, stk->data, stk->capacity * stk->elem_size,
+                    DEFAULT_ALIGNMENT);
+  }
+  stk->data = stk->storage;
+  stk->capacity = stk->storage_capacity;
+  stk->length = 0;
+}
+
+/*
+ * Grows `stk` to hold at least `min_elems` elements, moving its contents from
+ * the caller's storage to the heap upon the first overflow.
+ */
+static bool grow_small_stack(small_stack *const stk, const size_t min_elems) {
+  const allocator_t *const ALLOCATOR = allocator_or_default(stk->allocator);
+  size_t new_capacity = STACK_EXPANSION_FACTOR * stk->capacity;
+  if (new_capacity < min_elems) new_capacity = min_elems;
+  const size_t NEW_SIZE = new_capacity * stk->elem_size;
+  void *new_data;
+  if (stk->data == stk->storage) {
+    new_data = ALLOCATOR->alloc(ALLOCATOR->ctx, NEW_SIZE, DEFAULT_ALIGNMENT);
+    if (new_data == NULL) return false;
+    memcpy(new_data, stk->data, stk->length * stk->elem_size);
+  } else {
+    new_data = ALLOCATOR->realloc(ALLOCATOR->ctx, stk->data,
+                                  stk->capacity * stk->elem_size, NEW_SIZE,
+                                  DEFAULT_ALIGNMENT);
+    if (new_data == NULL) return false;
+  }
+  stk->data = new_data;
+  stk->capacity = new_capacity;
+  return true;
+}
+
+bool small_stack_push(small_stack *const stk, const void *const elem) {
+  return small_stack_push_n(stk, elem, 1);
+}
+
+bool small_stack_push_n(small_stack *const stk, const void *const elems,
+                        const size_t num_elems) {
+  if (stk->length + num_elems > stk->capacity &&
+      !grow_small_stack(stk, stk->length + num_elems))
+    return false;
+  memcpy((byte_t *)stk->data + stk->length * stk->elem_size, elems,
+         num_elems * stk->elem_size);
+  stk->length += num_elems;
+  return true;
+}
+
+void *small_stack_peek(const small_stack *const stk) {
+  if (stk->length == 0) return NULL;
+  return (byte_t *)stk->data + (stk->length - 1) * stk->elem_size;
+}
+
+void *small_stack_pop(small_stack *const stk) {
+  void *const val = small_stack_peek(stk);
+  if (val != NULL) stk->length--;
+  return val;
+}
+
+size_t small_stack_pop_n(small_stack *const stk, void *const out,
+                         size_t num_elems) {
+  if (num_elems > stk->length) num_elems = stk->length;
+  stk->length -= num_elems;
+  if (out != NULL) {
+    memcpy(out, (byte_t *)stk->data + stk->length * stk->elem_size,
+           num_elems * stk->elem_size);
+  }
+  return num_elems;
+}
@@ -1,16 +1,45 @@
 #ifndef STACKS_H
 #define STACKS_H
 
+#include <stdbool.h>
 #include <stdlib.h>
 
+#include "../allocator/allocator.h"
+
 typedef struct {
   void *data;
   size_t capacity;
   size_t used_capacity;
   size_t elem_size;
   size_t length;
+  const allocator_t *allocator;
 } stack;
 
+/*
+ * A stack whose first elements live in storage provided by the caller, such
+ * as an automatic array, and which only moves to the heap once that storage
+ * overflows. Here, `capacity` is measured in elements.
+ */
+typedef struct {
+  void *data;
+  size_t length;
+  size_t capacity;
+  size_t elem_size;
+  void *storage;           /* The caller's storage. */
+  size_t storage_capacity; /* The number of elements `storage` holds. */
+  const allocator_t *allocator; /* Serves the heap; `NULL` for the default. */
+} small_stack;
+
+/*
+ * This is a convenience macro declaring a `small_stack` named `name` along
+ * with automatic storage for `num_elems` elements of type `type`.
+ * The stack must be passed to `small_stack_release()` before leaving scope.
+ */
+#define DEFINE_SMALL_STACK(name, type, num_elems)   \
+  type name##_storage[num_elems];                   \
+  small_stack name = {name##_storage, 0, num_elems, \
+                      sizeof(type), name##_storage, num_elems, NULL}
+
 /*
  * This is a convenience macro for `_stack_from_arr()`.
  * Use with caution if `arr` has side effects.
@@ -29,6 +58,13 @@ stack *_stack_from_arr(const void *arr, size_t len, size_t elem_size);
  */
 stack *create_stack(size_t num_elems, size_t elem_size);
 
+/*
+ * Same as `create_stack()`, except the stack's memory is obtained from and
+ * returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+stack *create_stack_with(size_t num_elems, size_t elem_size,
+                         const allocator_t *allocator);
+
 /*
  * Frees the memory used by `stk` and invalidates the passed pointer
  * associated with it.
@@ -91,4 +127,80 @@ void *stack_pop(stack *stk);
  */
 stack *stack_push(stack *stk, const void *const elem);
 
+/*
+ * Adds the `num_elems` elements of `elems` to `stk` with a single copy,
+ * expanding at most once. The last element of `elems` ends up on top.
+ *
+ * \return A pointer associated with the contents of `stk` or `NULL` upon
+ * failure.
+ */
+stack *stack_push_n(stack *stk, const void *elems, size_t num_elems);
+
+/*
+ * Removes up to `num_elems` elements from the top of `stk` with a single copy
+ * into `out`, unless `out` is `NULL`. The elements are copied in the order in
+ * which they were pushed, so the former top element is copied last.
+ *
+ * \return The number of elements removed.
+ */
+size_t stack_pop_n(stack *stk, void *out, size_t num_elems);
+
+/*
+ * Prepares `stk` to use `storage`, which must hold `num_elems` elements of
+ * size `elem_size` and outlive `stk`, before spilling to the heap.
+ */
+void small_stack_init(small_stack *stk, void *storage, size_t num_elems,
+                      size_t elem_size);
+
+/*
+ * Same as `small_stack_init()`, except the heap memory `stk` spills to is
+ * obtained from and returned to `allocator`, or the default allocator if it
+ * is `NULL`.
+ */
+void small_stack_init_with(small_stack *stk, void *storage, size_t num_elems,
+                           size_t elem_size, const allocator_t *allocator);
+
+/*
+ * Frees any heap memory used by `stk` and empties it. `stk` may be reused
+ * afterwards with its original storage.
+ */
+void small_stack_release(small_stack *stk);
+
+/*
+ * Adds a new element to `stk`, moving to the heap if the caller's storage is
+ * exhausted.
+ *
+ * \return `true` upon success or `false` if memory could not be allocated.
+ */
+bool small_stack_push(small_stack *stk, const void *elem);
+
+/*
+ * Adds the `num_elems` elements of `elems` to `stk` with a single copy. The
+ * last element of `elems` ends up on top.
+ *
+ * \return `true` upon success or `false` if memory could not be allocated.
+ */
+bool small_stack_push_n(small_stack *stk, const void *elems, size_t num_elems);
+
+/*
+ * Returns the top element of `stk` without removing it.
+ *
+ * \return A pointer to the top element in `stk` or `NULL` if `stk` is empty.
+ */
+void *small_stack_peek(const small_stack *stk);
+
+/*
+ * Returns and removes the top element from `stk`.
+ *
+ * \return A pointer to the top element in `stk` or `NULL` if `stk` is empty.
+ */
+void *small_stack_pop(small_stack *stk);
+
+/*
+ * Same as `stack_pop_n()`, but for a `small_stack`.
+ *
+ * \return The number of elements removed.
+ */
+size_t small_stack_pop_n(small_stack *stk, void *out, size_t num_elems);
+
 #endif
@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../allocator/allocator.h"
+
 string_t *append_char(string_t *dst, const char appended) {
   if (dst->length == dst->capacity - 1) {
     string_t *reallocated_mem = expand_string(dst);
@@ -48,13 +50,19 @@ string_t *append_raw_str(string_t *dst, const char *src, const size_t src_len) {
 }
 
 void _delete_string(string_t **str_obj) {
-  free(*str_obj);
+  const allocator_t *const ALLOCATOR = (*str_obj)->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, *str_obj,
+                  (*str_obj)->capacity + sizeof(string_t), DEFAULT_ALIGNMENT);
   *str_obj = NULL;
 }
 
 void _delete_string_s(string_t **str_obj) {
-  memset(*str_obj, 0, (*str_obj)->capacity + sizeof(string_t));
-  _delete_string(str_obj);
+  /* The header is about to be zeroed, so keep what freeing it requires. */
+  const allocator_t *const ALLOCATOR = (*str_obj)->allocator;
+  const size_t SIZE = (*str_obj)->capacity + sizeof(string_t);
+  memset(*str_obj, 0, SIZE);
+  ALLOCATOR->free(ALLOCATOR->ctx, *str_obj, SIZE, DEFAULT_ALIGNMENT);
+  *str_obj = NULL;
 }
 
 string_t *erase_string_contents(string_t *const str) {
@@ -116,7 +124,10 @@ string_t *find_replace(string_t *haystack, const string_t *const needle,
  * one).
  */
 string_t *resize_string(string_t *str_obj, const size_t new_size) {
-  string_t *new_mem = realloc(str_obj, new_size + sizeof(string_t));
+  const allocator_t *const ALLOCATOR = str_obj->allocator;
+  string_t *new_mem = ALLOCATOR->realloc(
+      ALLOCATOR->ctx, str_obj, str_obj->capacity + sizeof(string_t),
+      new_size + sizeof(string_t), DEFAULT_ALIGNMENT);
   if (new_mem == NULL) return NULL;
   new_mem->capacity = new_size;
   new_mem->data = (char *)new_mem + sizeof(string_t);
@@ -128,10 +139,8 @@ string_t *shrink_alloc_to_length(string_t *str_obj) {
 }
 
 string_t *string_from_chars(const char *const raw_text) {
-  string_t *str_obj = malloc(BASE_STR_CAPACITY + sizeof(string_t));
+  string_t *str_obj = string_of_capacity(BASE_STR_CAPACITY);
   if (str_obj == NULL) return NULL;
-  str_obj->capacity = BASE_STR_CAPACITY;
-  str_obj->data = (char *)str_obj + sizeof(string_t);
 
   /*
    * `strncpy()` could simplify this loop, but it may introduce overhead as,
@@ -196,8 +205,16 @@ string_t *string_from_stream_given_delim(FILE *const stream, const char delim) {
 }
 
 string_t *string_of_capacity(const size_t capacity) {
-  string_t *str_obj = malloc(capacity + sizeof(string_t));
+  return string_of_capacity_with(capacity, NULL);
+}
+
+string_t *string_of_capacity_with(const size_t capacity,
+                                  const allocator_t *const allocator) {
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  string_t *str_obj = ALLOCATOR->alloc(
+      ALLOCATOR->ctx, capacity + sizeof(string_t), DEFAULT_ALIGNMENT);
   if (str_obj == NULL) return NULL;
+  str_obj->allocator = ALLOCATOR;
   str_obj->data = (char *)str_obj + sizeof(string_t);
   str_obj->length = 0;
   str_obj->capacity = capacity;
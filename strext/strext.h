@@ -3,6 +3,8 @@
 
 #include <stdio.h>
 
+#include "../allocator/allocator.h"
+
 /* Capacity size in bytes. Must be greater than 0. */
 #define BASE_STR_CAPACITY (8192)
 #if (BASE_STR_CAPACITY <= 0)
@@ -19,6 +21,7 @@ typedef struct string_t {
   char *data;
   size_t length;
   size_t capacity;
+  const allocator_t *allocator;
 } string_t;
 
 /* clang-format off */
@@ -183,4 +186,11 @@ string_t *string_from_stream_given_delim(FILE *stream, char delim);
  */
 string_t *string_of_capacity(const size_t capacity);
 
+/*
+ * Same as `string_of_capacity()`, except the string's memory is obtained from
+ * and returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+string_t *string_of_capacity_with(size_t capacity,
+                                  const allocator_t *allocator);
+
 #endif
@@ -0,0 +1,504 @@
+#define _GNU_SOURCE
+#include "threadpool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The number of tasks each deque can hold before it first has to grow. */
+#define BASE_DEQUE_CAPACITY ((size_t)64)
+
+typedef unsigned char byte_t;
+
+typedef struct task_t {
+  task_func_t func;
+  void *arg;
+} task_t;
+
+/*
+ * A growable circular buffer of tasks. The owning worker pushes and pops at
+ * `tail` (LIFO, for locality), while thieves take from `head` (FIFO, so they
+ * receive the oldest and usually largest pieces of work).
+ */
+typedef struct task_deque {
+  pthread_mutex_t lock;
+  task_t *tasks;
+  size_t capacity; /* Always a power of two. */
+  size_t head;
+  size_t tail;
+  thread_pool *pool;
+} task_deque;
+
+struct thread_pool {
+  pthread_t *threads;
+  /*
+   * One deque per worker, followed by one deque which receives tasks
+   * submitted from threads outside of the pool.
+   */
+  task_deque *deques;
+  size_t num_threads;
+  atomic_size_t queued;     /* Tasks sitting in a deque. */
+  atomic_size_t unfinished; /* Tasks submitted but not yet completed. */
+  atomic_size_t idle;       /* Workers waiting on `work_available`. */
+  atomic_bool shutdown;
+  pthread_mutex_t lock;
+  pthread_cond_t work_available;
+};
+
+/* The deque owned by the calling thread, or `NULL` for non-worker threads. */
+static _Thread_local task_deque *own_deque = NULL;
+
+static bool init_deque(task_deque *const dq, thread_pool *const pool) {
+  dq->tasks = malloc(BASE_DEQUE_CAPACITY * sizeof(task_t));
+  if (dq->tasks == NULL) return false;
+  if (pthread_mutex_init(&dq->lock, NULL) != 0) {
+    free(dq->tasks);
+    return false;
+  }
+  dq->capacity = BASE_DEQUE_CAPACITY;
+  dq->head = dq->tail = 0;
+  dq->pool = pool;
+  return true;
+}
+
+static void destroy_deque(task_deque *const dq) {
+  pthread_mutex_destroy(&dq->lock);
+  free(dq->tasks);
+}
+
+static bool deque_push(task_deque *const dq, const task_t task) {
+  pthread_mutex_lock(&dq->lock);
+  if (dq->tail - dq->head == dq->capacity) {
+    const size_t NEW_CAPACITY = dq->capacity * 2;
+    task_t *const new_tasks = malloc(NEW_CAPACITY * sizeof(task_t));
+    if (new_tasks == NULL) {
+      pthread_mutex_unlock(&dq->lock);
+      return false;
+    }
+    /* Unwrap the circular buffer so that `head` starts at index zero. */
+    const size_t LENGTH = dq->tail - dq->head;
+    for (size_t i = 0; i < LENGTH; i++)
+      new_tasks[i] = dq->tasks[(dq->head + i) & (dq->capacity - 1)];
+    free(dq->tasks);
+    dq->tasks = new_tasks;
+    dq->capacity = NEW_CAPACITY;
+    dq->head = 0;
+    dq->tail = LENGTH;
+  }
+  dq->tasks[dq->tail & (dq->capacity - 1)] = task;
+  dq->tail++;
+  pthread_mutex_unlock(&dq->lock);
+  return true;
+}
+
+static bool deque_pop(task_deque *const dq, task_t *const task) {
+  bool found = false;
+  pthread_mutex_lock(&dq->lock);
+  if (dq->tail != dq->head) {
+    dq->tail--;
+    *task = dq->tasks[dq->tail & (dq->capacity - 1)];
+    found = true;
+  }
+  pthread_mutex_unlock(&dq->lock);
+  return found;
+}
+
+static bool deque_steal(task_deque *const dq, task_t *const task) {
+  bool found = false;
+  /* A busy deque is skipped rather than waited on; there are others to try. */
+  if (pthread_mutex_trylock(&dq->lock) != 0) return false;
+  if (dq->tail != dq->head) {
+    *task = dq->tasks[dq->head & (dq->capacity - 1)];
+    dq->head++;
+    found = true;
+  }
+  pthread_mutex_unlock(&dq->lock);
+  return found;
+}
+
+/*
+ * Takes a task from the deque owned by the calling thread if it belongs to
+ * `pool`, otherwise steals one from the external deque or another worker.
+ */
+static bool find_task(thread_pool *const pool, task_t *const task) {
+  const size_t NUM_DEQUES = pool->num_threads + 1;
+  size_t start = pool->num_threads;
+  bool found = false;
+  if (own_deque != NULL && own_deque->pool == pool) {
+    found = deque_pop(own_deque, task);
+    start = (size_t)(own_deque - pool->deques) + 1;
+  }
+  for (size_t i = 0; !found && i < NUM_DEQUES; i++)
+    found = deque_steal(&pool->deques[(start + i) % NUM_DEQUES], task);
+  if (found) atomic_fetch_sub(&pool->queued, 1);
+  return found;
+}
+
+static void run_task(thread_pool *const pool, const task_t task) {
+  task.func(task.arg);
+  atomic_fetch_sub_explicit(&pool->unfinished, 1, memory_order_release);
+}
+
+/*
+ * Executes queued tasks on the calling thread until `*counter` drops to zero,
+ * which keeps nested parallel calls from deadlocking on an exhausted pool.
+ */
+static void help_until_zero(thread_pool *const pool,
+                            atomic_size_t *const counter) {
+  while (atomic_load_explicit(counter, memory_order_acquire) != 0) {
+    task_t task;
+    if (find_task(pool, &task))
+      run_task(pool, task);
+    else
+      sched_yield();
+  }
+}
+
+static void *worker_main(void *const arg) {
+  own_deque = arg;
+  thread_pool *const pool = own_deque->pool;
+  while (true) {
+    task_t task;
+    if (find_task(pool, &task)) {
+      run_task(pool, task);
+      continue;
+    }
+    pthread_mutex_lock(&pool->lock);
+    atomic_fetch_add(&pool->idle, 1);
+    while (atomic_load(&pool->queued) == 0 && !atomic_load(&pool->shutdown))
+      pthread_cond_wait(&pool->work_available, &pool->lock);
+    atomic_fetch_sub(&pool->idle, 1);
+    const bool STOP =
+        atomic_load(&pool->shutdown) && atomic_load(&pool->queued) == 0;
+    pthread_mutex_unlock(&pool->lock);
+    if (STOP) return NULL;
+  }
+}
+
+thread_pool *new_thread_pool(size_t num_threads) {
+  if (num_threads == 0) {
+    const long ONLINE_CPUS = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = ONLINE_CPUS > 0 ? (size_t)ONLINE_CPUS : 1;
+  }
+  thread_pool *const pool = malloc(sizeof(thread_pool));
+  if (pool == NULL) return NULL;
+  pool->threads = malloc(num_threads * sizeof(pthread_t));
+  pool->deques = malloc((num_threads + 1) * sizeof(task_deque));
+  if (pool->threads == NULL || pool->deques == NULL) goto fail_alloc;
+  if (pthread_mutex_init(&pool->lock, NULL) != 0) goto fail_alloc;
+  if (pthread_cond_init(&pool->work_available, NULL) != 0) goto fail_lock;
+
+  size_t num_deques = 0;
+  for (; num_deques < num_threads + 1; num_deques++)
+    if (!init_deque(&pool->deques[num_deques], pool)) goto fail_deques;
+
+  pool->num_threads = num_threads;
+  atomic_init(&pool->queued, 0);
+  atomic_init(&pool->unfinished, 0);
+  atomic_init(&pool->idle, 0);
+  atomic_init(&pool->shutdown, false);
+
+  for (size_t i = 0; i < num_threads; i++) {
+    if (pthread_create(&pool->threads[i], NULL, worker_main,
+                       &pool->deques[i]) != 0) {
+      /* Stop the workers which did start before releasing everything. */
+      pthread_mutex_lock(&pool->lock);
+      atomic_store(&pool->shutdown, true);
+      pthread_cond_broadcast(&pool->work_available);
+      pthread_mutex_unlock(&pool->lock);
+      while (i > 0) pthread_join(pool->threads[--i], NULL);
+      goto fail_deques;
+    }
+  }
+  return pool;
+
+fail_deques:
+  while (num_deques > 0) destroy_deque(&pool->deques[--num_deques]);
+  pthread_cond_destroy(&pool->work_available);
+fail_lock:
+  pthread_mutex_destroy(&pool->lock);
+fail_alloc:
+  free(pool->threads);
+  free(pool->deques);
+  free(pool);
+  return NULL;
+}
+
+void delete_thread_pool(thread_pool **const pool) {
+  thread_pool *const p = *pool;
+  thread_pool_wait(p);
+  pthread_mutex_lock(&p->lock);
+  atomic_store(&p->shutdown, true);
+  pthread_cond_broadcast(&p->work_available);
+  pthread_mutex_unlock(&p->lock);
+  for (size_t i = 0; i < p->num_threads; i++)
+    pthread_join(p->threads[i], NULL);
+  /* The external deque sits past the workers' deques. */
+  for (size_t i = 0; i < p->num_threads + 1; i++) destroy_deque(&p->deques[i]);
+  pthread_cond_destroy(&p->work_available);
+  pthread_mutex_destroy(&p->lock);
+  free(p->threads);
+  free(p->deques);
+  free(p);
+  *pool = NULL;
+}
+
+size_t thread_pool_size(const thread_pool *const pool) {
+  return pool->num_threads;
+}
+
+bool thread_pool_submit(thread_pool *const pool, const task_func_t func,
+                        void *const arg) {
+  task_deque *const dq = (own_deque != NULL && own_deque->pool == pool)
+                             ? own_deque
+                             : &pool->deques[pool->num_threads];
+  atomic_fetch_add(&pool->unfinished, 1);
+  if (!deque_push(dq, (task_t){func, arg})) {
+    atomic_fetch_sub(&pool->unfinished, 1);
+    return false;
+  }
+  atomic_fetch_add(&pool->queued, 1);
+  /*
+   * Workers register as idle before rechecking `queued` under `lock`, so
+   * either they observe the new task or we observe them and wake one.
+   */
+  if (atomic_load(&pool->idle) != 0) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+  }
+  return true;
+}
+
+void thread_pool_wait(thread_pool *const pool) {
+  help_until_zero(pool, &pool->unfinished);
+}
+
+/* - PARALLEL ALGORITHMS - */
+
+typedef void (*chunk_func_t)(size_t chunk, void *op);
+
+typedef struct chunk_task {
+  chunk_func_t func;
+  void *op;
+  size_t chunk;
+  atomic_size_t *pending;
+} chunk_task;
+
+static void run_chunk_task(void *const arg) {
+  chunk_task *const task = arg;
+  task->func(task->chunk, task->op);
+  atomic_fetch_sub_explicit(task->pending, 1, memory_order_release);
+}
+
+/*
+ * Calls `func(i, op)` for every `i` in `[0, num_chunks)` across `pool` and
+ * returns once all calls have completed. The calling thread processes the
+ * first chunk itself and then helps with the rest.
+ * If the task descriptors cannot be allocated, the chunks run serially.
+ */
+static void run_chunks(thread_pool *const pool, const size_t num_chunks,
+                       const chunk_func_t func, void *const op) {
+  if (num_chunks == 0) return;
+  chunk_task *const tasks =
+      num_chunks > 1 ? malloc((num_chunks - 1) * sizeof(chunk_task)) : NULL;
+  if (tasks == NULL) {
+    for (size_t i = 0; i < num_chunks; i++) func(i, op);
+    return;
+  }
+  atomic_size_t pending;
+  atomic_init(&pending, num_chunks - 1);
+  for (size_t i = num_chunks - 1; i > 0; i--) {
+    chunk_task *const task = &tasks[i - 1];
+    task->func = func;
+    task->op = op;
+    task->chunk = i;
+    task->pending = &pending;
+    if (!thread_pool_submit(pool, run_chunk_task, task)) run_chunk_task(task);
+  }
+  func(0, op);
+  help_until_zero(pool, &pending);
+  free(tasks);
+}
+
+static size_t num_chunks_of(const size_t length, const size_t grain) {
+  return (length + grain - 1) / grain;
+}
+
+typedef struct range_op {
+  byte_t *data;
+  size_t length;
+  size_t elem_size;
+  size_t grain;
+  range_func_t func;
+  void *ctx;
+} range_op;
+
+static void range_chunk(const size_t chunk, void *const arg) {
+  const range_op *const op = arg;
+  const size_t BEGIN = chunk * op->grain;
+  const size_t COUNT =
+      (op->length - BEGIN < op->grain) ? op->length - BEGIN : op->grain;
+  op->func(op->data + BEGIN * op->elem_size, COUNT, op->ctx);
+}
+
+void parallel_for_range(thread_pool *const pool, void *const data,
+                        const size_t length, const size_t elem_size,
+                        size_t grain, const range_func_t func,
+                        void *const ctx) {
+  if (grain == 0) grain = DEFAULT_GRAIN_SIZE;
+  range_op op = {data, length, elem_size, grain, func, ctx};
+  run_chunks(pool, num_chunks_of(length, grain), range_chunk, &op);
+}
+
+typedef struct reduce_op {
+  const byte_t *data;
+  size_t length;
+  size_t elem_size;
+  size_t grain;
+  byte_t *partials;
+  size_t result_size;
+  reduce_func_t func;
+  void *ctx;
+} reduce_op;
+
+static void reduce_chunk(const size_t chunk, void *const arg) {
+  const reduce_op *const op = arg;
+  const size_t BEGIN = chunk * op->grain;
+  const size_t COUNT =
+      (op->length - BEGIN < op->grain) ? op->length - BEGIN : op->grain;
+  op->func(op->partials + chunk * op->result_size,
+           op->data + BEGIN * op->elem_size, COUNT, op->ctx);
+}
+
+bool parallel_reduce_range(thread_pool *const pool, const void *const data,
+                           const size_t length, const size_t elem_size,
+                           size_t grain, void *const result,
+                           const size_t result_size, const reduce_func_t func,
+                           const combine_func_t combine, void *const ctx) {
+  if (grain == 0) grain = DEFAULT_GRAIN_SIZE;
+  if (length == 0) return true;
+  const size_t NUM_CHUNKS = num_chunks_of(length, grain);
+  byte_t *const partials = malloc(NUM_CHUNKS * result_size);
+  if (partials == NULL) return false;
+  for (size_t i = 0; i < NUM_CHUNKS; i++)
+    memcpy(partials + i * result_size, result, result_size);
+
+  reduce_op op = {data,     length,      elem_size, grain,
+                  partials, result_size, func,      ctx};
+  run_chunks(pool, NUM_CHUNKS, reduce_chunk, &op);
+  for (size_t i = 0; i < NUM_CHUNKS; i++)
+    combine(result, partials + i * result_size, ctx);
+  free(partials);
+  return true;
+}
+
+typedef struct sort_op {
+  byte_t *src;
+  byte_t *dst;
+  size_t length;
+  size_t elem_size;
+  size_t width; /* Elements per sorted run, or per chunk while sorting. */
+  int (*cmp)(const void *, const void *);
+} sort_op;
+
+static void sort_chunk(const size_t chunk, void *const arg) {
+  const sort_op *const op = arg;
+  const size_t BEGIN = chunk * op->width;
+  const size_t COUNT =
+      (op->length - BEGIN < op->width) ? op->length - BEGIN : op->width;
+  qsort(op->src + BEGIN * op->elem_size, COUNT, op->elem_size, op->cmp);
+}
+
+/* Merges the `chunk`th pair of adjacent sorted runs from `src` into `dst`. */
+static void merge_chunk(const size_t chunk, void *const arg) {
+  const sort_op *const op = arg;
+  const size_t ELEM_SIZE = op->elem_size;
+  const size_t BEGIN = chunk * 2 * op->width;
+  const size_t MID =
+      (op->length - BEGIN < op->width) ? op->length : BEGIN + op->width;
+  const size_t END =
+      (op->length - MID < op->width) ? op->length : MID + op->width;
+
+  size_t left = BEGIN, right = MID, out = BEGIN;
+  while (left < MID && right < END) {
+    const byte_t *const l = op->src + left * ELEM_SIZE;
+    const byte_t *const r = op->src + right * ELEM_SIZE;
+    /* Taking from the left run on ties keeps the merge stable. */
+    if (op->cmp(l, r) <= 0) {
+      memcpy(op->dst + out * ELEM_SIZE, l, ELEM_SIZE);
+      left++;
+    } else {
+      memcpy(op->dst + out * ELEM_SIZE, r, ELEM_SIZE);
+      right++;
+    }
+    out++;
+  }
+  memcpy(op->dst + out * ELEM_SIZE, op->src + left * ELEM_SIZE,
+         (MID - left) * ELEM_SIZE);
+  out += MID - left;
+  memcpy(op->dst + out * ELEM_SIZE, op->src + right * ELEM_SIZE,
+         (END - right) * ELEM_SIZE);
+}
+
+bool parallel_sort_range(thread_pool *const pool, void *const data,
+                         const size_t length, const size_t elem_size,
+                         size_t grain,
+                         int (*const cmp)(const void *, const void *)) {
+  if (grain == 0) grain = DEFAULT_GRAIN_SIZE;
+  if (length <= grain) {
+    qsort(data, length, elem_size, cmp);
+    return true;
+  }
+  byte_t *const buffer = malloc(length * elem_size);
+  if (buffer == NULL) return false;
+
+  sort_op op = {data, buffer, length, elem_size, grain, cmp};
+  run_chunks(pool, num_chunks_of(length, grain), sort_chunk, &op);
+  for (; op.width < length; op.width *= 2) {
+    run_chunks(pool, num_chunks_of(length, op.width * 2), merge_chunk, &op);
+    byte_t *const merged = op.dst;
+    op.dst = op.src;
+    op.src = merged;
+  }
+  /* After an odd number of merge rounds the result lives in `buffer`. */
+  if (op.src != data) memcpy(data, op.src, length * elem_size);
+  free(buffer);
+  return true;
+}
+
+typedef struct transform_op {
+  byte_t *dst;
+  size_t dst_elem_size;
+  const byte_t *src;
+  size_t length;
+  size_t src_elem_size;
+  size_t grain;
+  transform_func_t func;
+  void *ctx;
+} transform_op;
+
+static void transform_chunk(const size_t chunk, void *const arg) {
+  const transform_op *const op = arg;
+  const size_t BEGIN = chunk * op->grain;
+  const size_t COUNT =
+      (op->length - BEGIN < op->grain) ? op->length - BEGIN : op->grain;
+  op->func(op->dst + BEGIN * op->dst_elem_size,
+           op->src + BEGIN * op->src_elem_size, COUNT, op->ctx);
+}
+
+void parallel_transform_range(thread_pool *const pool, void *const dst,
+                              const size_t dst_elem_size, const void *const src,
+                              const size_t length, const size_t src_elem_size,
+                              size_t grain, const transform_func_t func,
+                              void *const ctx) {
+  if (grain == 0) grain = DEFAULT_GRAIN_SIZE;
+  transform_op op = {dst,   dst_elem_size, src,  length,
+                     src_elem_size, grain, func, ctx};
+  run_chunks(pool, num_chunks_of(length, grain), transform_chunk, &op);
+}
@@ -0,0 +1,137 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The number of elements handed to a single task by the parallel algorithms
+ * when a grain size of `0` is requested.
+ */
+#define DEFAULT_GRAIN_SIZE ((size_t)16384)
+
+/*
+ * A fixed set of worker threads, each owning a deque of tasks. Idle workers
+ * steal from the other deques, so tasks spawned from within a task are
+ * balanced across the pool without a central queue becoming a bottleneck.
+ */
+typedef struct thread_pool thread_pool;
+
+typedef void (*task_func_t)(void *arg);
+
+/* Processes `count` consecutive elements starting at `begin`. */
+typedef void (*range_func_t)(void *begin, size_t count, void *ctx);
+
+/*
+ * Folds `count` consecutive elements starting at `begin` into `acc`, which
+ * initially holds a copy of the identity value.
+ */
+typedef void (*reduce_func_t)(void *acc, const void *begin, size_t count,
+                              void *ctx);
+
+/* Folds the partial result `partial` into `acc`. */
+typedef void (*combine_func_t)(void *acc, const void *partial, void *ctx);
+
+/* Writes `count` transformed elements of `src` to `dst`. */
+typedef void (*transform_func_t)(void *dst, const void *src, size_t count,
+                                 void *ctx);
+
+/* clang-format off */
+/*
+ * These are convenience macros for the range-based algorithms below and accept
+ * either an `array_t` or a `vector_t`.
+ * Use with caution if `container` has side effects.
+ */
+#define parallel_for(pool, container, grain, func, ctx)                     \
+  parallel_for_range(pool, (container)->data, (container)->length,          \
+                     (container)->elem_size, grain, func, ctx)
+#define parallel_reduce(pool, container, grain, result, func, combine, ctx)  \
+  parallel_reduce_range(pool, (container)->data, (container)->length,       \
+                        (container)->elem_size, grain, result,              \
+                        sizeof *(result), func, combine, ctx)
+#define parallel_sort(pool, container, grain, cmp)                          \
+  parallel_sort_range(pool, (container)->data, (container)->length,         \
+                      (container)->elem_size, grain, cmp)
+#define parallel_transform(pool, dst, src, grain, func, ctx)                \
+  parallel_transform_range(pool, (dst)->data, (dst)->elem_size,             \
+                           (src)->data, (src)->length, (src)->elem_size,    \
+                           grain, func, ctx)
+/* clang-format on */
+
+/*
+ * Creates a pool of `num_threads` worker threads. Passing `0` creates one
+ * worker per online processor.
+ *
+ * \return A pointer to the new pool or `NULL` upon failure.
+ */
+thread_pool *new_thread_pool(size_t num_threads);
+
+/*
+ * Waits for every submitted task to complete, joins the workers, frees the
+ * memory used by `pool` and invalidates the passed pointer.
+ */
+void delete_thread_pool(thread_pool **pool);
+
+/* Returns the number of worker threads within `pool`. */
+size_t thread_pool_size(const thread_pool *pool);
+
+/*
+ * Schedules `func(arg)` to run on one of the workers of `pool`.
+ * Tasks submitted from a worker are placed on that worker's own deque.
+ *
+ * \return `true` if the task was queued, or `false` upon allocation failure.
+ */
+bool thread_pool_submit(thread_pool *pool, task_func_t func, void *arg);
+
+/*
+ * Blocks until every task submitted to `pool` has completed. The calling
+ * thread executes queued tasks while it waits.
+ */
+void thread_pool_wait(thread_pool *pool);
+
+/*
+ * Calls `func` over `length` elements of `data`, split into chunks of at most
+ * `grain` elements which are processed concurrently.
+ * Returns once every chunk has been processed.
+ */
+void parallel_for_range(thread_pool *pool, void *data, size_t length,
+                        size_t elem_size, size_t grain, range_func_t func,
+                        void *ctx);
+
+/*
+ * Reduces `length` elements of `data` into `result`, which must hold the
+ * identity value upon entry. Each chunk is folded into its own copy of the
+ * identity by `func`, after which the partial results are folded into
+ * `result` by `combine` in ascending order of their chunks.
+ *
+ * \return `true` upon success, or `false` if memory for the partial results
+ * could not be allocated, in which case `result` is unmodified.
+ */
+bool parallel_reduce_range(thread_pool *pool, const void *data, size_t length,
+                           size_t elem_size, size_t grain, void *result,
+                           size_t result_size, reduce_func_t func,
+                           combine_func_t combine, void *ctx);
+
+/*
+ * Sorts `length` elements of `data` according to `cmp`. Chunks of `grain`
+ * elements are sorted concurrently and then merged pairwise.
+ *
+ * \return `true` upon success, or `false` if the merge buffer could not be
+ * allocated, in which case `data` is unmodified.
+ */
+bool parallel_sort_range(thread_pool *pool, void *data, size_t length,
+                         size_t elem_size, size_t grain,
+                         int (*cmp)(const void *, const void *));
+
+/*
+ * Calls `func` to write the transformed counterpart of each of the `length`
+ * elements of `src` into `dst`, which must have room for `length` elements of
+ * `dst_elem_size` bytes. `dst` and `src` may be the same buffer only if
+ * `dst_elem_size` equals `src_elem_size`, and must not overlap otherwise.
+ */
+void parallel_transform_range(thread_pool *pool, void *dst,
+                              size_t dst_elem_size, const void *src,
+                              size_t length, size_t src_elem_size, size_t grain,
+                              transform_func_t func, void *ctx);
+
+#endif
@@ -1,24 +1,46 @@
 #include "binarytree.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "../../allocator/allocator.h"
+#include "../../pool/pool.h"
 #include "../trees.h"
 
+static size_t round_to_alignment(const size_t size, const size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
 binary_tree *_new_binary_tree(const void *const data, const size_t elem_size,
                               const size_t length) {
-  const size_t NODE_SIZE = sizeof(bt_node) + elem_size;
-  const size_t REQUIRED_MEM = length * NODE_SIZE + sizeof(binary_tree);
-  binary_tree *const tree_obj = malloc(REQUIRED_MEM);
-  /* Increment past the tree's data. */
-  bt_node *const nodes_mem = (void *)(tree_obj + 1);
+  return _new_binary_tree_with(data, elem_size, length, NULL);
+}
+
+binary_tree *_new_binary_tree_with(const void *const data,
+                                   const size_t elem_size, const size_t length,
+                                   const allocator_t *const allocator) {
+  /* Round both sizes so every node and its value are suitably aligned. */
+  const size_t NODE_SIZE =
+      round_to_alignment(sizeof(bt_node) + elem_size, DEFAULT_ALIGNMENT);
+  const size_t NODES_OFFSET =
+      round_to_alignment(sizeof(binary_tree), DEFAULT_ALIGNMENT);
+  const size_t REQUIRED_MEM = length * NODE_SIZE + NODES_OFFSET;
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  binary_tree *const tree_obj =
+      ALLOCATOR->alloc(ALLOCATOR->ctx, REQUIRED_MEM, DEFAULT_ALIGNMENT);
   if (tree_obj == NULL) return NULL;
+  /* Increment past the tree's data. */
+  bt_node *const nodes_mem = (void *)((char *)tree_obj + NODES_OFFSET);
 
   tree_obj->num_nodes = length;
   tree_obj->node_size = NODE_SIZE;
+  tree_obj->elem_size = elem_size;
   tree_obj->allocation = REQUIRED_MEM;
+  tree_obj->allocator = ALLOCATOR;
+  pool_init(&tree_obj->node_pool, NODE_SIZE, ALLOCATOR);
 
   for (size_t i = 0; i < length; i++) {
     bt_node *const cur_node = (void *)((char *)nodes_mem + i * NODE_SIZE);
@@ -38,25 +60,325 @@ binary_tree *_new_binary_tree(const void *const data, const size_t elem_size,
     cur_node->parent = parent_node;
     cur_node->left = cur_node->right = NULL;
   }
-  tree_obj->root = nodes_mem; /* The first node is always the root node. */
+  /* The first node is always the root node. */
+  tree_obj->root = (length != 0) ? nodes_mem : NULL;
   return tree_obj;
 }
 
 void delete_binary_tree(binary_tree **const tree) {
-  free(*tree);
+  pool_release(&(*tree)->node_pool);
+  const allocator_t *const ALLOCATOR = (*tree)->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, *tree, (*tree)->allocation,
+                  DEFAULT_ALIGNMENT);
   *tree = NULL;
 }
 
 void delete_binary_tree_s(binary_tree **const tree) {
-  memset(*tree, 0, (*tree)->allocation);
-  delete_binary_tree(tree);
+  pool_release(&(*tree)->node_pool);
+  /* The header is about to be zeroed, so keep what freeing it requires. */
+  const allocator_t *const ALLOCATOR = (*tree)->allocator;
+  const size_t SIZE = (*tree)->allocation;
+  memset(*tree, 0, SIZE);
+  ALLOCATOR->free(ALLOCATOR->ctx, *tree, SIZE, DEFAULT_ALIGNMENT);
+  *tree = NULL;
+}
+
+/* - NODE MANAGEMENT - */
+
+/*
+ * Returns the node after `node` in a pre-order walk of the subtree rooted at
+ * `root`, or `NULL` once the walk is done.
+ */
+static bt_node *next_preorder(const bt_node *node, const bt_node *const root) {
+  if (node->left != NULL) return node->left;
+  if (node->right != NULL) return node->right;
+  while (node != root) {
+    const bt_node *const parent = node->parent;
+    if (node == parent->left && parent->right != NULL) return parent->right;
+    node = parent;
+  }
+  return NULL;
+}
+
+static size_t count_subtree(const bt_node *const root) {
+  size_t count = 0;
+  for (const bt_node *node = root; node != NULL;
+       node = next_preorder(node, root))
+    count++;
+  return count;
+}
+
+/* Returns the first node visited in a post-order walk starting at `node`. */
+static bt_node *first_postorder(bt_node *node) {
+  while (true) {
+    if (node->left != NULL)
+      node = node->left;
+    else if (node->right != NULL)
+      node = node->right;
+    else
+      return node;
+  }
+}
+
+/*
+ * Returns the node after `node` in a post-order walk of the subtree rooted at
+ * `root`, or `NULL` once the walk is done.
+ */
+static bt_node *next_postorder(const bt_node *const node,
+                               const bt_node *const root) {
+  if (node == root) return NULL;
+  bt_node *const parent = node->parent;
+  return (node == parent->left && parent->right != NULL)
+             ? first_postorder(parent->right)
+             : parent;
+}
+
+/* Detaches `target` from its parent, or from `tree` if `target` is the root. */
+static void detach_node(binary_tree *const tree, bt_node *const target) {
+  bt_node *const parent = target->parent;
+  if (parent == NULL) {
+    if (tree->root == target) tree->root = NULL;
+    return;
+  }
+  if (parent->left == target)
+    parent->left = NULL;
+  else
+    parent->right = NULL;
+  target->parent = NULL;
+}
+
+bt_node *add_binary_node(binary_tree *const tree, const void *const elem) {
+  bt_node *const node = pool_alloc(&tree->node_pool);
+  if (node == NULL) return NULL;
+  node->value = (char *)node + sizeof(bt_node);
+  memcpy(node->value, elem, tree->elem_size);
+  node->left = node->right = NULL;
+  tree->num_nodes++;
+  if (tree->root == NULL) {
+    node->parent = NULL;
+    tree->root = node;
+    return node;
+  }
+
+  /*
+   * The bits of the new node's one-based level-order position, below the
+   * leading one, spell out the path from the root: zero is left and one is
+   * right. Removals may leave gaps along that path, in which case the node
+   * takes the first gap; they may also fill its position, in which case the
+   * node descends leftward from there.
+   */
+  const size_t POSITION = tree->num_nodes;
+  size_t bit = 0;
+  while ((POSITION >> (bit + 1)) != 0) bit++;
+  bt_node *parent = tree->root;
+  while (true) {
+    const bool GO_RIGHT = (bit != 0) && ((POSITION >> --bit) & 1);
+    bt_node **const slot = GO_RIGHT ? &parent->right : &parent->left;
+    if (*slot == NULL) {
+      *slot = node;
+      break;
+    }
+    parent = *slot;
+  }
+  node->parent = parent;
+  return node;
+}
+
+bt_node *remove_binary_node(binary_tree *const src, bt_node *const target) {
+  /* A detached subtree's nodes were already subtracted when it was removed. */
+  if (target->parent == NULL && src->root != target) return target;
+  detach_node(src, target);
+  src->num_nodes -= count_subtree(target);
+  return target;
+}
+
+bool reparent_binary_node(binary_tree *const tree, bt_node *const parent,
+                          bt_node *const child) {
+  if (parent->left != NULL && parent->right != NULL) return false;
+  /* Refuse to make a node a descendant of itself. */
+  for (const bt_node *node = parent; node != NULL; node = node->parent)
+    if (node == child) return false;
+  const bool DETACHED = child->parent == NULL && tree->root != child;
+  detach_node(tree, child);
+  if (parent->left == NULL)
+    parent->left = child;
+  else
+    parent->right = child;
+  child->parent = parent;
+  if (DETACHED) tree->num_nodes += count_subtree(child);
+  return true;
+}
+
+void delete_binary_node(binary_tree *const tree, bt_node *const target) {
+  remove_binary_node(tree, target);
+  /* Free the subtree in post-order so no node is read after being freed. */
+  bt_node *node = first_postorder(target);
+  while (true) {
+    bt_node *const next = next_postorder(node, target);
+    pool_free(&tree->node_pool, node);
+    if (next == NULL) break;
+    node = next;
+  }
+}
+
+/* - TRAVERSAL - */
+
+/* Returns the leftmost node of the subtree rooted at `node`. */
+static bt_node *first_inorder(bt_node *node) {
+  while (node->left != NULL) node = node->left;
+  return node;
+}
+
+/*
+ * Returns the node after `node` in an in-order walk of the subtree rooted at
+ * `root`, or `NULL` once the walk is done.
+ */
+static bt_node *next_inorder(const bt_node *node, const bt_node *const root) {
+  if (node->right != NULL) return first_inorder(node->right);
+  while (node != root) {
+    bt_node *const parent = node->parent;
+    if (node == parent->left) return parent;
+    node = parent;
+  }
+  return NULL;
+}
+
+static void enqueue(bt_iter *const iter, bt_node *const node) {
+  if (node != NULL && iter->queue_tail < iter->queue_capacity)
+    iter->queue[iter->queue_tail++] = node;
+}
+
+bool bt_iter_init(bt_iter *const iter, const binary_tree *const tree,
+                  const bt_order order) {
+  bt_node *const root = tree->root;
+  iter->root = root;
+  iter->order = order;
+  iter->queue = NULL;
+  iter->queue_head = iter->queue_tail = iter->queue_capacity = 0;
+  if (root == NULL) {
+    iter->next = NULL;
+    return true;
+  }
+  switch (order) {
+    case BT_PREORDER:
+      iter->next = root;
+      break;
+    case BT_INORDER:
+      iter->next = first_inorder(root);
+      break;
+    case BT_POSTORDER:
+      iter->next = first_postorder(root);
+      break;
+    case BT_LEVEL_ORDER: {
+      /*
+       * Every node is enqueued exactly once, so one queue of `num_nodes`
+       * slots serves the whole walk without wrapping or growing.
+       */
+      const allocator_t *const ALLOCATOR = tree->allocator;
+      const size_t SIZE = tree->num_nodes * sizeof(bt_node *);
+      iter->queue = ALLOCATOR->alloc(ALLOCATOR->ctx, SIZE, DEFAULT_ALIGNMENT);
+      if (iter->queue == NULL) {
+        iter->next = NULL;
+        return false;
+      }
+      iter->queue_capacity = tree->num_nodes;
+      iter->allocator = ALLOCATOR;
+      iter->next = root;
+      enqueue(iter, root->left);
+      enqueue(iter, root->right);
+      break;
+    }
+  }
+  return true;
+}
+
+bt_node *bt_iter_next(bt_iter *const iter) {
+  bt_node *const node = iter->next;
+  if (node == NULL) return NULL;
+  switch (iter->order) {
+    case BT_PREORDER:
+      iter->next = next_preorder(node, iter->root);
+      break;
+    case BT_INORDER:
+      iter->next = next_inorder(node, iter->root);
+      break;
+    case BT_POSTORDER:
+      iter->next = next_postorder(node, iter->root);
+      break;
+    case BT_LEVEL_ORDER:
+      if (iter->queue_head == iter->queue_tail) {
+        iter->next = NULL;
+        break;
+      }
+      iter->next = iter->queue[iter->queue_head++];
+      enqueue(iter, iter->next->left);
+      enqueue(iter, iter->next->right);
+      break;
+  }
+  return node;
+}
+
+void bt_iter_release(bt_iter *const iter) {
+  if (iter->queue != NULL) {
+    const allocator_t *const ALLOCATOR = iter->allocator;
+    ALLOCATOR->free(ALLOCATOR->ctx, iter->queue,
+                    iter->queue_capacity * sizeof(bt_node *),
+                    DEFAULT_ALIGNMENT);
+  }
+  iter->queue = NULL;
+  iter->next = NULL;
 }
 
-bt_node *unparent_node(binary_tree *const src, bt_node *const target);
+size_t traverse_binary_tree(const binary_tree *const tree,
+                            const bt_order order, const bt_visit_t visit,
+                            void *const ctx) {
+  bt_iter iter;
+  if (!bt_iter_init(&iter, tree, order)) return 0;
+  size_t visited = 0;
+  for (bt_node *node; (node = bt_iter_next(&iter)) != NULL;) {
+    visited++;
+    if (!visit(node, ctx)) break;
+  }
+  bt_iter_release(&iter);
+  return visited;
+}
+
+/* Starts loading `node`, its value and its children's links into cache. */
+static void prefetch_node(const bt_node *const node) {
+#if defined(__GNUC__)
+  if (node == NULL) return;
+  __builtin_prefetch(node->value);
+  if (node->left != NULL) __builtin_prefetch(node->left);
+  if (node->right != NULL) __builtin_prefetch(node->right);
+#else
+  (void)node;
+#endif
+}
+
+size_t traverse_binary_tree_prefetch(const binary_tree *const tree,
+                                     const bt_order order,
+                                     const bt_visit_t visit, void *const ctx) {
+  bt_iter iter;
+  if (!bt_iter_init(&iter, tree, order)) return 0;
+  size_t visited = 0;
+  /*
+   * Stepping the iterator before the visit leaves `iter.next` holding the
+   * following node, whose lines then load while `visit` runs. Neither the
+   * step nor the visit may modify the tree, so the early step is safe.
+   */
+  for (bt_node *node; (node = bt_iter_next(&iter)) != NULL;) {
+    prefetch_node(iter.next);
+    visited++;
+    if (!visit(node, ctx)) break;
+  }
+  bt_iter_release(&iter);
+  return visited;
+}
 
 int main(void) {
   static const int data[] = {1, 2, 3, 4, 5, 6, 7};
   binary_tree *a = new_binary_tree(data, sizeof data / sizeof *data);
+  delete_tree(a);
 
   return 0;
 }
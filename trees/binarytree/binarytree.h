@@ -1,8 +1,11 @@
 #ifndef BINARYTREE_H
 #define BINARYTREE_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
+#include "../../allocator/allocator.h"
+#include "../../pool/pool.h"
 #include "../trees.h"
 
 typedef struct bt_node {
@@ -11,12 +14,23 @@ typedef struct bt_node {
   struct bt_node *left, *right;
 } bt_node;
 
+/* The orders in which the nodes of a `binary_tree` may be traversed. */
+typedef enum bt_order {
+  BT_PREORDER,
+  BT_INORDER,
+  BT_POSTORDER,
+  BT_LEVEL_ORDER
+} bt_order;
+
 /* Container structure for a binary tree data structure. */
 typedef struct {
   bt_node *root;
   size_t num_nodes;
   size_t node_size;
+  size_t elem_size;
   size_t allocation; /* Total bytes allocated for the tree and nodes. */
+  const allocator_t *allocator;
+  pool_t node_pool; /* Supplies nodes added after creation. */
 } binary_tree;
 
 /*
@@ -25,6 +39,8 @@ typedef struct {
  */
 #define new_binary_tree(data, length) \
   _new_binary_tree(data, sizeof *(data), length)
+#define new_binary_tree_with(data, length, allocator) \
+  _new_binary_tree_with(data, sizeof *(data), length, allocator)
 
 /*
  * Initializes a binary tree with the given elements from the passed array.
@@ -44,6 +60,14 @@ typedef struct {
 binary_tree *_new_binary_tree(const void *data, size_t elem_size,
                               size_t length);
 
+/*
+ * Same as `_new_binary_tree()`, except the tree's memory is obtained from and
+ * returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+binary_tree *_new_binary_tree_with(const void *data, size_t elem_size,
+                                   size_t length,
+                                   const allocator_t *allocator);
+
 /*
  * Frees the passed binary tree's consumed memory and reassigns its pointer
  * to `NULL`.
@@ -57,14 +81,18 @@ void delete_binary_tree(binary_tree **tree);
 void delete_binary_tree_s(binary_tree **tree);
 
 /*
- * Adds the specified element as a child node of `parent_node`.
+ * Adds a copy of `elem` to `tree` at the next free position in level order,
+ * keeping a tree which has only grown complete. The node comes from the
+ * tree's node pool, so no allocation occurs once removed nodes are recycled.
+ *
  * \return A pointer to the added node, or NULL upon failure.
  */
 bt_node *add_binary_node(binary_tree *tree, const void *elem);
 
 /*
  * Removes `target` from `src`, thereby causing `target` to have no parent
- * (assumed `NULL`).
+ * (assumed `NULL`). The children of `target` remain attached to it. Nothing
+ * happens if `target` is already detached.
  *
  * \return The removed node.
  */
@@ -72,7 +100,82 @@ bt_node *remove_binary_node(binary_tree *src, bt_node *target);
 
 /*
  * This function makes `child` a child node of `parent`, including any child
- * nodes.
+ * nodes. `child` is detached from its current parent first, and may also be
+ * a subtree previously removed from `tree`.
+ *
+ * \return `true` upon success or `false` if `parent` has no free child slot
+ * or is `child` itself or one of its descendants.
+ */
+bool reparent_binary_node(binary_tree *tree, bt_node *parent, bt_node *child);
+
+/*
+ * Removes `target` from `tree` if it is still attached, then returns it and
+ * all of its descendants to the tree's node pool for reuse.
+ */
+void delete_binary_node(binary_tree *tree, bt_node *target);
+
+/* - TRAVERSAL - */
+
+/*
+ * Receives each node of a traversal along with the caller's `ctx`.
+ *
+ * \return `true` to continue the traversal or `false` to stop it.
+ */
+typedef bool (*bt_visit_t)(bt_node *node, void *ctx);
+
+/*
+ * An iterator over the nodes of a `binary_tree`.
+ *
+ * Pre-order, in-order and post-order iterators step along parent links and
+ * so need neither recursion nor a stack, whatever the depth of the tree. A
+ * level-order iterator allocates a queue with room for every node once, when
+ * it is initialized.
+ *
+ * The tree must not be modified while an iterator over it is in use.
+ */
+typedef struct bt_iter {
+  bt_node *next; /* The node the next step returns. */
+  const bt_node *root;
+  bt_order order;
+  bt_node **queue; /* Level order only. */
+  size_t queue_head, queue_tail, queue_capacity;
+  const allocator_t *allocator; /* Level order only. */
+} bt_iter;
+
+/*
+ * Prepares `iter` to visit the nodes of `tree` in `order`.
+ *
+ * \return `true` upon success or `false` if a level-order queue could not be
+ * allocated.
+ */
+bool bt_iter_init(bt_iter *iter, const binary_tree *tree, bt_order order);
+
+/*
+ * Advances `iter`.
+ *
+ * \return The next node or `NULL` once every node has been visited.
  */
-void reparent_binary_node(const bt_node *parent, const bt_node *child);
+bt_node *bt_iter_next(bt_iter *iter);
+
+/* Frees any memory held by `iter`. */
+void bt_iter_release(bt_iter *iter);
+
+/*
+ * Passes each node of `tree` to `visit` in `order` until `visit` returns
+ * `false`.
+ *
+ * \return The number of nodes visited, or zero if a level-order queue could
+ * not be allocated.
+ */
+size_t traverse_binary_tree(const binary_tree *tree, bt_order order,
+                            bt_visit_t visit, void *ctx);
+
+/*
+ * Same as `traverse_binary_tree()`, except the node after the one being
+ * visited, along with its value and children, is prefetched first, so their
+ * cache misses overlap with the visit instead of following it.
+ */
+size_t traverse_binary_tree_prefetch(const binary_tree *tree, bt_order order,
+                                     bt_visit_t visit, void *ctx);
+
 #endif
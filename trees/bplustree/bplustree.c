@@ -0,0 +1,582 @@
+#include "bplustree.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../allocator/allocator.h"
+#include "../../dispatch/dispatch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS (1)
+#else
+#define HAVE_X86_KERNELS (0)
+#endif
+
+typedef unsigned char byte_t;
+
+/*
+ * Every node starts with its number of keys. An inner node continues with
+ * `count + 1` child pointers and then its keys, while a leaf continues with
+ * its links and then its keys and values.
+ */
+typedef struct bp_node {
+  size_t count;
+} bp_node;
+
+typedef struct bp_leaf {
+  size_t count;
+  struct bp_leaf *prev, *next;
+} bp_leaf;
+
+static size_t round_to_alignment(const size_t size, const size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+#define LEAF_KEYS_OFFSET \
+  (round_to_alignment(sizeof(bp_leaf), DEFAULT_ALIGNMENT))
+
+static byte_t *leaf_key(const bplus_tree_t *const tree, bp_leaf *const leaf,
+                        const size_t index) {
+  return (byte_t *)leaf + LEAF_KEYS_OFFSET + index * tree->key_size;
+}
+
+static byte_t *leaf_value(const bplus_tree_t *const tree, bp_leaf *const leaf,
+                          const size_t index) {
+  return (byte_t *)leaf + tree->leaf_values_offset + index * tree->value_size;
+}
+
+static void **inner_children(bp_node *const node) {
+  return (void **)(node + 1);
+}
+
+static byte_t *inner_key(const bplus_tree_t *const tree, bp_node *const node,
+                         const size_t index) {
+  return (byte_t *)node + tree->inner_keys_offset + index * tree->key_size;
+}
+
+static bool keys_equal(const bplus_tree_t *const tree, const void *const a,
+                       const void *const b) {
+  if (tree->cmp != NULL) return tree->cmp(a, b) == 0;
+  return memcmp(a, b, sizeof(int64_t)) == 0;
+}
+
+/* - IN-NODE SEARCH - */
+
+static size_t rank_generic(const bplus_tree_t *const tree,
+                           const void *const keys, const size_t count,
+                           const void *const key, const bool inclusive) {
+  size_t low = 0, high = count;
+  while (low < high) {
+    const size_t MID = low + (high - low) / 2;
+    const int ORDER =
+        tree->cmp((const byte_t *)keys + MID * tree->key_size, key);
+    if (ORDER < 0 || (inclusive && ORDER == 0))
+      low = MID + 1;
+    else
+      high = MID;
+  }
+  return low;
+}
+
+/*
+ * Turns an inclusive search for `key` into an exclusive one for the next
+ * integer, so the kernels only need one comparison.
+ *
+ * \return `false` if every key is ordered before or equal to `key`.
+ */
+static bool exclusive_needle(const void *const key, const bool inclusive,
+                             int64_t *const needle) {
+  memcpy(needle, key, sizeof(*needle));
+  if (!inclusive) return true;
+  if (*needle == INT64_MAX) return false;
+  (*needle)++;
+  return true;
+}
+
+static size_t rank_i64_scalar(const bplus_tree_t *const tree,
+                              const void *const keys, const size_t count,
+                              const void *const key, const bool inclusive) {
+  (void)tree;
+  int64_t needle;
+  if (!exclusive_needle(key, inclusive, &needle)) return count;
+  const int64_t *const KEYS = keys;
+  size_t rank = 0;
+  for (size_t i = 0; i < count; i++) rank += (KEYS[i] < needle);
+  return rank;
+}
+
+#if HAVE_X86_KERNELS
+/*
+ * Since the keys are sorted, the number of keys below the needle is the
+ * needle's position. Counting them compares every key with the needle in
+ * a few vector instructions and never mispredicts a branch.
+ */
+/* clang-format off */
+#define DEFINE_RANK_I64(isa, ATTR, bytes)                                     \
+  typedef int64_t i64_v##bytes __attribute__((vector_size(bytes)));           \
+                                                                              \
+  ATTR static size_t rank_i64_##isa(const bplus_tree_t *const tree,           \
+                                    const void *const keys,                   \
+                                    const size_t count,                       \
+                                    const void *const key,                    \
+                                    const bool inclusive) {                   \
+    (void)tree;                                                               \
+    int64_t needle;                                                           \
+    if (!exclusive_needle(key, inclusive, &needle)) return count;             \
+    const int64_t *const KEYS = keys;                                         \
+    const size_t LANES = (bytes) / sizeof(int64_t);                           \
+    i64_v##bytes needles, below = {0};                                        \
+    for (size_t l = 0; l < LANES; l++) needles[l] = needle;                   \
+    size_t i = 0;                                                             \
+    for (; i + LANES <= count; i += LANES) {                                  \
+      i64_v##bytes block;                                                     \
+      memcpy(&block, KEYS + i, sizeof(block));                                \
+      below -= (i64_v##bytes)(block < needles);                               \
+    }                                                                         \
+    size_t rank = 0;                                                          \
+    for (size_t l = 0; l < LANES; l++) rank += (size_t)below[l];              \
+    for (; i < count; i++) rank += (KEYS[i] < needle);                        \
+    return rank;                                                              \
+  }
+/* clang-format on */
+
+DEFINE_RANK_I64(sse2, __attribute__((target("sse2"))), 16)
+DEFINE_RANK_I64(avx2, __attribute__((target("avx2"))), 32)
+DEFINE_RANK_I64(avx512,
+                __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl"))),
+                64)
+#endif
+
+/* Levels without kernels on this architecture are never selected. */
+static const bplus_rank_t RANK_I64[SIMD_LEVEL_COUNT] = {
+    [SIMD_SCALAR] = rank_i64_scalar,
+#if HAVE_X86_KERNELS
+    [SIMD_SSE2] = rank_i64_sse2,
+    [SIMD_AVX2] = rank_i64_avx2,
+    [SIMD_AVX512] = rank_i64_avx512,
+#endif
+};
+
+/* - CREATION AND DELETION - */
+
+static void *alloc_node(const bplus_tree_t *const tree) {
+  const allocator_t *const ALLOCATOR = tree->allocator;
+  return ALLOCATOR->alloc(ALLOCATOR->ctx, tree->node_size, BPLUS_CACHE_LINE);
+}
+
+static void free_node(const bplus_tree_t *const tree, void *const node) {
+  const allocator_t *const ALLOCATOR = tree->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, node, tree->node_size, BPLUS_CACHE_LINE);
+}
+
+/* Frees `node` and, unless it is a leaf, the `levels` below it. */
+static void free_subtree(const bplus_tree_t *const tree, bp_node *const node,
+                         const size_t levels) {
+  if (levels != 0) {
+    for (size_t i = 0; i <= node->count; i++)
+      free_subtree(tree, inner_children(node)[i], levels - 1);
+  }
+  free_node(tree, node);
+}
+
+bplus_tree_t *new_bplus_tree(const size_t key_size, const size_t value_size,
+                             const size_t node_lines, const bplus_cmp_t cmp) {
+  return new_bplus_tree_with(key_size, value_size, node_lines, cmp, NULL);
+}
+
+bplus_tree_t *new_bplus_tree_with(const size_t key_size,
+                                  const size_t value_size,
+                                  const size_t node_lines,
+                                  const bplus_cmp_t cmp,
+                                  const allocator_t *const allocator) {
+  if (key_size == 0 || (cmp == NULL && key_size != sizeof(int64_t)))
+    return NULL;
+  const size_t NODE_SIZE = node_lines * BPLUS_CACHE_LINE;
+  if (NODE_SIZE <= LEAF_KEYS_OFFSET) return NULL;
+
+  /* Find the most keys, and values, each kind of node has room for. */
+  size_t leaf_capacity =
+      (NODE_SIZE - LEAF_KEYS_OFFSET) / (key_size + value_size);
+  size_t values_offset = 0;
+  for (; leaf_capacity != 0; leaf_capacity--) {
+    values_offset = round_to_alignment(
+        LEAF_KEYS_OFFSET + leaf_capacity * key_size, DEFAULT_ALIGNMENT);
+    if (values_offset + leaf_capacity * value_size <= NODE_SIZE) break;
+  }
+  size_t inner_capacity =
+      (NODE_SIZE - sizeof(bp_node)) / (key_size + sizeof(void *));
+  size_t keys_offset = 0;
+  for (; inner_capacity != 0; inner_capacity--) {
+    keys_offset = round_to_alignment(
+        sizeof(bp_node) + (inner_capacity + 1) * sizeof(void *),
+        DEFAULT_ALIGNMENT);
+    if (keys_offset + inner_capacity * key_size <= NODE_SIZE) break;
+  }
+  if (leaf_capacity < 3 || inner_capacity < 3) return NULL;
+
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  bplus_tree_t *const tree = ALLOCATOR->alloc(
+      ALLOCATOR->ctx, sizeof(bplus_tree_t) + 2 * key_size, DEFAULT_ALIGNMENT);
+  if (tree == NULL) return NULL;
+  tree->key_size = key_size;
+  tree->value_size = value_size;
+  tree->node_size = NODE_SIZE;
+  tree->leaf_capacity = leaf_capacity;
+  tree->inner_capacity = inner_capacity;
+  tree->leaf_values_offset = values_offset;
+  tree->inner_keys_offset = keys_offset;
+  tree->cmp = cmp;
+  tree->rank = (cmp != NULL) ? rank_generic : RANK_I64[get_simd_level()];
+  tree->scratch = (byte_t *)(tree + 1);
+  tree->allocator = ALLOCATOR;
+  tree->length = 0;
+  tree->height = 1;
+  bp_leaf *const root = alloc_node(tree);
+  if (root == NULL) {
+    ALLOCATOR->free(ALLOCATOR->ctx, tree, sizeof(bplus_tree_t) + 2 * key_size,
+                    DEFAULT_ALIGNMENT);
+    return NULL;
+  }
+  root->count = 0;
+  root->prev = root->next = NULL;
+  tree->root = tree->first_leaf = tree->last_leaf = root;
+  return tree;
+}
+
+void delete_bplus_tree(bplus_tree_t **const tree) {
+  free_subtree(*tree, (*tree)->root, (*tree)->height - 1);
+  const allocator_t *const ALLOCATOR = (*tree)->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, *tree,
+                  sizeof(bplus_tree_t) + 2 * (*tree)->key_size,
+                  DEFAULT_ALIGNMENT);
+  *tree = NULL;
+}
+
+bplus_tree_t *bplus_bulk_load(const size_t key_size, const size_t value_size,
+                              const size_t node_lines, const bplus_cmp_t cmp,
+                              const void *const keys, const void *const values,
+                              const size_t count,
+                              const allocator_t *const allocator) {
+  bplus_tree_t *tree =
+      new_bplus_tree_with(key_size, value_size, node_lines, cmp, allocator);
+  if (tree == NULL || count == 0) return tree;
+
+  /* Allocate every node up front, so failure leaves nothing to unpick. */
+  const size_t LEAVES =
+      (count + tree->leaf_capacity - 1) / tree->leaf_capacity;
+  const size_t FANOUT = tree->inner_capacity + 1;
+  size_t total = LEAVES;
+  for (size_t width = LEAVES; width > 1; total += width)
+    width = (width + FANOUT - 1) / FANOUT;
+  void **const nodes = malloc(total * sizeof(void *) + LEAVES * sizeof(void *));
+  if (nodes == NULL) {
+    delete_bplus_tree(&tree);
+    return NULL;
+  }
+  size_t allocated = 0;
+  for (; allocated < total; allocated++) {
+    nodes[allocated] = alloc_node(tree);
+    if (nodes[allocated] == NULL) break;
+  }
+  if (allocated != total) {
+    while (allocated != 0) free_node(tree, nodes[--allocated]);
+    free(nodes);
+    delete_bplus_tree(&tree);
+    return NULL;
+  }
+  free_node(tree, tree->root);
+  /* The least key beneath each node of the level being built upon. */
+  const void **const least = (const void **)(nodes + total);
+
+  /* Spread the pairs evenly over the leaves and link them in order. */
+  size_t taken = 0;
+  for (size_t i = 0; i < LEAVES; i++) {
+    bp_leaf *const leaf = nodes[i];
+    leaf->count = count / LEAVES + (i < count % LEAVES);
+    leaf->prev = (i != 0) ? nodes[i - 1] : NULL;
+    leaf->next = (i + 1 != LEAVES) ? nodes[i + 1] : NULL;
+    memcpy(leaf_key(tree, leaf, 0), (const byte_t *)keys + taken * key_size,
+           leaf->count * key_size);
+    memcpy(leaf_value(tree, leaf, 0),
+           (const byte_t *)values + taken * value_size,
+           leaf->count * value_size);
+    least[i] = leaf_key(tree, leaf, 0);
+    taken += leaf->count;
+  }
+  tree->first_leaf = nodes[0];
+  tree->last_leaf = nodes[LEAVES - 1];
+  tree->length = count;
+
+  /* Build each level of inner nodes over the one below it. */
+  size_t level_start = 0, width = LEAVES;
+  tree->height = 1;
+  while (width > 1) {
+    const size_t PARENTS = (width + FANOUT - 1) / FANOUT;
+    size_t child = 0;
+    for (size_t i = 0; i < PARENTS; i++) {
+      bp_node *const parent = nodes[level_start + width + i];
+      const size_t CHILDREN = width / PARENTS + (i < width % PARENTS);
+      parent->count = CHILDREN - 1;
+      for (size_t c = 0; c < CHILDREN; c++) {
+        inner_children(parent)[c] = nodes[level_start + child + c];
+        if (c != 0)
+          memcpy(inner_key(tree, parent, c - 1), least[child + c], key_size);
+      }
+      /* A parent's least key is its first child's, found at or after `i`. */
+      least[i] = least[child];
+      child += CHILDREN;
+    }
+    level_start += width;
+    width = PARENTS;
+    tree->height++;
+  }
+  tree->root = nodes[level_start];
+  free(nodes);
+  return tree;
+}
+
+/* - INSERTION - */
+
+static void leaf_insert_at(const bplus_tree_t *const tree, bp_leaf *const leaf,
+                           const size_t index, const void *const key,
+                           const void *const value) {
+  const size_t MOVED = leaf->count - index;
+  memmove(leaf_key(tree, leaf, index + 1), leaf_key(tree, leaf, index),
+          MOVED * tree->key_size);
+  memmove(leaf_value(tree, leaf, index + 1), leaf_value(tree, leaf, index),
+          MOVED * tree->value_size);
+  memcpy(leaf_key(tree, leaf, index), key, tree->key_size);
+  memcpy(leaf_value(tree, leaf, index), value, tree->value_size);
+  leaf->count++;
+}
+
+/* Inserts `key` at `index` of `node`, with `child` to the right of it. */
+static void inner_insert_at(const bplus_tree_t *const tree,
+                            bp_node *const node, const size_t index,
+                            const void *const key, void *const child) {
+  const size_t MOVED = node->count - index;
+  memmove(inner_key(tree, node, index + 1), inner_key(tree, node, index),
+          MOVED * tree->key_size);
+  memcpy(inner_key(tree, node, index), key, tree->key_size);
+  void **const children = inner_children(node);
+  memmove(children + index + 2, children + index + 1,
+          MOVED * sizeof(void *));
+  children[index + 1] = child;
+  node->count++;
+}
+
+/*
+ * Splits the full `leaf` into itself and `right`, then inserts the pair at
+ * `index` into whichever half it belongs in.
+ */
+static void split_leaf(bplus_tree_t *const tree, bp_leaf *const leaf,
+                       bp_leaf *const right, const size_t index,
+                       const void *const key, const void *const value) {
+  const size_t KEPT = tree->leaf_capacity / 2;
+  right->count = leaf->count - KEPT;
+  memcpy(leaf_key(tree, right, 0), leaf_key(tree, leaf, KEPT),
+         right->count * tree->key_size);
+  memcpy(leaf_value(tree, right, 0), leaf_value(tree, leaf, KEPT),
+         right->count * tree->value_size);
+  leaf->count = KEPT;
+  right->prev = leaf;
+  right->next = leaf->next;
+  if (leaf->next != NULL)
+    leaf->next->prev = right;
+  else
+    tree->last_leaf = right;
+  leaf->next = right;
+  if (index <= KEPT)
+    leaf_insert_at(tree, leaf, index, key, value);
+  else
+    leaf_insert_at(tree, right, index - KEPT, key, value);
+}
+
+/*
+ * Splits the full inner `node` into itself and `right`, copying the key
+ * which separates them to `promoted`, then inserts `key` and `child` at
+ * `index` into whichever half they belong in.
+ */
+static void split_inner(const bplus_tree_t *const tree, bp_node *const node,
+                        bp_node *const right, const size_t index,
+                        const void *const key, void *const child,
+                        void *const promoted) {
+  const size_t MID = tree->inner_capacity / 2;
+  memcpy(promoted, inner_key(tree, node, MID), tree->key_size);
+  right->count = node->count - MID - 1;
+  memcpy(inner_key(tree, right, 0), inner_key(tree, node, MID + 1),
+         right->count * tree->key_size);
+  memcpy(inner_children(right), inner_children(node) + MID + 1,
+         (right->count + 1) * sizeof(void *));
+  node->count = MID;
+  if (index <= MID)
+    inner_insert_at(tree, node, index, key, child);
+  else
+    inner_insert_at(tree, right, index - MID - 1, key, child);
+}
+
+bool bplus_insert(bplus_tree_t *const tree, const void *const key,
+                  const void *const value) {
+  bp_node *path[BPLUS_MAX_HEIGHT];
+  size_t slots[BPLUS_MAX_HEIGHT];
+  const size_t INNER_LEVELS = tree->height - 1;
+  bp_node *node = tree->root;
+  for (size_t level = 0; level < INNER_LEVELS; level++) {
+    const size_t SLOT = tree->rank(tree, inner_key(tree, node, 0), node->count,
+                                   key, true);
+    path[level] = node;
+    slots[level] = SLOT;
+    node = inner_children(node)[SLOT];
+  }
+  bp_leaf *const leaf = (bp_leaf *)node;
+  const size_t INDEX =
+      tree->rank(tree, leaf_key(tree, leaf, 0), leaf->count, key, false);
+  if (INDEX < leaf->count &&
+      keys_equal(tree, leaf_key(tree, leaf, INDEX), key)) {
+    memcpy(leaf_value(tree, leaf, INDEX), value, tree->value_size);
+    return true;
+  }
+  if (leaf->count < tree->leaf_capacity) {
+    leaf_insert_at(tree, leaf, INDEX, key, value);
+    tree->length++;
+    return true;
+  }
+
+  /*
+   * Count the full ancestors which will split along with the leaf, plus a new
+   * root if every one of them does, and allocate every new node first so a
+   * failure leaves the tree untouched.
+   */
+  size_t splits = 1;
+  while (splits <= INNER_LEVELS &&
+         path[INNER_LEVELS - splits]->count == tree->inner_capacity)
+    splits++;
+  const bool NEW_ROOT = splits > INNER_LEVELS;
+  if (NEW_ROOT && tree->height == BPLUS_MAX_HEIGHT) return false;
+  void *fresh[BPLUS_MAX_HEIGHT + 1];
+  const size_t NEEDED = splits + NEW_ROOT;
+  for (size_t i = 0; i < NEEDED; i++) {
+    fresh[i] = alloc_node(tree);
+    if (fresh[i] == NULL) {
+      while (i != 0) free_node(tree, fresh[--i]);
+      return false;
+    }
+  }
+
+  bp_leaf *const right = fresh[0];
+  split_leaf(tree, leaf, right, INDEX, key, value);
+  tree->length++;
+  /* The separator to insert into the parent and the node to its right. */
+  const void *separator = leaf_key(tree, right, 0);
+  void *sibling = right;
+  for (size_t i = 1; i < splits; i++) {
+    const size_t LEVEL = INNER_LEVELS - i;
+    /* Alternate halves of the scratch space, as `separator` uses one. */
+    byte_t *const promoted = tree->scratch + (i & 1) * tree->key_size;
+    split_inner(tree, path[LEVEL], fresh[i], slots[LEVEL], separator, sibling,
+                promoted);
+    separator = promoted;
+    sibling = fresh[i];
+  }
+  if (NEW_ROOT) {
+    bp_node *const root = fresh[splits];
+    root->count = 1;
+    memcpy(inner_key(tree, root, 0), separator, tree->key_size);
+    inner_children(root)[0] = tree->root;
+    inner_children(root)[1] = sibling;
+    tree->root = root;
+    tree->height++;
+  } else {
+    const size_t LEVEL = INNER_LEVELS - splits;
+    inner_insert_at(tree, path[LEVEL], slots[LEVEL], separator, sibling);
+  }
+  return true;
+}
+
+/* - LOOKUP AND ITERATION - */
+
+/* Descends to the leaf whose range of keys covers `key`. */
+static bp_leaf *find_leaf(const bplus_tree_t *const tree,
+                          const void *const key) {
+  bp_node *node = tree->root;
+  for (size_t level = 1; level < tree->height; level++) {
+    const size_t SLOT = tree->rank(tree, inner_key(tree, node, 0), node->count,
+                                   key, true);
+    node = inner_children(node)[SLOT];
+  }
+  return (bp_leaf *)node;
+}
+
+void *bplus_find(const bplus_tree_t *const tree, const void *const key) {
+  bp_leaf *const leaf = find_leaf(tree, key);
+  const size_t INDEX =
+      tree->rank(tree, leaf_key(tree, leaf, 0), leaf->count, key, false);
+  if (INDEX < leaf->count && keys_equal(tree, leaf_key(tree, leaf, INDEX), key))
+    return leaf_value(tree, leaf, INDEX);
+  return NULL;
+}
+
+/* Returns an iterator at `index` of `leaf`, moving on if that is past it. */
+static bplus_iter make_iter(const bplus_tree_t *const tree, bp_leaf *leaf,
+                            size_t index) {
+  if (leaf != NULL && index == leaf->count) {
+    leaf = leaf->next;
+    index = 0;
+  }
+  return (bplus_iter){tree, leaf, index};
+}
+
+bplus_iter bplus_first(const bplus_tree_t *const tree) {
+  return make_iter(tree, tree->first_leaf, 0);
+}
+
+bplus_iter bplus_last(const bplus_tree_t *const tree) {
+  bp_leaf *const leaf = tree->last_leaf;
+  if (leaf->count == 0) return (bplus_iter){tree, NULL, 0};
+  return (bplus_iter){tree, leaf, leaf->count - 1};
+}
+
+bplus_iter bplus_lower_bound(const bplus_tree_t *const tree,
+                             const void *const key) {
+  bp_leaf *const leaf = find_leaf(tree, key);
+  return make_iter(
+      tree, leaf,
+      tree->rank(tree, leaf_key(tree, leaf, 0), leaf->count, key, false));
+}
+
+bplus_iter bplus_upper_bound(const bplus_tree_t *const tree,
+                             const void *const key) {
+  bp_leaf *const leaf = find_leaf(tree, key);
+  return make_iter(
+      tree, leaf,
+      tree->rank(tree, leaf_key(tree, leaf, 0), leaf->count, key, true));
+}
+
+bool bplus_iter_valid(const bplus_iter *const iter) {
+  return iter->leaf != NULL;
+}
+
+void bplus_iter_next(bplus_iter *const iter) {
+  *iter = make_iter(iter->tree, iter->leaf, iter->index + 1);
+}
+
+void bplus_iter_prev(bplus_iter *const iter) {
+  bp_leaf *const leaf = iter->leaf;
+  if (iter->index != 0) {
+    iter->index--;
+    return;
+  }
+  iter->leaf = leaf->prev;
+  iter->index = (leaf->prev != NULL) ? leaf->prev->count - 1 : 0;
+}
+
+const void *bplus_iter_key(const bplus_iter *const iter) {
+  return leaf_key(iter->tree, iter->leaf, iter->index);
+}
+
+void *bplus_iter_value(const bplus_iter *const iter) {
+  return leaf_value(iter->tree, iter->leaf, iter->index);
+}
@@ -0,0 +1,148 @@
+#ifndef BPLUSTREE_H
+#define BPLUSTREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../allocator/allocator.h"
+
+/* The size and alignment of a cache line, the unit of a node's size. */
+#define BPLUS_CACHE_LINE ((size_t)64)
+
+/* The greatest number of levels a tree may have. */
+#define BPLUS_MAX_HEIGHT (48)
+
+/*
+ * Orders two keys, returning a negative value if `a` sorts before `b`, a
+ * positive value if after, and zero if they are equal.
+ */
+typedef int (*bplus_cmp_t)(const void *a, const void *b);
+
+struct bplus_tree_t;
+
+/*
+ * Counts the keys among the first `count` of `keys` which are ordered before
+ * `key`, or before or equal to it if `inclusive` is set.
+ */
+typedef size_t (*bplus_rank_t)(const struct bplus_tree_t *tree,
+                               const void *keys, size_t count,
+                               const void *key, bool inclusive);
+
+/*
+ * An in-memory B+ tree mapping unique, fixed-size keys to fixed-size values.
+ *
+ * Every node is the same whole number of cache lines, so one node holds
+ * dozens of keys and a lookup touches only a few nodes. Inner nodes hold only
+ * keys and child pointers. Values live in the leaves, which are linked in
+ * both directions for range iteration without returning to the inner nodes.
+ *
+ * Without a comparator, keys are `int64_t` and each node is searched with
+ * the widest vector instructions `get_simd_level()` reports, comparing every
+ * key at once instead of branching through a binary search.
+ */
+typedef struct bplus_tree_t {
+  void *root;
+  void *first_leaf, *last_leaf;
+  size_t height; /* The number of levels, counting the leaves. */
+  size_t length;
+  size_t key_size;
+  size_t value_size;
+  size_t node_size;
+  size_t leaf_capacity;  /* The number of keys a leaf holds. */
+  size_t inner_capacity; /* The number of keys an inner node holds. */
+  size_t leaf_values_offset;
+  size_t inner_keys_offset;
+  bplus_cmp_t cmp; /* `NULL` for `int64_t` keys. */
+  bplus_rank_t rank; /* Chosen once, when the tree is created. */
+  unsigned char *scratch; /* Room for two keys, used while splitting. */
+  const allocator_t *allocator;
+} bplus_tree_t;
+
+/* A position within a `bplus_tree_t`, or past either end of it. */
+typedef struct bplus_iter {
+  const bplus_tree_t *tree;
+  void *leaf; /* `NULL` once past either end. */
+  size_t index;
+} bplus_iter;
+
+/*
+ * Creates an empty B+ tree of `key_size`-byte keys ordered by `cmp` and
+ * `value_size`-byte values, whose nodes are each `node_lines` cache lines.
+ * If `cmp` is `NULL`, keys must be `int64_t`.
+ *
+ * \return A pointer to the new tree or `NULL` upon failure or if a node
+ * cannot hold at least three keys.
+ */
+bplus_tree_t *new_bplus_tree(size_t key_size, size_t value_size,
+                             size_t node_lines, bplus_cmp_t cmp);
+
+/*
+ * Same as `new_bplus_tree()`, except the tree's memory is obtained from and
+ * returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+bplus_tree_t *new_bplus_tree_with(size_t key_size, size_t value_size,
+                                  size_t node_lines, bplus_cmp_t cmp,
+                                  const allocator_t *allocator);
+
+/*
+ * Creates a B+ tree as by `new_bplus_tree_with()` holding the `count` pairs
+ * of `keys` and `values`, which must be in strictly ascending order of key.
+ * Nodes are filled level by level in O(n) time, with no searching or
+ * splitting.
+ *
+ * \return A pointer to the new tree or `NULL` upon failure.
+ */
+bplus_tree_t *bplus_bulk_load(size_t key_size, size_t value_size,
+                              size_t node_lines, bplus_cmp_t cmp,
+                              const void *keys, const void *values,
+                              size_t count, const allocator_t *allocator);
+
+/*
+ * Frees the passed B+ tree's consumed memory and reassigns its pointer to
+ * `NULL`.
+ */
+void delete_bplus_tree(bplus_tree_t **tree);
+
+/*
+ * Maps `key` to a copy of `value` within `tree`, replacing any value `key`
+ * already had.
+ *
+ * \return `true` upon success or `false` if a node could not be allocated.
+ */
+bool bplus_insert(bplus_tree_t *tree, const void *key, const void *value);
+
+/*
+ * Returns a pointer to the value `key` maps to within `tree`, or `NULL` if
+ * `key` is absent.
+ */
+void *bplus_find(const bplus_tree_t *tree, const void *key);
+
+/* Returns an iterator at the least key of `tree`. */
+bplus_iter bplus_first(const bplus_tree_t *tree);
+
+/* Returns an iterator at the greatest key of `tree`. */
+bplus_iter bplus_last(const bplus_tree_t *tree);
+
+/* Returns an iterator at the first key of `tree` not ordered before `key`. */
+bplus_iter bplus_lower_bound(const bplus_tree_t *tree, const void *key);
+
+/* Returns an iterator at the first key of `tree` ordered after `key`. */
+bplus_iter bplus_upper_bound(const bplus_tree_t *tree, const void *key);
+
+/* Returns `true` unless `iter` is past either end of its tree. */
+bool bplus_iter_valid(const bplus_iter *iter);
+
+/* Advances `iter` to the next key, which may be past the end. */
+void bplus_iter_next(bplus_iter *iter);
+
+/* Moves `iter` back to the previous key, which may be past the start. */
+void bplus_iter_prev(bplus_iter *iter);
+
+/* Returns the key `iter`, which must be valid, is at. */
+const void *bplus_iter_key(const bplus_iter *iter);
+
+/* Returns the value `iter`, which must be valid, is at. */
+void *bplus_iter_value(const bplus_iter *iter);
+
+#endif
@@ -0,0 +1,279 @@
+#include "bst.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "../../allocator/allocator.h"
+#include "../../pool/pool.h"
+#include "../trees.h"
+
+static size_t round_to_alignment(const size_t size, const size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+bst_t *new_bst(const size_t elem_size, const bst_cmp_t cmp) {
+  return new_bst_with(elem_size, cmp, NULL);
+}
+
+bst_t *new_bst_with(const size_t elem_size, const bst_cmp_t cmp,
+                    const allocator_t *const allocator) {
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  bst_t *const tree =
+      ALLOCATOR->alloc(ALLOCATOR->ctx, sizeof(bst_t), DEFAULT_ALIGNMENT);
+  if (tree == NULL) return NULL;
+  tree->root = NULL;
+  tree->length = 0;
+  tree->elem_size = elem_size;
+  tree->value_offset = round_to_alignment(sizeof(bst_node), DEFAULT_ALIGNMENT);
+  tree->cmp = cmp;
+  tree->allocator = ALLOCATOR;
+  pool_init(&tree->node_pool, tree->value_offset + elem_size, ALLOCATOR);
+  return tree;
+}
+
+void delete_bst(bst_t **const tree) {
+  pool_release(&(*tree)->node_pool);
+  const allocator_t *const ALLOCATOR = (*tree)->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, *tree, sizeof(bst_t), DEFAULT_ALIGNMENT);
+  *tree = NULL;
+}
+
+void delete_bst_s(bst_t **const tree) {
+  const size_t NODE_SIZE = (*tree)->value_offset + (*tree)->elem_size;
+  bst_node *node = bst_first(*tree);
+  while (node != NULL) {
+    bst_node *const next = bst_next(node);
+    memset(node, 0, NODE_SIZE);
+    node = next;
+  }
+  pool_release(&(*tree)->node_pool);
+  /* The header is about to be zeroed, so keep what freeing it requires. */
+  const allocator_t *const ALLOCATOR = (*tree)->allocator;
+  memset(*tree, 0, sizeof(bst_t));
+  ALLOCATOR->free(ALLOCATOR->ctx, *tree, sizeof(bst_t), DEFAULT_ALIGNMENT);
+  *tree = NULL;
+}
+
+void *bst_value(const bst_node *const node) {
+  return (char *)node +
+         round_to_alignment(sizeof(bst_node), DEFAULT_ALIGNMENT);
+}
+
+/* - BALANCING - */
+
+static int height(const bst_node *const node) {
+  return (node != NULL) ? node->height : 0;
+}
+
+static void update_height(bst_node *const node) {
+  const int LEFT = height(node->left), RIGHT = height(node->right);
+  node->height = 1 + (LEFT > RIGHT ? LEFT : RIGHT);
+}
+
+/* Makes `new_child` take the place of `old_child` beneath `parent`. */
+static void replace_child(bst_t *const tree, bst_node *const parent,
+                          const bst_node *const old_child,
+                          bst_node *const new_child) {
+  if (parent == NULL)
+    tree->root = new_child;
+  else if (parent->left == old_child)
+    parent->left = new_child;
+  else
+    parent->right = new_child;
+}
+
+/* Rotates the subtree at `node` leftward, returning the subtree's new root. */
+static bst_node *rotate_left(bst_t *const tree, bst_node *const node) {
+  bst_node *const pivot = node->right;
+  node->right = pivot->left;
+  if (pivot->left != NULL) pivot->left->parent = node;
+  pivot->parent = node->parent;
+  replace_child(tree, node->parent, node, pivot);
+  pivot->left = node;
+  node->parent = pivot;
+  update_height(node);
+  update_height(pivot);
+  return pivot;
+}
+
+/* The mirror image of `rotate_left()`. */
+static bst_node *rotate_right(bst_t *const tree, bst_node *const node) {
+  bst_node *const pivot = node->left;
+  node->left = pivot->right;
+  if (pivot->right != NULL) pivot->right->parent = node;
+  pivot->parent = node->parent;
+  replace_child(tree, node->parent, node, pivot);
+  pivot->right = node;
+  node->parent = pivot;
+  update_height(node);
+  update_height(pivot);
+  return pivot;
+}
+
+/*
+ * Restores the AVL property on the path from `node` up to the root after a
+ * node below `node` was inserted or removed.
+ */
+static void rebalance(bst_t *const tree, bst_node *node) {
+  while (node != NULL) {
+    update_height(node);
+    const int BALANCE = height(node->left) - height(node->right);
+    if (BALANCE > 1) {
+      if (height(node->left->left) < height(node->left->right))
+        rotate_left(tree, node->left);
+      node = rotate_right(tree, node);
+    } else if (BALANCE < -1) {
+      if (height(node->right->right) < height(node->right->left))
+        rotate_right(tree, node->right);
+      node = rotate_left(tree, node);
+    }
+    node = node->parent;
+  }
+}
+
+/* - MODIFICATION - */
+
+bst_node *bst_insert(bst_t *const tree, const void *const elem) {
+  bst_node *parent = NULL;
+  bst_node **slot = &tree->root;
+  while (*slot != NULL) {
+    parent = *slot;
+    const int ORDER = tree->cmp(elem, bst_value(parent));
+    if (ORDER == 0) {
+      memcpy(bst_value(parent), elem, tree->elem_size);
+      return parent;
+    }
+    slot = (ORDER < 0) ? &parent->left : &parent->right;
+  }
+  bst_node *const node = pool_alloc(&tree->node_pool);
+  if (node == NULL) return NULL;
+  memcpy(bst_value(node), elem, tree->elem_size);
+  node->parent = parent;
+  node->left = node->right = NULL;
+  node->height = 1;
+  *slot = node;
+  tree->length++;
+  rebalance(tree, parent);
+  return node;
+}
+
+/* Puts `replacement`, which may be `NULL`, in the place of `target`. */
+static void transplant(bst_t *const tree, const bst_node *const target,
+                       bst_node *const replacement) {
+  replace_child(tree, target->parent, target, replacement);
+  if (replacement != NULL) replacement->parent = target->parent;
+}
+
+static bst_node *subtree_first(bst_node *node) {
+  while (node->left != NULL) node = node->left;
+  return node;
+}
+
+static bst_node *subtree_last(bst_node *node) {
+  while (node->right != NULL) node = node->right;
+  return node;
+}
+
+void bst_erase_node(bst_t *const tree, bst_node *const node) {
+  bst_node *unbalanced;
+  if (node->left == NULL) {
+    unbalanced = node->parent;
+    transplant(tree, node, node->right);
+  } else if (node->right == NULL) {
+    unbalanced = node->parent;
+    transplant(tree, node, node->left);
+  } else {
+    /*
+     * Move the successor node itself into the erased node's place, rather
+     * than its value, so that no other node changes what it holds.
+     */
+    bst_node *const successor = subtree_first(node->right);
+    if (successor->parent != node) {
+      unbalanced = successor->parent;
+      transplant(tree, successor, successor->right);
+      successor->right = node->right;
+      successor->right->parent = successor;
+    } else {
+      unbalanced = successor;
+    }
+    transplant(tree, node, successor);
+    successor->left = node->left;
+    successor->left->parent = successor;
+    successor->height = node->height;
+  }
+  rebalance(tree, unbalanced);
+  pool_free(&tree->node_pool, node);
+  tree->length--;
+}
+
+bool bst_erase(bst_t *const tree, const void *const key) {
+  bst_node *const node = bst_find(tree, key);
+  if (node == NULL) return false;
+  bst_erase_node(tree, node);
+  return true;
+}
+
+/* - LOOKUP - */
+
+bst_node *bst_find(const bst_t *const tree, const void *const key) {
+  bst_node *node = tree->root;
+  while (node != NULL) {
+    const int ORDER = tree->cmp(key, bst_value(node));
+    if (ORDER == 0) return node;
+    node = (ORDER < 0) ? node->left : node->right;
+  }
+  return NULL;
+}
+
+bst_node *bst_lower_bound(const bst_t *const tree, const void *const key) {
+  bst_node *bound = NULL;
+  bst_node *node = tree->root;
+  while (node != NULL) {
+    if (tree->cmp(bst_value(node), key) >= 0) {
+      bound = node;
+      node = node->left;
+    } else {
+      node = node->right;
+    }
+  }
+  return bound;
+}
+
+bst_node *bst_upper_bound(const bst_t *const tree, const void *const key) {
+  bst_node *bound = NULL;
+  bst_node *node = tree->root;
+  while (node != NULL) {
+    if (tree->cmp(bst_value(node), key) > 0) {
+      bound = node;
+      node = node->left;
+    } else {
+      node = node->right;
+    }
+  }
+  return bound;
+}
+
+/* - ITERATION - */
+
+bst_node *bst_first(const bst_t *const tree) {
+  return (tree->root != NULL) ? subtree_first(tree->root) : NULL;
+}
+
+bst_node *bst_last(const bst_t *const tree) {
+  return (tree->root != NULL) ? subtree_last(tree->root) : NULL;
+}
+
+bst_node *bst_next(const bst_node *node) {
+  if (node->right != NULL) return subtree_first(node->right);
+  while (node->parent != NULL && node == node->parent->right)
+    node = node->parent;
+  return node->parent;
+}
+
+bst_node *bst_prev(const bst_node *node) {
+  if (node->left != NULL) return subtree_last(node->left);
+  while (node->parent != NULL && node == node->parent->left)
+    node = node->parent;
+  return node->parent;
+}
@@ -1,6 +1,132 @@
 #ifndef BINARYSEARCHTREE_H
 #define BINARYSEARCHTREE_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../../allocator/allocator.h"
+#include "../../pool/pool.h"
 #include "../binarytree/binarytree.h"
 
+/*
+ * Orders two elements, returning a negative value if `a` sorts before `b`, a
+ * positive value if after, and zero if they are equal.
+ */
+typedef int (*bst_cmp_t)(const void *a, const void *b);
+
+/* A node of a `bst_t`. The node's value directly follows it. */
+typedef struct bst_node {
+  struct bst_node *parent;
+  struct bst_node *left, *right;
+  int height; /* The height of the node's subtree, a leaf being 1. */
+} bst_node;
+
+/*
+ * A binary search tree kept balanced as an AVL tree: the heights of every
+ * node's subtrees differ by at most one, which bounds the tree's height by
+ * about 1.44 log2(n) and makes every operation O(log n).
+ *
+ * Elements are unique under `cmp`. To map keys to values, store both in one
+ * element and have `cmp` compare only the keys.
+ *
+ * Nodes come from the tree's node pool, so their addresses stay stable until
+ * they are erased.
+ */
+typedef struct bst_t {
+  bst_node *root;
+  size_t length;
+  size_t elem_size;
+  size_t value_offset; /* The offset of a node's value from the node. */
+  bst_cmp_t cmp;
+  const allocator_t *allocator;
+  pool_t node_pool;
+} bst_t;
+
+/*
+ * Creates an empty search tree of `elem_size`-byte elements ordered by `cmp`.
+ *
+ * \return A pointer to the new tree or `NULL` upon failure.
+ */
+bst_t *new_bst(size_t elem_size, bst_cmp_t cmp);
+
+/*
+ * Same as `new_bst()`, except the tree's memory is obtained from and
+ * returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+bst_t *new_bst_with(size_t elem_size, bst_cmp_t cmp,
+                    const allocator_t *allocator);
+
+/*
+ * Frees the passed search tree's consumed memory and reassigns its pointer
+ * to `NULL`.
+ */
+void delete_bst(bst_t **tree);
+
+/*
+ * Same as `delete_bst()`, except this function will set all allocated
+ * memory of the tree to zero first.
+ */
+void delete_bst_s(bst_t **tree);
+
+/* Returns the value held by `node`. */
+void *bst_value(const bst_node *node);
+
+/*
+ * Inserts a copy of `elem` into `tree`, or overwrites the element equal to
+ * it if there is one.
+ *
+ * \return The node holding `elem` or `NULL` upon failure.
+ */
+bst_node *bst_insert(bst_t *tree, const void *elem);
+
+/*
+ * Removes `node` from `tree` and returns it to the node pool. Only `node` is
+ * invalidated; every other node keeps its address and value.
+ */
+void bst_erase_node(bst_t *tree, bst_node *node);
+
+/*
+ * Removes the element equal to `key` from `tree`.
+ *
+ * \return `true` if an element was removed or `false` if none was equal.
+ */
+bool bst_erase(bst_t *tree, const void *key);
+
+/*
+ * Returns the node holding the element equal to `key` or `NULL` if there is
+ * none.
+ */
+bst_node *bst_find(const bst_t *tree, const void *key);
+
+/*
+ * Returns the node holding the first element not ordered before `key`, or
+ * `NULL` if there is none.
+ */
+bst_node *bst_lower_bound(const bst_t *tree, const void *key);
+
+/*
+ * Returns the node holding the first element ordered after `key`, or `NULL`
+ * if there is none.
+ */
+bst_node *bst_upper_bound(const bst_t *tree, const void *key);
+
+/* Returns the node holding the least element or `NULL` if `tree` is empty. */
+bst_node *bst_first(const bst_t *tree);
+
+/*
+ * Returns the node holding the greatest element or `NULL` if `tree` is
+ * empty.
+ */
+bst_node *bst_last(const bst_t *tree);
+
+/*
+ * Returns the node after `node` in order, or `NULL` if it holds the greatest
+ * element. Together with `bst_first()`, this walks a tree in order without
+ * allocating.
+ */
+bst_node *bst_next(const bst_node *node);
+
+/* Returns the node before `node` in order, or `NULL` if there is none. */
+bst_node *bst_prev(const bst_node *node);
+
 #endif
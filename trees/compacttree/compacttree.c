@@ -0,0 +1,287 @@
+#include "compacttree.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../../allocator/allocator.h"
+#include "../trees.h"
+
+/* The capacity of the node block once a tree without nodes gains one. */
+#define BASE_CT_CAPACITY ((size_t)16)
+
+/* The factor by which the node block grows when it is full. */
+#define CT_EXPANSION_FACTOR (2)
+
+static size_t round_to_alignment(const size_t size, const size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+/*
+ * Returns the alignment a value of `elem_size` bytes needs. Every type's
+ * alignment divides its size, so the lowest set bit of the size suffices.
+ */
+static size_t value_alignment(const size_t elem_size) {
+  const size_t LOWEST_BIT = elem_size & (~elem_size + 1);
+  if (LOWEST_BIT == 0 || LOWEST_BIT > DEFAULT_ALIGNMENT)
+    return DEFAULT_ALIGNMENT;
+  return LOWEST_BIT;
+}
+
+compact_tree *_new_compact_tree(const void *const data,
+                                const size_t elem_size, const size_t length) {
+  return _new_compact_tree_with(data, elem_size, length, NULL);
+}
+
+compact_tree *_new_compact_tree_with(const void *const data,
+                                     const size_t elem_size,
+                                     const size_t length,
+                                     const allocator_t *const allocator) {
+  if (length > CT_MAX_NODES) return NULL;
+  const size_t VALUE_ALIGNMENT = value_alignment(elem_size);
+  const size_t NODE_ALIGNMENT = VALUE_ALIGNMENT > _Alignof(ct_node)
+                                    ? VALUE_ALIGNMENT
+                                    : _Alignof(ct_node);
+  const size_t VALUE_OFFSET =
+      round_to_alignment(sizeof(ct_node), VALUE_ALIGNMENT);
+  const size_t NODE_SIZE =
+      round_to_alignment(VALUE_OFFSET + elem_size, NODE_ALIGNMENT);
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  compact_tree *const tree = ALLOCATOR->alloc(
+      ALLOCATOR->ctx, sizeof(compact_tree), DEFAULT_ALIGNMENT);
+  if (tree == NULL) return NULL;
+  tree->nodes = NULL;
+  if (length != 0) {
+    tree->nodes =
+        ALLOCATOR->alloc(ALLOCATOR->ctx, length * NODE_SIZE, DEFAULT_ALIGNMENT);
+    if (tree->nodes == NULL) {
+      ALLOCATOR->free(ALLOCATOR->ctx, tree, sizeof(compact_tree),
+                      DEFAULT_ALIGNMENT);
+      return NULL;
+    }
+  }
+  tree->root = (length != 0) ? 0 : CT_NO_NODE;
+  tree->free_list = CT_NO_NODE;
+  tree->num_nodes = tree->used_nodes = tree->capacity = length;
+  tree->node_size = NODE_SIZE;
+  tree->value_offset = VALUE_OFFSET;
+  tree->elem_size = elem_size;
+  tree->allocator = ALLOCATOR;
+
+  /* The same level-order placement as `_new_binary_tree()`, by index. */
+  for (size_t i = 0; i < length; i++) {
+    ct_node *const node = compact_node(tree, (uint32_t)i);
+    node->parent = (i == 0) ? CT_NO_NODE : (uint32_t)((i - 1) / 2);
+    node->left = (2 * i + 1 < length) ? (uint32_t)(2 * i + 1) : CT_NO_NODE;
+    node->right = (2 * i + 2 < length) ? (uint32_t)(2 * i + 2) : CT_NO_NODE;
+    memcpy(compact_value(tree, (uint32_t)i), (const char *)data + i * elem_size,
+           elem_size);
+  }
+  return tree;
+}
+
+void delete_compact_tree(compact_tree **const tree) {
+  const allocator_t *const ALLOCATOR = (*tree)->allocator;
+  if ((*tree)->nodes != NULL)
+    ALLOCATOR->free(ALLOCATOR->ctx, (*tree)->nodes,
+                    (*tree)->capacity * (*tree)->node_size, DEFAULT_ALIGNMENT);
+  ALLOCATOR->free(ALLOCATOR->ctx, *tree, sizeof(compact_tree),
+                  DEFAULT_ALIGNMENT);
+  *tree = NULL;
+}
+
+void delete_compact_tree_s(compact_tree **const tree) {
+  if ((*tree)->nodes != NULL)
+    memset((*tree)->nodes, 0, (*tree)->capacity * (*tree)->node_size);
+  /* The header is about to be zeroed, so keep what freeing it requires. */
+  const compact_tree HEADER = **tree;
+  memset(*tree, 0, sizeof(compact_tree));
+  const allocator_t *const ALLOCATOR = HEADER.allocator;
+  if (HEADER.nodes != NULL)
+    ALLOCATOR->free(ALLOCATOR->ctx, HEADER.nodes,
+                    HEADER.capacity * HEADER.node_size, DEFAULT_ALIGNMENT);
+  ALLOCATOR->free(ALLOCATOR->ctx, *tree, sizeof(compact_tree),
+                  DEFAULT_ALIGNMENT);
+  *tree = NULL;
+}
+
+ct_node *compact_node(const compact_tree *const tree, const uint32_t index) {
+  return (ct_node *)(tree->nodes + (size_t)index * tree->node_size);
+}
+
+void *compact_value(const compact_tree *const tree, const uint32_t index) {
+  return tree->nodes + (size_t)index * tree->node_size + tree->value_offset;
+}
+
+/* - NODE MANAGEMENT - */
+
+/*
+ * Returns the node after `index` in a pre-order walk of the subtree rooted at
+ * `root`, or `CT_NO_NODE` once the walk is done.
+ */
+static uint32_t next_preorder(const compact_tree *const tree, uint32_t index,
+                              const uint32_t root) {
+  const ct_node *node = compact_node(tree, index);
+  if (node->left != CT_NO_NODE) return node->left;
+  if (node->right != CT_NO_NODE) return node->right;
+  while (index != root) {
+    const uint32_t PARENT = node->parent;
+    const ct_node *const parent = compact_node(tree, PARENT);
+    if (index == parent->left && parent->right != CT_NO_NODE)
+      return parent->right;
+    index = PARENT;
+    node = parent;
+  }
+  return CT_NO_NODE;
+}
+
+static size_t count_subtree(const compact_tree *const tree,
+                            const uint32_t root) {
+  size_t count = 0;
+  for (uint32_t index = root; index != CT_NO_NODE;
+       index = next_preorder(tree, index, root))
+    count++;
+  return count;
+}
+
+/* Returns the first node visited in a post-order walk starting at `index`. */
+static uint32_t first_postorder(const compact_tree *const tree,
+                                uint32_t index) {
+  while (true) {
+    const ct_node *const node = compact_node(tree, index);
+    if (node->left != CT_NO_NODE)
+      index = node->left;
+    else if (node->right != CT_NO_NODE)
+      index = node->right;
+    else
+      return index;
+  }
+}
+
+/* Detaches `target` from its parent, or from `tree` if `target` is the root. */
+static void detach_node(compact_tree *const tree, const uint32_t target) {
+  ct_node *const node = compact_node(tree, target);
+  if (node->parent == CT_NO_NODE) {
+    if (tree->root == target) tree->root = CT_NO_NODE;
+    return;
+  }
+  ct_node *const parent = compact_node(tree, node->parent);
+  if (parent->left == target)
+    parent->left = CT_NO_NODE;
+  else
+    parent->right = CT_NO_NODE;
+  node->parent = CT_NO_NODE;
+}
+
+/* Obtains an unused node, recycling deleted nodes before growing the block. */
+static uint32_t take_node(compact_tree *const tree) {
+  if (tree->free_list != CT_NO_NODE) {
+    const uint32_t INDEX = tree->free_list;
+    tree->free_list = compact_node(tree, INDEX)->left;
+    return INDEX;
+  }
+  if (tree->used_nodes == tree->capacity) {
+    if (tree->capacity == CT_MAX_NODES) return CT_NO_NODE;
+    size_t new_capacity = (tree->capacity != 0)
+                              ? CT_EXPANSION_FACTOR * tree->capacity
+                              : BASE_CT_CAPACITY;
+    if (new_capacity > CT_MAX_NODES) new_capacity = CT_MAX_NODES;
+    const allocator_t *const ALLOCATOR = tree->allocator;
+    const size_t OLD_SIZE = tree->capacity * tree->node_size;
+    const size_t NEW_SIZE = new_capacity * tree->node_size;
+    /* Links are indices, so the block may move without any fixups. */
+    unsigned char *const nodes =
+        (tree->nodes != NULL)
+            ? ALLOCATOR->realloc(ALLOCATOR->ctx, tree->nodes, OLD_SIZE,
+                                 NEW_SIZE, DEFAULT_ALIGNMENT)
+            : ALLOCATOR->alloc(ALLOCATOR->ctx, NEW_SIZE, DEFAULT_ALIGNMENT);
+    if (nodes == NULL) return CT_NO_NODE;
+    tree->nodes = nodes;
+    tree->capacity = new_capacity;
+  }
+  return (uint32_t)tree->used_nodes++;
+}
+
+uint32_t add_compact_node(compact_tree *const tree, const void *const elem) {
+  const uint32_t INDEX = take_node(tree);
+  if (INDEX == CT_NO_NODE) return CT_NO_NODE;
+  ct_node *const node = compact_node(tree, INDEX);
+  memcpy(compact_value(tree, INDEX), elem, tree->elem_size);
+  node->left = node->right = CT_NO_NODE;
+  tree->num_nodes++;
+  if (tree->root == CT_NO_NODE) {
+    node->parent = CT_NO_NODE;
+    tree->root = INDEX;
+    return INDEX;
+  }
+
+  /* The same path to the first free position as in `add_binary_node()`. */
+  const size_t POSITION = tree->num_nodes;
+  size_t bit = 0;
+  while ((POSITION >> (bit + 1)) != 0) bit++;
+  uint32_t parent = tree->root;
+  while (true) {
+    const bool GO_RIGHT = (bit != 0) && ((POSITION >> --bit) & 1);
+    ct_node *const parent_node = compact_node(tree, parent);
+    uint32_t *const slot = GO_RIGHT ? &parent_node->right : &parent_node->left;
+    if (*slot == CT_NO_NODE) {
+      *slot = INDEX;
+      break;
+    }
+    parent = *slot;
+  }
+  node->parent = parent;
+  return INDEX;
+}
+
+uint32_t remove_compact_node(compact_tree *const tree, const uint32_t target) {
+  /* A detached subtree's nodes were already subtracted when it was removed. */
+  if (compact_node(tree, target)->parent == CT_NO_NODE && tree->root != target)
+    return target;
+  detach_node(tree, target);
+  tree->num_nodes -= count_subtree(tree, target);
+  return target;
+}
+
+bool reparent_compact_node(compact_tree *const tree, const uint32_t parent,
+                           const uint32_t child) {
+  ct_node *const parent_node = compact_node(tree, parent);
+  if (parent_node->left != CT_NO_NODE && parent_node->right != CT_NO_NODE)
+    return false;
+  /* Refuse to make a node a descendant of itself. */
+  for (uint32_t index = parent; index != CT_NO_NODE;
+       index = compact_node(tree, index)->parent)
+    if (index == child) return false;
+  ct_node *const child_node = compact_node(tree, child);
+  const bool DETACHED =
+      child_node->parent == CT_NO_NODE && tree->root != child;
+  detach_node(tree, child);
+  if (parent_node->left == CT_NO_NODE)
+    parent_node->left = child;
+  else
+    parent_node->right = child;
+  child_node->parent = parent;
+  if (DETACHED) tree->num_nodes += count_subtree(tree, child);
+  return true;
+}
+
+void delete_compact_node(compact_tree *const tree, const uint32_t target) {
+  remove_compact_node(tree, target);
+  /* Free the subtree in post-order so no node is read after being freed. */
+  uint32_t index = first_postorder(tree, target);
+  while (true) {
+    uint32_t next = CT_NO_NODE;
+    if (index != target) {
+      const uint32_t PARENT = compact_node(tree, index)->parent;
+      const ct_node *const parent = compact_node(tree, PARENT);
+      next = (index == parent->left && parent->right != CT_NO_NODE)
+                 ? first_postorder(tree, parent->right)
+                 : PARENT;
+    }
+    compact_node(tree, index)->left = tree->free_list;
+    tree->free_list = index;
+    if (next == CT_NO_NODE) break;
+    index = next;
+  }
+}
@@ -0,0 +1,112 @@
+#ifndef COMPACTTREE_H
+#define COMPACTTREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../allocator/allocator.h"
+#include "../trees.h"
+
+/* Stands in for a missing node wherever a node index is expected. */
+#define CT_NO_NODE (UINT32_MAX)
+
+/* The largest number of nodes a compact tree can address. */
+#define CT_MAX_NODES ((size_t)UINT32_MAX - 1)
+
+/*
+ * A node of a `compact_tree`. Links are indices into the tree's node block,
+ * or `CT_NO_NODE`, and the node's value directly follows it, so a node costs
+ * 12 bytes plus padding rather than the 32 bytes of a `bt_node`.
+ */
+typedef struct ct_node {
+  uint32_t parent;
+  uint32_t left, right;
+} ct_node;
+
+/*
+ * The compact counterpart of `binary_tree`. All nodes live in one block and
+ * refer to each other by index, so the block may be moved by `realloc()` or
+ * copied with `memcpy()` without invalidating the tree, and more nodes fit
+ * in each cache line during traversals.
+ *
+ * Node indices stay valid for as long as the node does, but pointers from
+ * `compact_node()` and `compact_value()` are invalidated by adding a node.
+ */
+typedef struct compact_tree {
+  unsigned char *nodes; /* The node block. */
+  uint32_t root;
+  uint32_t free_list; /* Deleted nodes, linked through `left`. */
+  size_t num_nodes;   /* The number of nodes reachable from `root`. */
+  size_t used_nodes;  /* The number of slots ever handed out. */
+  size_t capacity;    /* The number of slots in the node block. */
+  size_t node_size;
+  size_t value_offset; /* The offset of a node's value from the node. */
+  size_t elem_size;
+  const allocator_t *allocator;
+} compact_tree;
+
+/*
+ * This is a convenience macro for generating a `compact_tree` from an array.
+ * Make sure the arguments have no side effects such as incrementation.
+ */
+#define new_compact_tree(data, length) \
+  _new_compact_tree(data, sizeof *(data), length)
+#define new_compact_tree_with(data, length, allocator) \
+  _new_compact_tree_with(data, sizeof *(data), length, allocator)
+
+/*
+ * Same as `_new_binary_tree()`, except the tree is a `compact_tree` and node
+ * `i` holds element `i` of `data`.
+ */
+compact_tree *_new_compact_tree(const void *data, size_t elem_size,
+                                size_t length);
+
+/*
+ * Same as `_new_compact_tree()`, except the tree's memory is obtained from
+ * and returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+compact_tree *_new_compact_tree_with(const void *data, size_t elem_size,
+                                     size_t length,
+                                     const allocator_t *allocator);
+
+/*
+ * Frees the passed compact tree's consumed memory and reassigns its pointer
+ * to `NULL`.
+ */
+void delete_compact_tree(compact_tree **tree);
+
+/*
+ * Same as `delete_compact_tree()`, except this function will set all
+ * allocated memory of the tree to zero first.
+ */
+void delete_compact_tree_s(compact_tree **tree);
+
+/* Returns node `index` of `tree`. */
+ct_node *compact_node(const compact_tree *tree, uint32_t index);
+
+/* Returns the value of node `index` of `tree`. */
+void *compact_value(const compact_tree *tree, uint32_t index);
+
+/*
+ * Same as `add_binary_node()`, except the node block doubles when full,
+ * moving every node but keeping every index valid.
+ *
+ * \return The index of the added node, or `CT_NO_NODE` upon failure.
+ */
+uint32_t add_compact_node(compact_tree *tree, const void *elem);
+
+/* Same as `remove_binary_node()`, but for node `target` of `tree`. */
+uint32_t remove_compact_node(compact_tree *tree, uint32_t target);
+
+/* Same as `reparent_binary_node()`, but for nodes of `tree`. */
+bool reparent_compact_node(compact_tree *tree, uint32_t parent,
+                           uint32_t child);
+
+/*
+ * Removes `target` from `tree` if it is still attached, then recycles it and
+ * all of its descendants for reuse by `add_compact_node()`.
+ */
+void delete_compact_node(compact_tree *tree, uint32_t target);
+
+#endif
@@ -0,0 +1,184 @@
+#include "eytzinger.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../../allocator/allocator.h"
+#include "../../array/array.h"
+
+/*
+ * A search prefetches the slots this many levels below its current one, whose
+ * 2^4 = 16 slots are contiguous.
+ */
+#define PREFETCH_LEVELS (4)
+
+/* The number of searches a batched lookup advances in lockstep. */
+#define BATCH_SIZE ((size_t)8)
+
+typedef unsigned char byte_t;
+
+static size_t data_offset(void) {
+  return (sizeof(eytzinger_t) + EYTZINGER_ALIGNMENT - 1) /
+         EYTZINGER_ALIGNMENT * EYTZINGER_ALIGNMENT;
+}
+
+static size_t allocation_size(const eytzinger_t *const tree) {
+  return data_offset() + (tree->length + 1) * tree->elem_size;
+}
+
+eytzinger_t *eytzinger_from_array(const array_t *const sorted) {
+  return eytzinger_from_array_with(sorted, NULL);
+}
+
+eytzinger_t *eytzinger_from_array_with(const array_t *const sorted,
+                                       const allocator_t *const allocator) {
+  const size_t LENGTH = sorted->length;
+  const size_t ELEM_SIZE = sorted->elem_size;
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  eytzinger_t *const tree =
+      ALLOCATOR->alloc(ALLOCATOR->ctx, data_offset() + (LENGTH + 1) * ELEM_SIZE,
+                       EYTZINGER_ALIGNMENT);
+  if (tree == NULL) return NULL;
+  tree->data = (byte_t *)tree + data_offset();
+  tree->length = LENGTH;
+  tree->elem_size = ELEM_SIZE;
+  tree->allocator = ALLOCATOR;
+  if (LENGTH == 0) return tree;
+
+  /*
+   * Visit the slots in order, which is the order of `sorted`, starting at
+   * the leftmost slot. Each successor is either the leftmost slot of the
+   * right subtree or, failing that, the parent of the last left turn.
+   */
+  size_t slot = 1;
+  while (2 * slot <= LENGTH) slot *= 2;
+  for (size_t i = 0; i < LENGTH; i++) {
+    memcpy((byte_t *)tree->data + slot * ELEM_SIZE,
+           (const byte_t *)sorted->data + i * ELEM_SIZE, ELEM_SIZE);
+    if (2 * slot + 1 <= LENGTH) {
+      slot = 2 * slot + 1;
+      while (2 * slot <= LENGTH) slot *= 2;
+    } else {
+      while (slot & 1) slot >>= 1;
+      slot >>= 1;
+    }
+  }
+  return tree;
+}
+
+void _delete_eytzinger(eytzinger_t **const tree) {
+  const allocator_t *const ALLOCATOR = (*tree)->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, *tree, allocation_size(*tree),
+                  EYTZINGER_ALIGNMENT);
+  *tree = NULL;
+}
+
+void *eytzinger_elem(const eytzinger_t *const tree, const size_t slot) {
+  return (byte_t *)tree->data + slot * tree->elem_size;
+}
+
+/* - SEARCH - */
+
+/*
+ * A descent ends below the leaves, having appended one bit per level: one for
+ * a right turn and zero for a left one. The lower bound is the node of the
+ * last left turn, found by shifting off the trailing right turns and then the
+ * left turn itself. A descent with no left turns yields `EYTZINGER_NONE`.
+ */
+static size_t cancel_right_turns(const size_t slot) {
+#if defined(__GNUC__)
+  return slot >> ((unsigned)__builtin_ctzll(~(unsigned long long)slot) + 1);
+#else
+  size_t result = slot;
+  while (result & 1) result >>= 1;
+  return result >> 1;
+#endif
+}
+
+/* Prefetches the slots `PREFETCH_LEVELS` below `slot`, if there are any. */
+static void prefetch_descendants(const eytzinger_t *const tree,
+                                 const size_t slot) {
+#if defined(__GNUC__)
+  size_t target = slot << PREFETCH_LEVELS;
+  if (target > tree->length) target = tree->length;
+  __builtin_prefetch((const byte_t *)tree->data + target * tree->elem_size);
+#else
+  (void)tree;
+  (void)slot;
+#endif
+}
+
+/* Returns the index of the highest set bit of `value`, which is nonzero. */
+static size_t floor_log2(size_t value) {
+  size_t log = 0;
+  while (value >>= 1) log++;
+  return log;
+}
+
+size_t eytzinger_lower_bound(const eytzinger_t *const tree,
+                             const void *const key,
+                             const eytzinger_cmp_t cmp) {
+  size_t slot = 1;
+  while (slot <= tree->length) {
+    prefetch_descendants(tree, slot);
+    slot = 2 * slot + (cmp(eytzinger_elem(tree, slot), key) < 0);
+  }
+  return cancel_right_turns(slot);
+}
+
+/*
+ * Defines the single and batched searches for keys of type `type`. A batch
+ * takes one step per level, and a search whose slot has run past the leaves
+ * keeps turning right, which `cancel_right_turns()` undoes, so all searches
+ * finish together without branching on their progress.
+ */
+#define DEFINE_SEARCHES(suffix, type)                                        \
+  static type key_##suffix(const eytzinger_t *const tree,                    \
+                           const size_t slot) {                              \
+    type key;                                                                \
+    memcpy(&key, eytzinger_elem(tree, slot), sizeof(key));                   \
+    return key;                                                              \
+  }                                                                          \
+                                                                             \
+  size_t eytzinger_lower_bound_##suffix(const eytzinger_t *const tree,       \
+                                        const type key) {                    \
+    size_t slot = 1;                                                         \
+    while (slot <= tree->length) {                                           \
+      prefetch_descendants(tree, slot);                                      \
+      slot = 2 * slot + (key_##suffix(tree, slot) < key);                    \
+    }                                                                        \
+    return cancel_right_turns(slot);                                         \
+  }                                                                          \
+                                                                             \
+  void eytzinger_lower_bound_batch_##suffix(                                 \
+      const eytzinger_t *const tree, const type *const keys,                 \
+      const size_t count, size_t *const slots) {                             \
+    const size_t LENGTH = tree->length;                                      \
+    if (LENGTH == 0) {                                                       \
+      for (size_t i = 0; i < count; i++) slots[i] = EYTZINGER_NONE;          \
+      return;                                                                \
+    }                                                                        \
+    const size_t LEVELS = floor_log2(LENGTH) + 1;                            \
+    for (size_t first = 0; first < count; first += BATCH_SIZE) {             \
+      const size_t GROUP =                                                   \
+          (count - first < BATCH_SIZE) ? count - first : BATCH_SIZE;         \
+      size_t batch[BATCH_SIZE];                                              \
+      for (size_t j = 0; j < GROUP; j++) batch[j] = 1;                       \
+      for (size_t level = 0; level < LEVELS; level++) {                      \
+        for (size_t j = 0; j < GROUP; j++) {                                 \
+          const size_t SLOT = batch[j];                                      \
+          const bool PAST_LEAVES = SLOT > LENGTH;                            \
+          prefetch_descendants(tree, SLOT);                                  \
+          const type ELEM = key_##suffix(tree, PAST_LEAVES ? 1 : SLOT);      \
+          batch[j] = 2 * SLOT + (PAST_LEAVES | (ELEM < keys[first + j]));    \
+        }                                                                    \
+      }                                                                      \
+      for (size_t j = 0; j < GROUP; j++)                                     \
+        slots[first + j] = cancel_right_turns(batch[j]);                     \
+    }                                                                        \
+  }
+
+DEFINE_SEARCHES(i32, int32_t)
+DEFINE_SEARCHES(i64, int64_t)
@@ -0,0 +1,94 @@
+#ifndef EYTZINGER_H
+#define EYTZINGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../allocator/allocator.h"
+#include "../../array/array.h"
+
+/* The alignment of an Eytzinger tree's elements, that of a cache line. */
+#define EYTZINGER_ALIGNMENT ((size_t)64)
+
+/* Returned by searches which find no element. */
+#define EYTZINGER_NONE ((size_t)0)
+
+#define delete_eytzinger(tree) _delete_eytzinger(&(tree))
+
+/*
+ * Orders two elements, returning a negative value if `a` sorts before `b`, a
+ * positive value if after, and zero if they are equal.
+ */
+typedef int (*eytzinger_cmp_t)(const void *a, const void *b);
+
+/*
+ * A static search tree holding a sorted array's elements in Eytzinger order,
+ * the level-order placement `_new_binary_tree()` also uses: the root is in
+ * slot 1 and the children of slot `k` are in slots `2k` and `2k + 1`. There
+ * are no links, and the first levels, which every search visits, share a few
+ * cache lines.
+ *
+ * Searches are branch-free, descending by arithmetic alone, and prefetch the
+ * slots four levels further down, so memory latency overlaps with the
+ * comparisons rather than adding to them. Slot 0 is unused, which places
+ * each group of 16 sibling slots at the start of a cache line when elements
+ * are 4 bytes.
+ *
+ * Like `array_t`, the header and the elements share one allocation.
+ */
+typedef struct eytzinger_t {
+  void *data; /* Slot `k` starts `k * elem_size` bytes past `data`. */
+  size_t length;
+  size_t elem_size;
+  const allocator_t *allocator;
+} eytzinger_t;
+
+/*
+ * Builds an Eytzinger tree from the elements of `sorted`, which must be in
+ * ascending order.
+ *
+ * \return A pointer to the new tree or `NULL` upon failure.
+ */
+eytzinger_t *eytzinger_from_array(const array_t *sorted);
+
+/*
+ * Same as `eytzinger_from_array()`, except the tree's memory is obtained
+ * from and returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+eytzinger_t *eytzinger_from_array_with(const array_t *sorted,
+                                       const allocator_t *allocator);
+
+/* Frees the memory used by `tree` and invalidates the passed pointer. */
+void _delete_eytzinger(eytzinger_t **tree);
+
+/* Returns the element in slot `slot` of `tree`. */
+void *eytzinger_elem(const eytzinger_t *tree, size_t slot);
+
+/*
+ * Finds the first element of `tree` not ordered before `key` by `cmp`.
+ *
+ * \return The slot of the element or `EYTZINGER_NONE` if there is none.
+ */
+size_t eytzinger_lower_bound(const eytzinger_t *tree, const void *key,
+                             eytzinger_cmp_t cmp);
+
+/*
+ * Same as `eytzinger_lower_bound()`, except each element's key is the
+ * `int32_t` or `int64_t` in its first bytes, compared directly.
+ */
+size_t eytzinger_lower_bound_i32(const eytzinger_t *tree, int32_t key);
+size_t eytzinger_lower_bound_i64(const eytzinger_t *tree, int64_t key);
+
+/*
+ * Stores the slot `eytzinger_lower_bound_i32()` or `_i64()` would find for
+ * each of the `count` elements of `keys` in `slots`. Several searches advance
+ * in lockstep, so their cache misses are outstanding at the same time.
+ */
+void eytzinger_lower_bound_batch_i32(const eytzinger_t *tree,
+                                     const int32_t *keys, size_t count,
+                                     size_t *slots);
+void eytzinger_lower_bound_batch_i64(const eytzinger_t *tree,
+                                     const int64_t *keys, size_t count,
+                                     size_t *slots);
+
+#endif
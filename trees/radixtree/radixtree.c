@@ -0,0 +1,967 @@
+#include "radixtree.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../../allocator/allocator.h"
+#include "../../strext/strext.h"
+
+/*
+ * The number of prefix bytes an inner node stores itself. Longer prefixes are
+ * skipped by lookups, which compare the whole key with the leaf they reach,
+ * and read from a leaf below the node when an insertion must split them.
+ */
+#define MAX_STORED_PREFIX ((size_t)12)
+
+/*
+ * Nodes are replaced by the next smaller kind once removals leave them with
+ * this many children, a little below the smaller kind's capacity, so that
+ * alternating insertions and removals do not resize a node every time.
+ */
+#define NODE_16_SHRINK ((size_t)3)
+#define NODE_48_SHRINK ((size_t)12)
+#define NODE_256_SHRINK ((size_t)37)
+
+typedef unsigned char byte_t;
+
+enum node_type { NODE_LEAF, NODE_4, NODE_16, NODE_48, NODE_256 };
+
+/* The first member of every node, leaves included. */
+typedef struct rt_node {
+  uint8_t type;
+} rt_node;
+
+/* A leaf. Its value follows at the tree's `value_offset`, then its key. */
+typedef struct rt_leaf {
+  uint8_t type;
+  size_t key_len;
+} rt_leaf;
+
+/*
+ * The start of every inner node. Every key below the node continues with the
+ * same `prefix_len` bytes after the byte which selected the node, the first
+ * `MAX_STORED_PREFIX` of which are kept in `prefix`.
+ */
+typedef struct rt_inner {
+  uint8_t type;
+  uint16_t num_children;
+  uint32_t prefix_len;
+  byte_t prefix[MAX_STORED_PREFIX];
+  rt_leaf *terminal; /* The leaf whose key ends at this node, if any. */
+} rt_inner;
+
+/* Nodes of 4 and 16 children keep their bytes sorted, beside the children. */
+typedef struct rt_node4 {
+  rt_inner inner;
+  byte_t keys[4];
+  rt_node *children[4];
+} rt_node4;
+
+typedef struct rt_node16 {
+  rt_inner inner;
+  byte_t keys[16];
+  rt_node *children[16];
+} rt_node16;
+
+/* `index[b]` is one more than the slot of the child for byte `b`, or zero. */
+typedef struct rt_node48 {
+  rt_inner inner;
+  byte_t index[256];
+  rt_node *children[48];
+} rt_node48;
+
+typedef struct rt_node256 {
+  rt_inner inner;
+  rt_node *children[256];
+} rt_node256;
+
+static size_t round_to_alignment(const size_t size, const size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+static size_t min_size(const size_t a, const size_t b) { return a < b ? a : b; }
+
+/* - LEAVES - */
+
+static size_t leaf_size(const radix_tree_t *const tree, const size_t key_len) {
+  return tree->value_offset + tree->value_size + key_len;
+}
+
+static void *leaf_value(const radix_tree_t *const tree,
+                        const rt_leaf *const leaf) {
+  return (byte_t *)leaf + tree->value_offset;
+}
+
+static const byte_t *leaf_key(const radix_tree_t *const tree,
+                              const rt_leaf *const leaf) {
+  return (const byte_t *)leaf + tree->value_offset + tree->value_size;
+}
+
+static bool leaf_matches(const radix_tree_t *const tree,
+                         const rt_leaf *const leaf, const byte_t *const key,
+                         const size_t key_len) {
+  return leaf->key_len == key_len &&
+         memcmp(leaf_key(tree, leaf), key, key_len) == 0;
+}
+
+/* Returns whether the key of `leaf` is a prefix of `key`. */
+static bool leaf_prefixes(const radix_tree_t *const tree,
+                          const rt_leaf *const leaf, const byte_t *const key,
+                          const size_t key_len) {
+  return leaf->key_len <= key_len &&
+         memcmp(leaf_key(tree, leaf), key, leaf->key_len) == 0;
+}
+
+static rt_leaf *new_leaf(const radix_tree_t *const tree,
+                         const byte_t *const key, const size_t key_len,
+                         const void *const value) {
+  const allocator_t *const ALLOCATOR = tree->allocator;
+  rt_leaf *const leaf = ALLOCATOR->alloc(
+      ALLOCATOR->ctx, leaf_size(tree, key_len), DEFAULT_ALIGNMENT);
+  if (leaf == NULL) return NULL;
+  leaf->type = NODE_LEAF;
+  leaf->key_len = key_len;
+  memcpy(leaf_value(tree, leaf), value, tree->value_size);
+  memcpy((byte_t *)leaf_value(tree, leaf) + tree->value_size, key, key_len);
+  return leaf;
+}
+
+static void free_leaf(const radix_tree_t *const tree, rt_leaf *const leaf) {
+  const allocator_t *const ALLOCATOR = tree->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, leaf, leaf_size(tree, leaf->key_len),
+                  DEFAULT_ALIGNMENT);
+}
+
+/* - INNER NODES - */
+
+static size_t inner_size(const uint8_t type) {
+  switch (type) {
+    case NODE_4:
+      return sizeof(rt_node4);
+    case NODE_16:
+      return sizeof(rt_node16);
+    case NODE_48:
+      return sizeof(rt_node48);
+    default:
+      return sizeof(rt_node256);
+  }
+}
+
+/* Allocates an inner node of `type` with no prefix and no children. */
+static rt_inner *new_inner(const radix_tree_t *const tree,
+                           const uint8_t type) {
+  const allocator_t *const ALLOCATOR = tree->allocator;
+  rt_inner *const node =
+      ALLOCATOR->alloc(ALLOCATOR->ctx, inner_size(type), DEFAULT_ALIGNMENT);
+  if (node == NULL) return NULL;
+  memset(node, 0, inner_size(type));
+  node->type = type;
+  return node;
+}
+
+static void free_inner(const radix_tree_t *const tree, rt_inner *const node) {
+  const allocator_t *const ALLOCATOR = tree->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, node, inner_size(node->type),
+                  DEFAULT_ALIGNMENT);
+}
+
+/* Gives `dst` the prefix and terminal leaf of `src`. */
+static void copy_header(rt_inner *const dst, const rt_inner *const src) {
+  dst->prefix_len = src->prefix_len;
+  memcpy(dst->prefix, src->prefix, sizeof(dst->prefix));
+  dst->terminal = src->terminal;
+}
+
+/* Frees `node` and everything below it. */
+static void free_subtree(const radix_tree_t *const tree, rt_node *const node) {
+  if (node == NULL) return;
+  if (node->type == NODE_LEAF) {
+    free_leaf(tree, (rt_leaf *)node);
+    return;
+  }
+  rt_inner *const inner = (rt_inner *)node;
+  if (inner->terminal != NULL) free_leaf(tree, inner->terminal);
+  switch (inner->type) {
+    case NODE_4:
+      for (size_t i = 0; i < inner->num_children; i++)
+        free_subtree(tree, ((rt_node4 *)inner)->children[i]);
+      break;
+    case NODE_16:
+      for (size_t i = 0; i < inner->num_children; i++)
+        free_subtree(tree, ((rt_node16 *)inner)->children[i]);
+      break;
+    case NODE_48:
+      for (size_t i = 0; i < 48; i++)
+        free_subtree(tree, ((rt_node48 *)inner)->children[i]);
+      break;
+    case NODE_256:
+      for (size_t i = 0; i < 256; i++)
+        free_subtree(tree, ((rt_node256 *)inner)->children[i]);
+      break;
+  }
+  free_inner(tree, inner);
+}
+
+/* - CHILDREN - */
+
+/*
+ * Returns the slot holding the child of `node` for `byte`, or `NULL` if there
+ * is none.
+ */
+static rt_node **find_child(rt_inner *const node, const byte_t byte) {
+  const size_t COUNT = node->num_children;
+  switch (node->type) {
+    case NODE_4: {
+      rt_node4 *const n = (rt_node4 *)node;
+      for (size_t i = 0; i < COUNT; i++)
+        if (n->keys[i] == byte) return &n->children[i];
+      return NULL;
+    }
+    case NODE_16: {
+      rt_node16 *const n = (rt_node16 *)node;
+#ifdef __SSE2__
+      /* Compare all 16 bytes at once, ignoring the unused ones. */
+      const __m128i MATCHES =
+          _mm_cmpeq_epi8(_mm_set1_epi8((char)byte),
+                         _mm_loadu_si128((const __m128i *)n->keys));
+      const unsigned MASK =
+          (unsigned)_mm_movemask_epi8(MATCHES) & ((1u << COUNT) - 1);
+      return (MASK != 0) ? &n->children[__builtin_ctz(MASK)] : NULL;
+#else
+      for (size_t i = 0; i < COUNT; i++)
+        if (n->keys[i] == byte) return &n->children[i];
+      return NULL;
+#endif
+    }
+    case NODE_48: {
+      rt_node48 *const n = (rt_node48 *)node;
+      const size_t SLOT = n->index[byte];
+      return (SLOT != 0) ? &n->children[SLOT - 1] : NULL;
+    }
+    default: {
+      rt_node256 *const n = (rt_node256 *)node;
+      return (n->children[byte] != NULL) ? &n->children[byte] : NULL;
+    }
+  }
+}
+
+/*
+ * Returns the child of `node` for the least byte, storing that byte in
+ * `byte`, or `NULL` if `node` has no children.
+ */
+static rt_node *first_child(const rt_inner *const node, byte_t *const byte) {
+  if (node->num_children == 0) return NULL;
+  switch (node->type) {
+    case NODE_4:
+      *byte = ((const rt_node4 *)node)->keys[0];
+      return ((const rt_node4 *)node)->children[0];
+    case NODE_16:
+      *byte = ((const rt_node16 *)node)->keys[0];
+      return ((const rt_node16 *)node)->children[0];
+    case NODE_48: {
+      const rt_node48 *const n = (const rt_node48 *)node;
+      for (size_t b = 0; b < 256; b++) {
+        if (n->index[b] != 0) {
+          *byte = (byte_t)b;
+          return n->children[n->index[b] - 1];
+        }
+      }
+      return NULL;
+    }
+    default: {
+      const rt_node256 *const n = (const rt_node256 *)node;
+      for (size_t b = 0; b < 256; b++) {
+        if (n->children[b] != NULL) {
+          *byte = (byte_t)b;
+          return n->children[b];
+        }
+      }
+      return NULL;
+    }
+  }
+}
+
+/* Inserts `child` at `byte` into sorted arrays holding `count` children. */
+static void insert_sorted(byte_t *const keys, rt_node **const children,
+                          const size_t count, const byte_t byte,
+                          rt_node *const child) {
+  size_t pos = 0;
+  while (pos < count && keys[pos] < byte) pos++;
+  memmove(keys + pos + 1, keys + pos, count - pos);
+  memmove(children + pos + 1, children + pos,
+          (count - pos) * sizeof(*children));
+  keys[pos] = byte;
+  children[pos] = child;
+}
+
+/*
+ * Moves the children of the full `node` into a node of the next larger kind.
+ *
+ * \return The new node or `NULL` if it could not be allocated, in which case
+ * `node` is unmodified.
+ */
+static rt_inner *grow(const radix_tree_t *const tree, rt_inner *const node) {
+  rt_inner *const grown = new_inner(tree, (uint8_t)(node->type + 1));
+  if (grown == NULL) return NULL;
+  copy_header(grown, node);
+  grown->num_children = node->num_children;
+  switch (node->type) {
+    case NODE_4: {
+      const rt_node4 *const src = (const rt_node4 *)node;
+      rt_node16 *const dst = (rt_node16 *)grown;
+      memcpy(dst->keys, src->keys, sizeof(src->keys));
+      memcpy(dst->children, src->children, sizeof(src->children));
+      break;
+    }
+    case NODE_16: {
+      const rt_node16 *const src = (const rt_node16 *)node;
+      rt_node48 *const dst = (rt_node48 *)grown;
+      for (size_t i = 0; i < 16; i++) {
+        dst->index[src->keys[i]] = (byte_t)(i + 1);
+        dst->children[i] = src->children[i];
+      }
+      break;
+    }
+    case NODE_48: {
+      const rt_node48 *const src = (const rt_node48 *)node;
+      rt_node256 *const dst = (rt_node256 *)grown;
+      for (size_t b = 0; b < 256; b++)
+        if (src->index[b] != 0)
+          dst->children[b] = src->children[src->index[b] - 1];
+      break;
+    }
+  }
+  free_inner(tree, node);
+  return grown;
+}
+
+/*
+ * Adds `child` at `byte` to the inner node at `*ref`, which has no child
+ * there, replacing the node with a larger one if it is full.
+ *
+ * \return `true` upon success or `false` if a larger node could not be
+ * allocated.
+ */
+static bool add_child(const radix_tree_t *const tree, rt_node **const ref,
+                      const byte_t byte, rt_node *const child) {
+  rt_inner *node = (rt_inner *)*ref;
+  const size_t COUNT = node->num_children;
+  const bool FULL = (node->type == NODE_4 && COUNT == 4) ||
+                    (node->type == NODE_16 && COUNT == 16) ||
+                    (node->type == NODE_48 && COUNT == 48);
+  if (FULL) {
+    node = grow(tree, node);
+    if (node == NULL) return false;
+    *ref = (rt_node *)node;
+  }
+  switch (node->type) {
+    case NODE_4: {
+      rt_node4 *const n = (rt_node4 *)node;
+      insert_sorted(n->keys, n->children, COUNT, byte, child);
+      break;
+    }
+    case NODE_16: {
+      rt_node16 *const n = (rt_node16 *)node;
+      insert_sorted(n->keys, n->children, COUNT, byte, child);
+      break;
+    }
+    case NODE_48: {
+      rt_node48 *const n = (rt_node48 *)node;
+      size_t slot = 0;
+      while (n->children[slot] != NULL) slot++;
+      n->children[slot] = child;
+      n->index[byte] = (byte_t)(slot + 1);
+      break;
+    }
+    case NODE_256:
+      ((rt_node256 *)node)->children[byte] = child;
+      break;
+  }
+  node->num_children++;
+  return true;
+}
+
+/* Removes the child at `slot`, found by `find_child()` for `byte`. */
+static void remove_child(rt_inner *const node, rt_node **const slot,
+                         const byte_t byte) {
+  switch (node->type) {
+    case NODE_4:
+    case NODE_16: {
+      byte_t *const keys = (node->type == NODE_4)
+                               ? ((rt_node4 *)node)->keys
+                               : ((rt_node16 *)node)->keys;
+      rt_node **const children = (node->type == NODE_4)
+                                     ? ((rt_node4 *)node)->children
+                                     : ((rt_node16 *)node)->children;
+      const size_t POS = (size_t)(slot - children);
+      const size_t AFTER = node->num_children - POS - 1;
+      memmove(keys + POS, keys + POS + 1, AFTER);
+      memmove(children + POS, children + POS + 1, AFTER * sizeof(*children));
+      break;
+    }
+    case NODE_48:
+      *slot = NULL;
+      ((rt_node48 *)node)->index[byte] = 0;
+      break;
+    case NODE_256:
+      *slot = NULL;
+      break;
+  }
+  node->num_children--;
+}
+
+/*
+ * Replaces the inner node at `*ref`, which has one child and no terminal
+ * leaf, with that child, prepending the node's prefix and the child's byte
+ * to the child's prefix.
+ */
+static void collapse(const radix_tree_t *const tree, rt_node **const ref) {
+  rt_inner *const node = (rt_inner *)*ref;
+  byte_t byte;
+  rt_node *const child = first_child(node, &byte);
+  if (child->type != NODE_LEAF) {
+    rt_inner *const below = (rt_inner *)child;
+    byte_t prefix[MAX_STORED_PREFIX];
+    size_t stored = min_size(node->prefix_len, MAX_STORED_PREFIX);
+    memcpy(prefix, node->prefix, stored);
+    if (stored < MAX_STORED_PREFIX) prefix[stored++] = byte;
+    const size_t FROM_BELOW = min_size(below->prefix_len,
+                                       MAX_STORED_PREFIX - stored);
+    memcpy(prefix + stored, below->prefix, FROM_BELOW);
+    memcpy(below->prefix, prefix, stored + FROM_BELOW);
+    below->prefix_len += node->prefix_len + 1;
+  }
+  *ref = child;
+  free_inner(tree, node);
+}
+
+/*
+ * Moves the children of `node` into a new node of the next smaller kind.
+ *
+ * \return The new node or `NULL` if it could not be allocated, in which case
+ * `node` is unmodified.
+ */
+static rt_inner *shrink(const radix_tree_t *const tree, rt_inner *const node) {
+  rt_inner *const shrunk = new_inner(tree, (uint8_t)(node->type - 1));
+  if (shrunk == NULL) return NULL;
+  copy_header(shrunk, node);
+  shrunk->num_children = node->num_children;
+  switch (node->type) {
+    case NODE_16: {
+      const rt_node16 *const src = (const rt_node16 *)node;
+      rt_node4 *const dst = (rt_node4 *)shrunk;
+      memcpy(dst->keys, src->keys, node->num_children);
+      memcpy(dst->children, src->children,
+             node->num_children * sizeof(*src->children));
+      break;
+    }
+    case NODE_48: {
+      const rt_node48 *const src = (const rt_node48 *)node;
+      rt_node16 *const dst = (rt_node16 *)shrunk;
+      size_t count = 0;
+      for (size_t b = 0; b < 256; b++) {
+        if (src->index[b] != 0) {
+          dst->keys[count] = (byte_t)b;
+          dst->children[count++] = src->children[src->index[b] - 1];
+        }
+      }
+      break;
+    }
+    case NODE_256: {
+      const rt_node256 *const src = (const rt_node256 *)node;
+      rt_node48 *const dst = (rt_node48 *)shrunk;
+      size_t count = 0;
+      for (size_t b = 0; b < 256; b++) {
+        if (src->children[b] != NULL) {
+          dst->index[b] = (byte_t)(count + 1);
+          dst->children[count++] = src->children[b];
+        }
+      }
+      break;
+    }
+  }
+  free_inner(tree, node);
+  return shrunk;
+}
+
+/*
+ * Restores the shape of the inner node at `*ref` after a removal from it: a
+ * node with nothing left but its terminal leaf becomes that leaf, one with a
+ * single child and no terminal leaf merges into the child, and one with few
+ * children is replaced by a smaller kind. If that replacement cannot be
+ * allocated, the node simply stays larger than it needs to be.
+ */
+static void tidy(const radix_tree_t *const tree, rt_node **const ref) {
+  rt_inner *const node = (rt_inner *)*ref;
+  const size_t COUNT = node->num_children;
+  if (COUNT == 0) {
+    *ref = (rt_node *)node->terminal;
+    free_inner(tree, node);
+    return;
+  }
+  if (COUNT == 1 && node->terminal == NULL) {
+    collapse(tree, ref);
+    return;
+  }
+  const bool SPARSE = (node->type == NODE_16 && COUNT <= NODE_16_SHRINK) ||
+                      (node->type == NODE_48 && COUNT <= NODE_48_SHRINK) ||
+                      (node->type == NODE_256 && COUNT <= NODE_256_SHRINK);
+  if (SPARSE) {
+    rt_inner *const shrunk = shrink(tree, node);
+    if (shrunk != NULL) *ref = (rt_node *)shrunk;
+  }
+}
+
+/* - PREFIXES - */
+
+/*
+ * Returns the least leaf below `node`, whose key shares the prefix of every
+ * node on the way to it.
+ */
+static const rt_leaf *minimum_leaf(const rt_node *node) {
+  while (node->type != NODE_LEAF) {
+    const rt_inner *const inner = (const rt_inner *)node;
+    if (inner->terminal != NULL) return inner->terminal;
+    byte_t byte;
+    node = first_child(inner, &byte);
+  }
+  return (const rt_leaf *)node;
+}
+
+/*
+ * Returns whether `key`, from `depth` on, is long enough for the prefix of
+ * `node` and agrees with its stored bytes. Any further bytes are left for the
+ * leaf at the end of the lookup to confirm.
+ */
+static bool stored_prefix_matches(const rt_inner *const node,
+                                  const byte_t *const key,
+                                  const size_t key_len, const size_t depth) {
+  if (key_len - depth < node->prefix_len) return false;
+  const size_t STORED = min_size(node->prefix_len, MAX_STORED_PREFIX);
+  return memcmp(node->prefix, key + depth, STORED) == 0;
+}
+
+/*
+ * Returns the number of leading bytes of the prefix of `node` which `key`
+ * matches from `depth` on, checking every byte of the prefix.
+ */
+static size_t prefix_mismatch(const radix_tree_t *const tree,
+                              const rt_inner *const node,
+                              const byte_t *const key, const size_t key_len,
+                              const size_t depth) {
+  const size_t LIMIT = min_size(node->prefix_len, key_len - depth);
+  const size_t STORED = min_size(LIMIT, MAX_STORED_PREFIX);
+  size_t i = 0;
+  while (i < STORED && node->prefix[i] == key[depth + i]) i++;
+  if (i < STORED || LIMIT <= MAX_STORED_PREFIX) return i;
+  const byte_t *const FULL =
+      leaf_key(tree, minimum_leaf((const rt_node *)node)) + depth;
+  while (i < LIMIT && FULL[i] == key[depth + i]) i++;
+  return i;
+}
+
+/* - CREATION AND DELETION - */
+
+radix_tree_t *new_radix_tree(const size_t value_size) {
+  return new_radix_tree_with(value_size, NULL);
+}
+
+radix_tree_t *new_radix_tree_with(const size_t value_size,
+                                  const allocator_t *const allocator) {
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  radix_tree_t *const tree =
+      ALLOCATOR->alloc(ALLOCATOR->ctx, sizeof(radix_tree_t), DEFAULT_ALIGNMENT);
+  if (tree == NULL) return NULL;
+  tree->root = NULL;
+  tree->length = 0;
+  tree->value_size = value_size;
+  tree->value_offset = round_to_alignment(sizeof(rt_leaf), DEFAULT_ALIGNMENT);
+  tree->allocator = ALLOCATOR;
+  return tree;
+}
+
+void delete_radix_tree(radix_tree_t **const tree) {
+  free_subtree(*tree, (*tree)->root);
+  const allocator_t *const ALLOCATOR = (*tree)->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, *tree, sizeof(radix_tree_t),
+                  DEFAULT_ALIGNMENT);
+  *tree = NULL;
+}
+
+/* - INSERTION - */
+
+/*
+ * Stores `leaf`, whose key matches every byte on the way to `*ref`, in the new
+ * inner node at `*ref` whose prefix ends at `depth`.
+ */
+static void place_leaf(const radix_tree_t *const tree, rt_node **const ref,
+                       rt_leaf *const leaf, const size_t depth) {
+  if (leaf->key_len == depth)
+    ((rt_inner *)*ref)->terminal = leaf;
+  else
+    add_child(tree, ref, leaf_key(tree, leaf)[depth], (rt_node *)leaf);
+}
+
+/*
+ * Replaces the leaf at `*ref`, reached after `depth` bytes of `key` and whose
+ * key differs from it, with an inner node holding both it and a new leaf.
+ */
+static void *split_leaf(radix_tree_t *const tree, rt_node **const ref,
+                        const size_t depth, const byte_t *const key,
+                        const size_t key_len, const void *const value) {
+  rt_leaf *const old = (rt_leaf *)*ref;
+  const byte_t *const OLD_KEY = leaf_key(tree, old);
+  const size_t LIMIT = min_size(old->key_len, key_len) - depth;
+  size_t common = 0;
+  while (common < LIMIT && OLD_KEY[depth + common] == key[depth + common])
+    common++;
+
+  rt_leaf *const leaf = new_leaf(tree, key, key_len, value);
+  rt_inner *const split = new_inner(tree, NODE_4);
+  if (leaf == NULL || split == NULL) {
+    if (leaf != NULL) free_leaf(tree, leaf);
+    if (split != NULL) free_inner(tree, split);
+    return NULL;
+  }
+  split->prefix_len = (uint32_t)common;
+  memcpy(split->prefix, key + depth, min_size(common, MAX_STORED_PREFIX));
+  rt_node *node = (rt_node *)split;
+  place_leaf(tree, &node, old, depth + common);
+  place_leaf(tree, &node, leaf, depth + common);
+  *ref = node;
+  tree->length++;
+  return leaf_value(tree, leaf);
+}
+
+/*
+ * Splits the prefix of the inner node at `*ref`, reached after `depth` bytes
+ * of `key`, where the first `mismatch` bytes of the prefix match `key` and the
+ * next does not, placing a new inner node holding the old one and a new leaf
+ * above it.
+ */
+static void *split_prefix(radix_tree_t *const tree, rt_node **const ref,
+                          const size_t depth, const size_t mismatch,
+                          const byte_t *const key, const size_t key_len,
+                          const void *const value) {
+  rt_inner *const node = (rt_inner *)*ref;
+  rt_leaf *const leaf = new_leaf(tree, key, key_len, value);
+  rt_inner *const split = new_inner(tree, NODE_4);
+  if (leaf == NULL || split == NULL) {
+    if (leaf != NULL) free_leaf(tree, leaf);
+    if (split != NULL) free_inner(tree, split);
+    return NULL;
+  }
+  split->prefix_len = (uint32_t)mismatch;
+  memcpy(split->prefix, node->prefix, min_size(mismatch, MAX_STORED_PREFIX));
+
+  /* `node` keeps what follows the byte at which the keys diverge. */
+  byte_t branch;
+  const size_t REMAINING = node->prefix_len - mismatch - 1;
+  if (node->prefix_len <= MAX_STORED_PREFIX) {
+    branch = node->prefix[mismatch];
+    memmove(node->prefix, node->prefix + mismatch + 1, REMAINING);
+  } else {
+    const byte_t *const FULL =
+        leaf_key(tree, minimum_leaf((const rt_node *)node)) + depth;
+    branch = FULL[mismatch];
+    memcpy(node->prefix, FULL + mismatch + 1,
+           min_size(REMAINING, MAX_STORED_PREFIX));
+  }
+  node->prefix_len = (uint32_t)REMAINING;
+
+  rt_node *top = (rt_node *)split;
+  add_child(tree, &top, branch, (rt_node *)node);
+  place_leaf(tree, &top, leaf, depth + mismatch);
+  *ref = top;
+  tree->length++;
+  return leaf_value(tree, leaf);
+}
+
+void *radix_insert(radix_tree_t *const tree, const void *const key,
+                   const size_t key_len, const void *const value) {
+  if (key_len > UINT32_MAX) return NULL;
+  const byte_t *const KEY = key;
+  rt_node **ref = &tree->root;
+  size_t depth = 0;
+  while (true) {
+    rt_node *const node = *ref;
+    if (node == NULL) {
+      rt_leaf *const leaf = new_leaf(tree, KEY, key_len, value);
+      if (leaf == NULL) return NULL;
+      *ref = (rt_node *)leaf;
+      tree->length++;
+      return leaf_value(tree, leaf);
+    }
+    if (node->type == NODE_LEAF) {
+      rt_leaf *const leaf = (rt_leaf *)node;
+      if (!leaf_matches(tree, leaf, KEY, key_len))
+        return split_leaf(tree, ref, depth, KEY, key_len, value);
+      return memcpy(leaf_value(tree, leaf), value, tree->value_size);
+    }
+
+    rt_inner *const inner = (rt_inner *)node;
+    if (inner->prefix_len != 0) {
+      const size_t MISMATCH =
+          prefix_mismatch(tree, inner, KEY, key_len, depth);
+      if (MISMATCH < inner->prefix_len)
+        return split_prefix(tree, ref, depth, MISMATCH, KEY, key_len, value);
+      depth += inner->prefix_len;
+    }
+    if (depth == key_len) {
+      if (inner->terminal != NULL) {
+        return memcpy(leaf_value(tree, inner->terminal), value,
+                      tree->value_size);
+      }
+      inner->terminal = new_leaf(tree, KEY, key_len, value);
+      if (inner->terminal == NULL) return NULL;
+      tree->length++;
+      return leaf_value(tree, inner->terminal);
+    }
+    rt_node **const child = find_child(inner, KEY[depth]);
+    if (child == NULL) {
+      rt_leaf *const leaf = new_leaf(tree, KEY, key_len, value);
+      if (leaf == NULL) return NULL;
+      if (!add_child(tree, ref, KEY[depth], (rt_node *)leaf)) {
+        free_leaf(tree, leaf);
+        return NULL;
+      }
+      tree->length++;
+      return leaf_value(tree, leaf);
+    }
+    ref = child;
+    depth++;
+  }
+}
+
+/* - LOOKUP AND REMOVAL - */
+
+void *radix_find(const radix_tree_t *const tree, const void *const key,
+                 const size_t key_len) {
+  const byte_t *const KEY = key;
+  const rt_node *node = tree->root;
+  size_t depth = 0;
+  while (node != NULL) {
+    if (node->type == NODE_LEAF) {
+      const rt_leaf *const leaf = (const rt_leaf *)node;
+      return leaf_matches(tree, leaf, KEY, key_len) ? leaf_value(tree, leaf)
+                                                     : NULL;
+    }
+    rt_inner *const inner = (rt_inner *)node;
+    if (!stored_prefix_matches(inner, KEY, key_len, depth)) return NULL;
+    depth += inner->prefix_len;
+    if (depth == key_len) {
+      const rt_leaf *const leaf = inner->terminal;
+      return (leaf != NULL && leaf_matches(tree, leaf, KEY, key_len))
+                 ? leaf_value(tree, leaf)
+                 : NULL;
+    }
+    rt_node **const child = find_child(inner, KEY[depth++]);
+    node = (child != NULL) ? *child : NULL;
+  }
+  return NULL;
+}
+
+bool radix_erase(radix_tree_t *const tree, const void *const key,
+                 const size_t key_len) {
+  const byte_t *const KEY = key;
+  rt_node **ref = &tree->root;
+  size_t depth = 0;
+  while (*ref != NULL) {
+    if ((*ref)->type == NODE_LEAF) {
+      /* Only a tree of one key has a leaf at its root. */
+      rt_leaf *const leaf = (rt_leaf *)*ref;
+      if (!leaf_matches(tree, leaf, KEY, key_len)) return false;
+      *ref = NULL;
+      free_leaf(tree, leaf);
+      tree->length--;
+      return true;
+    }
+    rt_inner *const inner = (rt_inner *)*ref;
+    if (!stored_prefix_matches(inner, KEY, key_len, depth)) return false;
+    depth += inner->prefix_len;
+    if (depth == key_len) {
+      rt_leaf *const leaf = inner->terminal;
+      if (leaf == NULL || !leaf_matches(tree, leaf, KEY, key_len))
+        return false;
+      inner->terminal = NULL;
+      free_leaf(tree, leaf);
+      tree->length--;
+      tidy(tree, ref);
+      return true;
+    }
+    rt_node **const child = find_child(inner, KEY[depth]);
+    if (child == NULL) return false;
+    if ((*child)->type == NODE_LEAF) {
+      rt_leaf *const leaf = (rt_leaf *)*child;
+      if (!leaf_matches(tree, leaf, KEY, key_len)) return false;
+      remove_child(inner, child, KEY[depth]);
+      free_leaf(tree, leaf);
+      tree->length--;
+      tidy(tree, ref);
+      return true;
+    }
+    ref = child;
+    depth++;
+  }
+  return false;
+}
+
+void *radix_longest_prefix(const radix_tree_t *const tree,
+                           const void *const key, const size_t key_len,
+                           size_t *const match_len) {
+  const byte_t *const KEY = key;
+  const rt_leaf *best = NULL;
+  const rt_node *node = tree->root;
+  size_t depth = 0;
+  while (node != NULL) {
+    if (node->type == NODE_LEAF) {
+      const rt_leaf *const leaf = (const rt_leaf *)node;
+      if (leaf_prefixes(tree, leaf, KEY, key_len)) best = leaf;
+      break;
+    }
+    rt_inner *const inner = (rt_inner *)node;
+    if (!stored_prefix_matches(inner, KEY, key_len, depth)) break;
+    depth += inner->prefix_len;
+    /*
+     * Lookups skip the prefix bytes nodes do not store, so a terminal leaf
+     * is only a match once its whole key has been compared.
+     */
+    const rt_leaf *const terminal = inner->terminal;
+    if (terminal != NULL) {
+      if (!leaf_prefixes(tree, terminal, KEY, key_len)) break;
+      best = terminal;
+    }
+    if (depth == key_len) break;
+    rt_node **const child = find_child(inner, KEY[depth++]);
+    node = (child != NULL) ? *child : NULL;
+  }
+  if (best == NULL) return NULL;
+  if (match_len != NULL) *match_len = best->key_len;
+  return leaf_value(tree, best);
+}
+
+/* - ITERATION - */
+
+/*
+ * Passes the leaves below `node` to `visit` in order, counting them in
+ * `visited`.
+ *
+ * \return `false` once `visit` has asked to stop.
+ */
+static bool visit_subtree(const radix_tree_t *const tree,
+                          const rt_node *const node, const radix_visit_t visit,
+                          void *const ctx, size_t *const visited) {
+  if (node->type == NODE_LEAF) {
+    const rt_leaf *const leaf = (const rt_leaf *)node;
+    ++*visited;
+    return visit(leaf_key(tree, leaf), leaf->key_len, leaf_value(tree, leaf),
+                 ctx);
+  }
+  const rt_inner *const inner = (const rt_inner *)node;
+  /* A key ending at this node is a prefix of, and so precedes, the rest. */
+  if (inner->terminal != NULL &&
+      !visit_subtree(tree, (const rt_node *)inner->terminal, visit, ctx,
+                     visited))
+    return false;
+  switch (inner->type) {
+    case NODE_4: {
+      const rt_node4 *const n = (const rt_node4 *)inner;
+      for (size_t i = 0; i < inner->num_children; i++)
+        if (!visit_subtree(tree, n->children[i], visit, ctx, visited))
+          return false;
+      break;
+    }
+    case NODE_16: {
+      const rt_node16 *const n = (const rt_node16 *)inner;
+      for (size_t i = 0; i < inner->num_children; i++)
+        if (!visit_subtree(tree, n->children[i], visit, ctx, visited))
+          return false;
+      break;
+    }
+    case NODE_48: {
+      const rt_node48 *const n = (const rt_node48 *)inner;
+      for (size_t b = 0; b < 256; b++) {
+        if (n->index[b] != 0 &&
+            !visit_subtree(tree, n->children[n->index[b] - 1], visit, ctx,
+                           visited))
+          return false;
+      }
+      break;
+    }
+    case NODE_256: {
+      const rt_node256 *const n = (const rt_node256 *)inner;
+      for (size_t b = 0; b < 256; b++) {
+        if (n->children[b] != NULL &&
+            !visit_subtree(tree, n->children[b], visit, ctx, visited))
+          return false;
+      }
+      break;
+    }
+  }
+  return true;
+}
+
+size_t radix_iterate_prefix(const radix_tree_t *const tree,
+                            const void *const prefix, const size_t prefix_len,
+                            const radix_visit_t visit, void *const ctx) {
+  const byte_t *const PREFIX = prefix;
+  const rt_node *node = tree->root;
+  size_t depth = 0;
+  /* Find the highest node below which every key is as long as `prefix`. */
+  while (node != NULL && node->type != NODE_LEAF && depth < prefix_len) {
+    rt_inner *const inner = (rt_inner *)node;
+    const size_t COMPARED = min_size(
+        min_size(inner->prefix_len, prefix_len - depth), MAX_STORED_PREFIX);
+    if (memcmp(inner->prefix, PREFIX + depth, COMPARED) != 0) return 0;
+    depth += inner->prefix_len;
+    if (depth >= prefix_len) break;
+    rt_node **const child = find_child(inner, PREFIX[depth++]);
+    node = (child != NULL) ? *child : NULL;
+  }
+  if (node == NULL) return 0;
+  /*
+   * The keys below `node` agree on every byte of `prefix`, so checking the
+   * least of them covers the bytes the lookup skipped.
+   */
+  const rt_leaf *const least = minimum_leaf(node);
+  if (least->key_len < prefix_len ||
+      memcmp(leaf_key(tree, least), PREFIX, prefix_len) != 0)
+    return 0;
+  size_t visited = 0;
+  visit_subtree(tree, node, visit, ctx, &visited);
+  return visited;
+}
+
+/* - STRING KEYS - */
+
+void *radix_insert_str(radix_tree_t *const tree, const string_t *const key,
+                       const void *const value) {
+  return radix_insert(tree, key->data, key->length, value);
+}
+
+void *radix_find_str(const radix_tree_t *const tree,
+                     const string_t *const key) {
+  return radix_find(tree, key->data, key->length);
+}
+
+bool radix_erase_str(radix_tree_t *const tree, const string_t *const key) {
+  return radix_erase(tree, key->data, key->length);
+}
+
+void *radix_longest_prefix_str(const radix_tree_t *const tree,
+                               const string_t *const key,
+                               size_t *const match_len) {
+  return radix_longest_prefix(tree, key->data, key->length, match_len);
+}
+
+size_t radix_iterate_prefix_str(const radix_tree_t *const tree,
+                                const string_t *const prefix,
+                                const radix_visit_t visit, void *const ctx) {
+  return radix_iterate_prefix(tree, prefix->data, prefix->length, visit, ctx);
+}
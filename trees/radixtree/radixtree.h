@@ -0,0 +1,124 @@
+#ifndef RADIXTREE_H
+#define RADIXTREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../../allocator/allocator.h"
+#include "../../strext/strext.h"
+
+/*
+ * Receives each key and value of an iteration along with the caller's `ctx`.
+ * The key is not null-terminated.
+ *
+ * \return `true` to continue the iteration or `false` to stop it.
+ */
+typedef bool (*radix_visit_t)(const void *key, size_t key_len, void *value,
+                              void *ctx);
+
+/*
+ * An adaptive radix tree mapping byte-string keys to fixed-size values.
+ *
+ * Each inner node branches on one byte of the key and is the smallest of four
+ * kinds with room for its children: 4 or 16 sorted bytes beside their
+ * children, a 256-byte index into 48 children, or 256 children indexed
+ * directly. A node with 16 children is searched with one SSE2 comparison.
+ * Runs of bytes with no branching are stored once in the node below them
+ * rather than as a chain of single-child nodes.
+ *
+ * Keys are arbitrary bytes, and one key may be a prefix of another. Each key
+ * and its value live in a leaf, whose address stays stable until the key is
+ * erased. Iteration visits keys in lexicographic order of their bytes.
+ */
+typedef struct radix_tree_t {
+  struct rt_node *root;
+  size_t length;
+  size_t value_size;
+  size_t value_offset; /* The offset of a leaf's value from the leaf. */
+  const allocator_t *allocator;
+} radix_tree_t;
+
+/*
+ * Creates an empty radix tree of `value_size`-byte values.
+ *
+ * \return A pointer to the new tree or `NULL` upon failure.
+ */
+radix_tree_t *new_radix_tree(size_t value_size);
+
+/*
+ * Same as `new_radix_tree()`, except the tree's memory is obtained from and
+ * returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+radix_tree_t *new_radix_tree_with(size_t value_size,
+                                  const allocator_t *allocator);
+
+/*
+ * Frees the passed radix tree's consumed memory and reassigns its pointer to
+ * `NULL`.
+ */
+void delete_radix_tree(radix_tree_t **tree);
+
+/*
+ * Maps the `key_len` bytes of `key` to a copy of `value`, replacing any value
+ * the key already had.
+ *
+ * \return A pointer to the stored value or `NULL` upon failure or if
+ * `key_len` exceeds `UINT32_MAX`.
+ */
+void *radix_insert(radix_tree_t *tree, const void *key, size_t key_len,
+                   const void *value);
+
+/*
+ * Returns a pointer to the value the `key_len` bytes of `key` map to, or
+ * `NULL` if the key is absent.
+ */
+void *radix_find(const radix_tree_t *tree, const void *key, size_t key_len);
+
+/*
+ * Removes the `key_len` bytes of `key` from `tree`.
+ *
+ * \return `true` if the key was removed or `false` if it was absent.
+ */
+bool radix_erase(radix_tree_t *tree, const void *key, size_t key_len);
+
+/*
+ * Finds the longest key of `tree` which is a prefix of the `key_len` bytes of
+ * `key`, including `key` itself, and stores its length in `match_len` unless
+ * `match_len` is `NULL`.
+ *
+ * \return A pointer to the found key's value or `NULL` if there is none.
+ */
+void *radix_longest_prefix(const radix_tree_t *tree, const void *key,
+                           size_t key_len, size_t *match_len);
+
+/*
+ * Passes every key of `tree` starting with the `prefix_len` bytes of `prefix`
+ * to `visit` in lexicographic order until `visit` returns `false`. The tree
+ * must not be modified during the iteration.
+ *
+ * \return The number of keys visited.
+ */
+size_t radix_iterate_prefix(const radix_tree_t *tree, const void *prefix,
+                            size_t prefix_len, radix_visit_t visit,
+                            void *ctx);
+
+/* Same as `radix_insert()`, but keyed by the characters of `key`. */
+void *radix_insert_str(radix_tree_t *tree, const string_t *key,
+                       const void *value);
+
+/* Same as `radix_find()`, but keyed by the characters of `key`. */
+void *radix_find_str(const radix_tree_t *tree, const string_t *key);
+
+/* Same as `radix_erase()`, but keyed by the characters of `key`. */
+bool radix_erase_str(radix_tree_t *tree, const string_t *key);
+
+/* Same as `radix_longest_prefix()`, but keyed by the characters of `key`. */
+void *radix_longest_prefix_str(const radix_tree_t *tree, const string_t *key,
+                               size_t *match_len);
+
+/* Same as `radix_iterate_prefix()`, but with the characters of `prefix`. */
+size_t radix_iterate_prefix_str(const radix_tree_t *tree,
+                                const string_t *prefix, radix_visit_t visit,
+                                void *ctx);
+
+#endif
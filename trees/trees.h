@@ -4,14 +4,34 @@
 #include <stddef.h>
 
 #include "binarytree/binarytree.h"
+#include "bplustree/bplustree.h"
+#include "bst/bst.h"
+#include "compacttree/compacttree.h"
+#include "radixtree/radixtree.h"
 
-#define delete_tree(tree) \
-  (_Generic((tree), binary_tree *: delete_binary_tree)(&(tree)))
-#define delete_tree_s(tree) \
-  (_Generic((tree), binary_tree *: delete_binary_tree_s)(&(tree)))
-#define add_node(tree, node) \
-  (_Generic(tree, binary_tree *: add_binary_node)(tree, node))
-#define remove_node(tree, node) \
-  (_Generic(tree, binary_tree *: remove_binary_node)(tree, node))
+/* clang-format off */
+#define delete_tree(tree)                         \
+  (_Generic((tree),                               \
+  binary_tree *: delete_binary_tree,              \
+  compact_tree *: delete_compact_tree,            \
+  bst_t *: delete_bst,                            \
+  bplus_tree_t *: delete_bplus_tree,              \
+  radix_tree_t *: delete_radix_tree)(&(tree)))
+#define delete_tree_s(tree)                       \
+  (_Generic((tree),                               \
+  binary_tree *: delete_binary_tree_s,            \
+  compact_tree *: delete_compact_tree_s,          \
+  bst_t *: delete_bst_s)(&(tree)))
+#define add_node(tree, node)                      \
+  (_Generic(tree,                                 \
+  binary_tree *: add_binary_node,                 \
+  compact_tree *: add_compact_node,               \
+  bst_t *: bst_insert)(tree, node))
+#define remove_node(tree, node)                   \
+  (_Generic(tree,                                 \
+  binary_tree *: remove_binary_node,              \
+  compact_tree *: remove_compact_node,            \
+  bst_t *: bst_erase_node)(tree, node))
+/* clang-format on */
 
 #endif
@@ -0,0 +1,478 @@
+#include "compressedvector.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../allocator/allocator.h"
+#include "../dispatch/dispatch.h"
+#include "vector.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS (1)
+#include <emmintrin.h>
+#else
+#define HAVE_X86_KERNELS (0)
+#endif
+
+/*
+ * Offsets of up to `LANE_BITS` bits are packed into `LANES` interleaved lanes
+ * of 32-bit words, and wider ones into a single stream of 64-bit words. Both
+ * take `16 * bits` bytes per block.
+ */
+#define LANE_BITS (32u)
+#define LANES ((size_t)4)
+
+/* The most bytes one block may take under `COMPRESSED_VARINT`. */
+#define MAX_VARINT_BLOCK (COMPRESSED_BLOCK_LEN * 10)
+
+#define EXPANSION_FACTOR (2)
+#define BASE_DATA_CAPACITY ((size_t)4096)
+#define BASE_BLOCKS_CAPACITY ((size_t)16)
+
+/* Flipping the sign bit orders unsigned integers as their signed values. */
+#define SIGN_BIT ((uint64_t)1 << 63)
+
+typedef unsigned char byte_t;
+
+/*
+ * Decodes a block of `COMPRESSED_BLOCK_LEN` offsets of `bits` bits, `bits`
+ * being from 1 to `LANE_BITS`, into `out`: value `i` is `prev` plus the sum
+ * of the first `i + 1` offsets, each increased by `base`.
+ */
+typedef void (*decode_lanes_t)(const byte_t *packed, unsigned bits,
+                               uint64_t base, uint64_t prev, uint64_t *out);
+
+/* - BIT PACKING - */
+
+static unsigned bit_width(uint64_t value) {
+  unsigned width = 0;
+  for (; value != 0; value >>= 1) width++;
+  return width;
+}
+
+/*
+ * Offset `i` belongs to lane `i % LANES`, whose words are every `LANES`th
+ * 32-bit word, and starts at bit `(i / LANES) * bits` of that lane. Thus each
+ * 16-byte load holds the same bits of four consecutive offsets, and a vector
+ * of four lanes unpacks them with the shifts one lane would need.
+ */
+static void pack_lanes(const uint64_t *const offsets, const unsigned bits,
+                       byte_t *const packed) {
+  uint32_t words[LANES * LANE_BITS] = {0};
+  for (size_t i = 0; i < COMPRESSED_BLOCK_LEN; i++) {
+    const size_t LANE = i % LANES, POS = (i / LANES) * bits;
+    const size_t WORD = POS / LANE_BITS;
+    const unsigned SHIFT = POS % LANE_BITS;
+    words[WORD * LANES + LANE] |= (uint32_t)(offsets[i] << SHIFT);
+    if (SHIFT + bits > LANE_BITS) {
+      words[(WORD + 1) * LANES + LANE] |=
+          (uint32_t)(offsets[i] >> (LANE_BITS - SHIFT));
+    }
+  }
+  memcpy(packed, words, 16 * (size_t)bits);
+}
+
+static void decode_lanes_scalar(const byte_t *const packed,
+                                const unsigned bits, const uint64_t base,
+                                uint64_t value, uint64_t *const out) {
+  uint32_t words[LANES * LANE_BITS];
+  memcpy(words, packed, 16 * (size_t)bits);
+  const uint32_t MASK = (bits == LANE_BITS) ? UINT32_MAX : (1u << bits) - 1;
+  for (size_t i = 0; i < COMPRESSED_BLOCK_LEN; i++) {
+    const size_t LANE = i % LANES, POS = (i / LANES) * bits;
+    const size_t WORD = POS / LANE_BITS;
+    const unsigned SHIFT = POS % LANE_BITS;
+    uint32_t offset = words[WORD * LANES + LANE] >> SHIFT;
+    if (SHIFT + bits > LANE_BITS)
+      offset |= words[(WORD + 1) * LANES + LANE] << (LANE_BITS - SHIFT);
+    value += base + (offset & MASK);
+    out[i] = value;
+  }
+}
+
+/* Offset `i` starts at bit `i * bits` of a stream of 64-bit words. */
+static void pack_wide(const uint64_t *const offsets, const unsigned bits,
+                      byte_t *const packed) {
+  uint64_t words[2 * 64] = {0};
+  for (size_t i = 0; i < COMPRESSED_BLOCK_LEN; i++) {
+    const size_t POS = i * bits, WORD = POS / 64;
+    const unsigned SHIFT = POS % 64;
+    words[WORD] |= offsets[i] << SHIFT;
+    if (SHIFT + bits > 64) words[WORD + 1] |= offsets[i] >> (64 - SHIFT);
+  }
+  memcpy(packed, words, 16 * (size_t)bits);
+}
+
+static void unpack_wide(const byte_t *const packed, const unsigned bits,
+                        uint64_t *const out) {
+  uint64_t words[2 * 64];
+  memcpy(words, packed, 16 * (size_t)bits);
+  const uint64_t MASK = (bits == 64) ? UINT64_MAX : ((uint64_t)1 << bits) - 1;
+  for (size_t i = 0; i < COMPRESSED_BLOCK_LEN; i++) {
+    const size_t POS = i * bits, WORD = POS / 64;
+    const unsigned SHIFT = POS % 64;
+    uint64_t value = words[WORD] >> SHIFT;
+    if (SHIFT + bits > 64) value |= words[WORD + 1] << (64 - SHIFT);
+    out[i] = value & MASK;
+  }
+}
+
+#if HAVE_X86_KERNELS
+/*
+ * The lane layout fixes vectors at four 32-bit lanes, so every instruction
+ * set runs the same 16-byte kernel, encoded for that set. The kernel is
+ * inlined into one case per width, which lets the compiler unroll it and
+ * resolve every shift and load at compile time.
+ *
+ * Each group of four offsets is summed within its vector before being
+ * widened, so the running total, which every value waits on, advances once
+ * per four values rather than once per value. Four offsets of up to 30 bits
+ * cannot overflow their 32-bit lanes; wider ones are decoded as scalars.
+ */
+typedef uint32_t u32_v16 __attribute__((vector_size(16)));
+
+/* clang-format off */
+#define DECODE_CASE(isa, bits)                                                \
+  case bits: decode_fixed_##isa(packed, bits, base, prev, out); return;
+
+#define DEFINE_DECODE(isa, ATTR)                                              \
+  ATTR static inline __attribute__((always_inline)) void                      \
+  decode_fixed_##isa(const byte_t *const packed, const unsigned bits,         \
+                     const uint64_t base, const uint64_t prev,                \
+                     uint64_t *const out) {                                   \
+    const u32_v16 MASK = (u32_v16){0} + ((1u << bits) - 1);                   \
+    const __m128i ZERO = _mm_setzero_si128();                                 \
+    /* The first four values gain one to four copies of `base`. */           \
+    const __m128i BASES_LOW = _mm_set_epi64x((long long)(2 * base),           \
+                                             (long long)base);                \
+    const __m128i BASES_HIGH = _mm_set_epi64x((long long)(4 * base),          \
+                                              (long long)(3 * base));         \
+    __m128i total = _mm_set1_epi64x((long long)prev);                         \
+    u32_v16 word;                                                             \
+    memcpy(&word, packed, sizeof(word));                                      \
+    size_t next = 1;                                                          \
+    unsigned shift = 0;                                                       \
+    _Pragma("GCC unroll 32")                                                  \
+    for (size_t k = 0; k < COMPRESSED_BLOCK_LEN / LANES; k++) {               \
+      u32_v16 offsets = word >> shift;                                        \
+      if (shift + bits >= LANE_BITS) {                                        \
+        if (next < bits)                                                      \
+          memcpy(&word, packed + next * sizeof(word), sizeof(word));          \
+        next++;                                                               \
+        if (shift + bits > LANE_BITS) offsets |= word << (LANE_BITS - shift); \
+        shift = shift + bits - LANE_BITS;                                     \
+      } else {                                                                \
+        shift += bits;                                                        \
+      }                                                                       \
+      __m128i sums = (__m128i)(offsets & MASK);                               \
+      sums = _mm_add_epi32(sums, _mm_slli_si128(sums, 4));                    \
+      sums = _mm_add_epi32(sums, _mm_slli_si128(sums, 8));                    \
+      const __m128i LOW = _mm_add_epi64(                                      \
+          _mm_add_epi64(_mm_unpacklo_epi32(sums, ZERO), BASES_LOW), total);   \
+      const __m128i HIGH = _mm_add_epi64(                                     \
+          _mm_add_epi64(_mm_unpackhi_epi32(sums, ZERO), BASES_HIGH), total);  \
+      _mm_storeu_si128((__m128i *)(out + k * LANES), LOW);                    \
+      _mm_storeu_si128((__m128i *)(out + k * LANES + 2), HIGH);               \
+      total = _mm_unpackhi_epi64(HIGH, HIGH);                                 \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  ATTR static void decode_lanes_##isa(const byte_t *const packed,             \
+                                      const unsigned bits,                    \
+                                      const uint64_t base,                    \
+                                      const uint64_t prev,                    \
+                                      uint64_t *const out) {                  \
+    switch (bits) {                                                           \
+      DECODE_CASE(isa, 1)  DECODE_CASE(isa, 2)  DECODE_CASE(isa, 3)           \
+      DECODE_CASE(isa, 4)  DECODE_CASE(isa, 5)  DECODE_CASE(isa, 6)           \
+      DECODE_CASE(isa, 7)  DECODE_CASE(isa, 8)  DECODE_CASE(isa, 9)           \
+      DECODE_CASE(isa, 10) DECODE_CASE(isa, 11) DECODE_CASE(isa, 12)          \
+      DECODE_CASE(isa, 13) DECODE_CASE(isa, 14) DECODE_CASE(isa, 15)          \
+      DECODE_CASE(isa, 16) DECODE_CASE(isa, 17) DECODE_CASE(isa, 18)          \
+      DECODE_CASE(isa, 19) DECODE_CASE(isa, 20) DECODE_CASE(isa, 21)          \
+      DECODE_CASE(isa, 22) DECODE_CASE(isa, 23) DECODE_CASE(isa, 24)          \
+      DECODE_CASE(isa, 25) DECODE_CASE(isa, 26) DECODE_CASE(isa, 27)          \
+      DECODE_CASE(isa, 28) DECODE_CASE(isa, 29) DECODE_CASE(isa, 30)          \
+      default: decode_lanes_scalar(packed, bits, base, prev, out);            \
+    }                                                                         \
+  }
+/* clang-format on */
+
+DEFINE_DECODE(sse2, __attribute__((target("sse2"))))
+DEFINE_DECODE(avx2, __attribute__((target("avx2"))))
+DEFINE_DECODE(avx512,
+              __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl"))))
+#endif
+
+/* Levels without kernels on this architecture are never selected. */
+static const decode_lanes_t DECODE_LANES[SIMD_LEVEL_COUNT] = {
+    [SIMD_SCALAR] = decode_lanes_scalar,
+#if HAVE_X86_KERNELS
+    [SIMD_SSE2] = decode_lanes_sse2,
+    [SIMD_AVX2] = decode_lanes_avx2,
+    [SIMD_AVX512] = decode_lanes_avx512,
+#endif
+};
+
+/* - VARINTS - */
+
+/* Maps small magnitudes of either sign to small unsigned integers. */
+static uint64_t zigzag(const uint64_t delta) {
+  return (delta << 1) ^ (0 - (delta >> 63));
+}
+
+static uint64_t unzigzag(const uint64_t value) {
+  return (value >> 1) ^ (0 - (value & 1));
+}
+
+static size_t put_varint(uint64_t value, byte_t *const out) {
+  size_t length = 0;
+  for (; value >= 0x80; value >>= 7) out[length++] = (byte_t)(value | 0x80);
+  out[length++] = (byte_t)value;
+  return length;
+}
+
+static uint64_t get_varint(const byte_t **const in) {
+  uint64_t value = 0;
+  unsigned shift = 0;
+  const byte_t *p = *in;
+  for (; *p & 0x80; p++, shift += 7) value |= (uint64_t)(*p & 0x7F) << shift;
+  value |= (uint64_t)*p << shift;
+  *in = p + 1;
+  return value;
+}
+
+/* - BLOCKS - */
+
+/* Grows `vec` so that `bytes` more bytes and one more block fit. */
+static bool reserve_block(compressed_vector_t *const vec, const size_t bytes) {
+  const allocator_t *const ALLOCATOR = vec->allocator;
+  if (vec->data_size + bytes > vec->data_capacity) {
+    size_t capacity = (vec->data_capacity != 0)
+                          ? vec->data_capacity * EXPANSION_FACTOR
+                          : BASE_DATA_CAPACITY;
+    while (capacity < vec->data_size + bytes) capacity *= EXPANSION_FACTOR;
+    byte_t *const data =
+        (vec->data == NULL)
+            ? ALLOCATOR->alloc(ALLOCATOR->ctx, capacity, DEFAULT_ALIGNMENT)
+            : ALLOCATOR->realloc(ALLOCATOR->ctx, vec->data,
+                                 vec->data_capacity, capacity,
+                                 DEFAULT_ALIGNMENT);
+    if (data == NULL) return false;
+    vec->data = data;
+    vec->data_capacity = capacity;
+  }
+  if (vec->num_blocks == vec->blocks_capacity) {
+    const size_t CAPACITY = (vec->blocks_capacity != 0)
+                                ? vec->blocks_capacity * EXPANSION_FACTOR
+                                : BASE_BLOCKS_CAPACITY;
+    const size_t OLD_SIZE = vec->blocks_capacity * sizeof(compressed_block);
+    const size_t NEW_SIZE = CAPACITY * sizeof(compressed_block);
+    compressed_block *const blocks =
+        (vec->blocks == NULL)
+            ? ALLOCATOR->alloc(ALLOCATOR->ctx, NEW_SIZE, DEFAULT_ALIGNMENT)
+            : ALLOCATOR->realloc(ALLOCATOR->ctx, vec->blocks, OLD_SIZE,
+                                 NEW_SIZE, DEFAULT_ALIGNMENT);
+    if (blocks == NULL) return false;
+    vec->blocks = blocks;
+    vec->blocks_capacity = CAPACITY;
+  }
+  return true;
+}
+
+/* Encodes the full tail of `vec` as a new block and empties the tail. */
+static bool store_tail(compressed_vector_t *const vec) {
+  const bool VARINT = vec->encoding == COMPRESSED_VARINT;
+  if (!reserve_block(vec, VARINT ? MAX_VARINT_BLOCK : 16 * 64)) return false;
+
+  uint64_t deltas[COMPRESSED_BLOCK_LEN];
+  uint64_t prev = vec->tail_prev;
+  for (size_t i = 0; i < COMPRESSED_BLOCK_LEN; i++) {
+    deltas[i] = vec->tail[i] - prev;
+    prev = vec->tail[i];
+  }
+  compressed_block *const block = &vec->blocks[vec->num_blocks];
+  byte_t *const out = vec->data + vec->data_size;
+  block->prev = vec->tail_prev;
+  block->offset = vec->data_size;
+  if (VARINT) {
+    size_t size = 0;
+    for (size_t i = 0; i < COMPRESSED_BLOCK_LEN; i++)
+      size += put_varint(zigzag(deltas[i]), out + size);
+    block->base = 0;
+    block->bits = 0;
+    vec->data_size += size;
+  } else {
+    /* Subtracting the least difference, in signed order, leaves offsets. */
+    uint64_t least = deltas[0] ^ SIGN_BIT;
+    for (size_t i = 1; i < COMPRESSED_BLOCK_LEN; i++)
+      if ((deltas[i] ^ SIGN_BIT) < least) least = deltas[i] ^ SIGN_BIT;
+    block->base = least ^ SIGN_BIT;
+    uint64_t all_bits = 0;
+    for (size_t i = 0; i < COMPRESSED_BLOCK_LEN; i++) {
+      deltas[i] -= block->base;
+      all_bits |= deltas[i];
+    }
+    block->bits = bit_width(all_bits);
+    if (block->bits > LANE_BITS)
+      pack_wide(deltas, block->bits, out);
+    else if (block->bits != 0)
+      pack_lanes(deltas, block->bits, out);
+    vec->data_size += 16 * (size_t)block->bits;
+  }
+  vec->num_blocks++;
+  vec->tail_prev = vec->tail[COMPRESSED_BLOCK_LEN - 1];
+  vec->tail_length = 0;
+  return true;
+}
+
+/* Decodes block `index` of `vec` into `out`. */
+static void decode_block(const compressed_vector_t *const vec,
+                         const size_t index, uint64_t *const out) {
+  const compressed_block *const block = &vec->blocks[index];
+  const byte_t *packed = vec->data + block->offset;
+  const unsigned BITS = block->bits;
+  /* Local copies, since stores to `out` could otherwise alias `block`. */
+  const uint64_t BASE = block->base;
+  uint64_t value = block->prev;
+  if (vec->encoding == COMPRESSED_VARINT) {
+    for (size_t i = 0; i < COMPRESSED_BLOCK_LEN; i++) {
+      value += unzigzag(get_varint(&packed));
+      out[i] = value;
+    }
+    return;
+  }
+  if (BITS > LANE_BITS) {
+    unpack_wide(packed, BITS, out);
+    for (size_t i = 0; i < COMPRESSED_BLOCK_LEN; i++) {
+      value += BASE + out[i];
+      out[i] = value;
+    }
+    return;
+  }
+  if (BITS == 0) {
+    for (size_t i = 0; i < COMPRESSED_BLOCK_LEN; i++) out[i] = value += BASE;
+    return;
+  }
+  DECODE_LANES[get_simd_level()](packed, BITS, BASE, value, out);
+}
+
+/* - PUBLIC INTERFACE - */
+
+compressed_vector_t *new_compressed_vector(
+    const compressed_encoding encoding) {
+  return new_compressed_vector_with(encoding, NULL);
+}
+
+compressed_vector_t *new_compressed_vector_with(
+    const compressed_encoding encoding, const allocator_t *const allocator) {
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  compressed_vector_t *const vec = ALLOCATOR->alloc(
+      ALLOCATOR->ctx, sizeof(compressed_vector_t), DEFAULT_ALIGNMENT);
+  if (vec == NULL) return NULL;
+  vec->data = NULL;
+  vec->data_size = vec->data_capacity = 0;
+  vec->blocks = NULL;
+  vec->num_blocks = vec->blocks_capacity = 0;
+  vec->length = 0;
+  vec->encoding = encoding;
+  vec->tail_prev = 0;
+  vec->tail_length = 0;
+  vec->allocator = ALLOCATOR;
+  return vec;
+}
+
+compressed_vector_t *compressed_vector_from_vector(
+    const vector_t *const src, const compressed_encoding encoding,
+    const allocator_t *const allocator) {
+  if (src->elem_size != sizeof(uint64_t)) return NULL;
+  compressed_vector_t *vec = new_compressed_vector_with(encoding, allocator);
+  if (vec == NULL) return NULL;
+  if (compressed_vector_append(vec, src->data, src->length) != src->length)
+    delete_compressed_vector(vec);
+  return vec;
+}
+
+void _delete_compressed_vector(compressed_vector_t **const vec) {
+  const allocator_t *const ALLOCATOR = (*vec)->allocator;
+  ALLOCATOR->free(ALLOCATOR->ctx, (*vec)->data, (*vec)->data_capacity,
+                  DEFAULT_ALIGNMENT);
+  ALLOCATOR->free(ALLOCATOR->ctx, (*vec)->blocks,
+                  (*vec)->blocks_capacity * sizeof(compressed_block),
+                  DEFAULT_ALIGNMENT);
+  ALLOCATOR->free(ALLOCATOR->ctx, *vec, sizeof(compressed_vector_t),
+                  DEFAULT_ALIGNMENT);
+  *vec = NULL;
+}
+
+bool compressed_vector_push(compressed_vector_t *const vec,
+                            const uint64_t value) {
+  return compressed_vector_append(vec, &value, 1) == 1;
+}
+
+size_t compressed_vector_append(compressed_vector_t *const vec,
+                                const uint64_t *const values,
+                                const size_t count) {
+  size_t appended = 0;
+  while (appended < count) {
+    const size_t ROOM = COMPRESSED_BLOCK_LEN - vec->tail_length;
+    const size_t TAKEN = (count - appended < ROOM) ? count - appended : ROOM;
+    memcpy(vec->tail + vec->tail_length, values + appended,
+           TAKEN * sizeof(uint64_t));
+    vec->tail_length += TAKEN;
+    if (vec->tail_length == COMPRESSED_BLOCK_LEN && !store_tail(vec)) {
+      /* Keep all but the value which would have completed the block. */
+      vec->tail_length--;
+      appended += TAKEN - 1;
+      break;
+    }
+    appended += TAKEN;
+  }
+  vec->length += appended;
+  return appended;
+}
+
+uint64_t compressed_vector_get(const compressed_vector_t *const vec,
+                               const size_t index) {
+  const size_t BLOCK = index / COMPRESSED_BLOCK_LEN;
+  if (BLOCK == vec->num_blocks)
+    return vec->tail[index % COMPRESSED_BLOCK_LEN];
+  uint64_t values[COMPRESSED_BLOCK_LEN];
+  decode_block(vec, BLOCK, values);
+  return values[index % COMPRESSED_BLOCK_LEN];
+}
+
+size_t compressed_vector_decode(const compressed_vector_t *const vec,
+                                const size_t first, const size_t count,
+                                uint64_t *const out) {
+  if (first >= vec->length) return 0;
+  const size_t TOTAL =
+      (count < vec->length - first) ? count : vec->length - first;
+  size_t done = 0;
+  while (done < TOTAL) {
+    const size_t POS = first + done;
+    const size_t BLOCK = POS / COMPRESSED_BLOCK_LEN;
+    const size_t START = POS % COMPRESSED_BLOCK_LEN;
+    const size_t LEFT = TOTAL - done;
+    size_t taken = COMPRESSED_BLOCK_LEN - START;
+    if (taken > LEFT) taken = LEFT;
+    if (BLOCK == vec->num_blocks) {
+      memcpy(out + done, vec->tail + START, taken * sizeof(uint64_t));
+    } else if (taken == COMPRESSED_BLOCK_LEN) {
+      decode_block(vec, BLOCK, out + done);
+    } else {
+      uint64_t values[COMPRESSED_BLOCK_LEN];
+      decode_block(vec, BLOCK, values);
+      memcpy(out + done, values + START, taken * sizeof(uint64_t));
+    }
+    done += taken;
+  }
+  return TOTAL;
+}
+
+size_t compressed_vector_memory(const compressed_vector_t *const vec) {
+  return sizeof(compressed_vector_t) + vec->data_capacity +
+         vec->blocks_capacity * sizeof(compressed_block);
+}
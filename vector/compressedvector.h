@@ -0,0 +1,129 @@
+#ifndef COMPRESSEDVECTOR_H
+#define COMPRESSEDVECTOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../allocator/allocator.h"
+#include "vector.h"
+
+/* The number of values encoded together, sharing one entry of the index. */
+#define COMPRESSED_BLOCK_LEN ((size_t)128)
+
+#define delete_compressed_vector(vec) _delete_compressed_vector(&(vec))
+
+/* How each block stores the differences between consecutive values. */
+typedef enum compressed_encoding {
+  /*
+   * Frame of reference: the least difference of the block is stored once,
+   * and every difference is packed as its excess over it in the fewest bits
+   * that hold the largest excess. Decoding unpacks four values per vector
+   * instruction.
+   */
+  COMPRESSED_BITPACK,
+  /*
+   * Each difference is zigzag-encoded and stored in as few bytes as it
+   * needs, seven bits per byte. Smaller for skewed differences, but decoded
+   * one byte at a time.
+   */
+  COMPRESSED_VARINT
+} compressed_encoding;
+
+/* Where one block of a `compressed_vector_t` is and how to read it. */
+typedef struct compressed_block {
+  uint64_t prev;  /* The value before the block's first, or zero. */
+  uint64_t base;  /* The least difference, for `COMPRESSED_BITPACK`. */
+  size_t offset;  /* Where the block's bytes start within `data`. */
+  uint32_t bits;  /* Bits per packed difference, for `COMPRESSED_BITPACK`. */
+} compressed_block;
+
+/*
+ * An append-only sequence of `uint64_t` values held as the differences
+ * between consecutive values, compressed in blocks of `COMPRESSED_BLOCK_LEN`.
+ * Sorted identifiers whose gaps fit in 16 bits take about 2.25 bytes each
+ * instead of 8.
+ *
+ * The index holds one entry per block, so any value is found by decoding a
+ * single block. The values after the last whole block wait uncompressed in
+ * `tail` until there are enough to fill one.
+ */
+typedef struct compressed_vector_t {
+  unsigned char *data;
+  size_t data_size;
+  size_t data_capacity;
+  compressed_block *blocks;
+  size_t num_blocks;
+  size_t blocks_capacity;
+  size_t length;
+  compressed_encoding encoding;
+  uint64_t tail_prev; /* The value before `tail[0]`, or zero. */
+  size_t tail_length;
+  uint64_t tail[COMPRESSED_BLOCK_LEN];
+  const allocator_t *allocator;
+} compressed_vector_t;
+
+/*
+ * Creates an empty compressed vector whose blocks use `encoding`.
+ *
+ * \return A pointer to the new vector or `NULL` upon failure.
+ */
+compressed_vector_t *new_compressed_vector(compressed_encoding encoding);
+
+/*
+ * Same as `new_compressed_vector()`, except the vector's memory is obtained
+ * from and returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+compressed_vector_t *new_compressed_vector_with(compressed_encoding encoding,
+                                                const allocator_t *allocator);
+
+/*
+ * Creates a compressed vector as by `new_compressed_vector_with()` holding
+ * the elements of `src`, which must be 8-byte integers.
+ *
+ * \return A pointer to the new vector or `NULL` upon failure or if the
+ * elements of `src` are not 8 bytes.
+ */
+compressed_vector_t *compressed_vector_from_vector(
+    const vector_t *src, compressed_encoding encoding,
+    const allocator_t *allocator);
+
+/* Frees the memory used by `vec` and invalidates the passed pointer. */
+void _delete_compressed_vector(compressed_vector_t **vec);
+
+/*
+ * Appends `value` to `vec`.
+ *
+ * \return `true` upon success or `false` if a block could not be stored, in
+ * which case `vec` is unmodified.
+ */
+bool compressed_vector_push(compressed_vector_t *vec, uint64_t value);
+
+/*
+ * Appends the `count` elements of `values` to `vec`.
+ *
+ * \return The number of elements appended, which is less than `count` only
+ * upon failure.
+ */
+size_t compressed_vector_append(compressed_vector_t *vec,
+                                const uint64_t *values, size_t count);
+
+/* Returns the element of `vec` at `index`, which must be in bounds. */
+uint64_t compressed_vector_get(const compressed_vector_t *vec, size_t index);
+
+/*
+ * Decodes up to `count` elements of `vec` starting at `first` into `out`.
+ *
+ * \return The number of elements decoded, fewer than `count` if `vec` ends
+ * first.
+ */
+size_t compressed_vector_decode(const compressed_vector_t *vec, size_t first,
+                                size_t count, uint64_t *out);
+
+/*
+ * Returns the number of bytes `vec` occupies, counting its header, index,
+ * and the reserved space of each.
+ */
+size_t compressed_vector_memory(const compressed_vector_t *vec);
+
+#endif
@@ -0,0 +1,179 @@
+#include "concurrentvector.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../hugealloc/hugealloc.h"
+#include "vector.h"
+
+typedef unsigned char byte_t;
+
+static size_t segment_elems(const size_t segment) {
+  return CVECTOR_BASE_SEGMENT_ELEMS << segment;
+}
+
+/* Returns the index of the highest set bit of `x`, which must not be zero. */
+static size_t log2_floor(const size_t x) {
+#if defined(__GNUC__)
+  return sizeof(unsigned long long) * 8 - 1 - (size_t)__builtin_clzll(x);
+#else
+  size_t bit = 0;
+  while ((x >> (bit + 1)) != 0) bit++;
+  return bit;
+#endif
+}
+
+/* Finds the segment holding element `index` and the element's offset in it. */
+static size_t locate_elem(const size_t index, size_t *const offset) {
+  const size_t SEGMENT = log2_floor(index / CVECTOR_BASE_SEGMENT_ELEMS + 1);
+  *offset = index - CVECTOR_BASE_SEGMENT_ELEMS * (((size_t)1 << SEGMENT) - 1);
+  return SEGMENT;
+}
+
+/*
+ * Allocates segment `segment` unless another thread already has. Segments are
+ * published with a compare-and-swap, so the loser of a race frees its copy.
+ */
+static bool ensure_segment(concurrent_vector_t *const cv,
+                           const size_t segment) {
+  if (segment >= CVECTOR_MAX_SEGMENTS) return false;
+  if (atomic_load_explicit(&cv->segments[segment], memory_order_acquire) !=
+      NULL)
+    return true;
+  byte_t *const mem = huge_alloc(segment_elems(segment) * cv->elem_size);
+  if (mem == NULL) return false;
+  byte_t *expected = NULL;
+  if (!atomic_compare_exchange_strong_explicit(
+          &cv->segments[segment], &expected, mem, memory_order_acq_rel,
+          memory_order_acquire))
+    huge_free(mem);
+  return true;
+}
+
+concurrent_vector_t *new_concurrent_vector(const size_t elem_size) {
+  concurrent_vector_t *const cv = malloc(sizeof(concurrent_vector_t));
+  if (cv == NULL) return NULL;
+  atomic_init(&cv->length, 0);
+  cv->elem_size = elem_size;
+  for (size_t i = 0; i < CVECTOR_MAX_SEGMENTS; i++)
+    atomic_init(&cv->segments[i], NULL);
+  return cv;
+}
+
+void _delete_concurrent_vector(concurrent_vector_t **const cv) {
+  for (size_t i = 0; i < CVECTOR_MAX_SEGMENTS; i++)
+    huge_free(atomic_load_explicit(&(*cv)->segments[i], memory_order_relaxed));
+  free(*cv);
+  *cv = NULL;
+}
+
+void *cvector_get(const concurrent_vector_t *const cv, const size_t index) {
+  size_t offset;
+  const size_t SEGMENT = locate_elem(index, &offset);
+  byte_t *const mem = atomic_load_explicit(
+      (_Atomic(byte_t *) *)&cv->segments[SEGMENT], memory_order_acquire);
+  return mem + offset * cv->elem_size;
+}
+
+size_t cvector_append_n(concurrent_vector_t *const cv, const void *const elems,
+                        const size_t num_elems) {
+  const size_t FIRST =
+      atomic_fetch_add_explicit(&cv->length, num_elems, memory_order_relaxed);
+  if (num_elems == 0) return FIRST;
+  if (FIRST + num_elems < FIRST) return SIZE_MAX;
+  size_t offset;
+  const size_t FIRST_SEGMENT = locate_elem(FIRST, &offset);
+  const size_t LAST_SEGMENT = locate_elem(FIRST + num_elems - 1, &offset);
+  for (size_t s = FIRST_SEGMENT; s <= LAST_SEGMENT; s++)
+    if (!ensure_segment(cv, s)) return SIZE_MAX;
+
+  /* Copy one segment's worth of the reserved range at a time. */
+  const byte_t *src = elems;
+  size_t index = FIRST;
+  size_t remaining = num_elems;
+  while (remaining != 0) {
+    const size_t SEGMENT = locate_elem(index, &offset);
+    const size_t ROOM = segment_elems(SEGMENT) - offset;
+    const size_t COUNT = (ROOM < remaining) ? ROOM : remaining;
+    memcpy(cvector_get(cv, index), src, COUNT * cv->elem_size);
+    src += COUNT * cv->elem_size;
+    index += COUNT;
+    remaining -= COUNT;
+  }
+  return FIRST;
+}
+
+void *cvector_append(concurrent_vector_t *const cv, const void *const elem) {
+  const size_t INDEX = cvector_append_n(cv, elem, 1);
+  if (INDEX == SIZE_MAX) return NULL;
+  return cvector_get(cv, INDEX);
+}
+
+size_t cvector_length(const concurrent_vector_t *const cv) {
+  return atomic_load_explicit((atomic_size_t *)&cv->length,
+                              memory_order_relaxed);
+}
+
+vector_t *cvector_to_vector(const concurrent_vector_t *const cv) {
+  const size_t LENGTH = cvector_length(cv);
+  const size_t ELEM_SIZE = cv->elem_size;
+  vector_t *vec = _new_vector(NULL, ELEM_SIZE, LENGTH);
+  if (vec == NULL) return NULL;
+  size_t copied = 0;
+  for (size_t s = 0; copied < LENGTH; s++) {
+    const byte_t *const mem = atomic_load_explicit(
+        (_Atomic(byte_t *) *)&cv->segments[s], memory_order_acquire);
+    /* A segment is only missing if an append ran out of memory. */
+    if (mem == NULL) {
+      delete_vector(vec);
+      return NULL;
+    }
+    const size_t ROOM = segment_elems(s);
+    const size_t COUNT = (ROOM < LENGTH - copied) ? ROOM : LENGTH - copied;
+    memcpy((byte_t *)vec->data + copied * ELEM_SIZE, mem, COUNT * ELEM_SIZE);
+    copied += COUNT;
+  }
+  return vec;
+}
+
+/* - BUFFERED APPENDING - */
+
+bool cvector_appender_init(cvector_appender *const app,
+                           concurrent_vector_t *const cv, size_t num_elems) {
+  if (num_elems == 0) num_elems = CVECTOR_APPENDER_DEFAULT_ELEMS;
+  app->buffer = malloc(num_elems * cv->elem_size);
+  if (app->buffer == NULL) return false;
+  app->target = cv;
+  app->length = 0;
+  app->capacity = num_elems;
+  return true;
+}
+
+bool cvector_appender_flush(cvector_appender *const app) {
+  if (app->length == 0) return true;
+  const size_t INDEX = cvector_append_n(app->target, app->buffer, app->length);
+  app->length = 0;
+  return INDEX != SIZE_MAX;
+}
+
+bool cvector_appender_push(cvector_appender *const app,
+                           const void *const elem) {
+  if (app->length == app->capacity && !cvector_appender_flush(app))
+    return false;
+  const size_t ELEM_SIZE = app->target->elem_size;
+  memcpy((byte_t *)app->buffer + app->length * ELEM_SIZE, elem, ELEM_SIZE);
+  app->length++;
+  return true;
+}
+
+bool cvector_appender_release(cvector_appender *const app) {
+  const bool FLUSHED = cvector_appender_flush(app);
+  free(app->buffer);
+  app->buffer = NULL;
+  app->capacity = 0;
+  return FLUSHED;
+}
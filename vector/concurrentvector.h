@@ -0,0 +1,137 @@
+#ifndef CONCURRENTVECTOR_H
+#define CONCURRENTVECTOR_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "vector.h"
+
+/* The number of elements within the first segment. Each further doubles. */
+#define CVECTOR_BASE_SEGMENT_ELEMS ((size_t)64)
+
+/* Enough segments to address any index a 64-bit `size_t` can reserve. */
+#define CVECTOR_MAX_SEGMENTS (58)
+
+/* The number of elements an appender buffers by default. */
+#define CVECTOR_APPENDER_DEFAULT_ELEMS ((size_t)256)
+
+#define delete_concurrent_vector(cv) _delete_concurrent_vector(&(cv))
+
+/*
+ * A growable array which any number of threads may append to concurrently
+ * without locking.
+ *
+ * Appending threads reserve indices with a single atomic fetch-and-add on
+ * `length` and then copy their elements in. Storage is split into segments
+ * which double in size, so growing never moves existing elements and a
+ * reserved slot stays valid for the lifetime of the vector. A missing segment
+ * is allocated by whichever thread first needs it and published with a
+ * compare-and-swap.
+ *
+ * \note `length` counts reserved slots, some of which may still be being
+ * written. Elements should only be read once the appending threads have been
+ * synchronized with, such as by joining them or by `thread_pool_wait()`.
+ */
+typedef struct concurrent_vector_t {
+  atomic_size_t length;
+  size_t elem_size;
+  _Atomic(unsigned char *) segments[CVECTOR_MAX_SEGMENTS];
+} concurrent_vector_t;
+
+/*
+ * Buffers elements appended by a single thread and moves them into `target`
+ * in batches, so the shared counter is only touched once per batch.
+ */
+typedef struct cvector_appender {
+  concurrent_vector_t *target;
+  void *buffer;
+  size_t length;   /* The number of buffered elements. */
+  size_t capacity; /* The number of elements `buffer` can hold. */
+} cvector_appender;
+
+/*
+ * Creates an empty concurrent vector of `elem_size`-byte elements.
+ *
+ * \return A pointer to the new vector or `NULL` upon failure.
+ */
+concurrent_vector_t *new_concurrent_vector(size_t elem_size);
+
+/*
+ * Frees the memory used by `cv` and invalidates the passed pointer. No other
+ * thread may be using `cv` any longer.
+ */
+void _delete_concurrent_vector(concurrent_vector_t **cv);
+
+/*
+ * Copies `elem` into a newly reserved slot at the end of `cv`.
+ *
+ * \return A pointer to the stored element or `NULL` if a segment could not be
+ * allocated.
+ */
+void *cvector_append(concurrent_vector_t *cv, const void *elem);
+
+/*
+ * Copies the `num_elems` elements of `elems` into consecutive slots at the end
+ * of `cv`, reserving them all with a single atomic update.
+ *
+ * \return The index of the first element or `SIZE_MAX` if a segment could not
+ * be allocated.
+ * \note After a failure, the reserved slots are left unwritten and `cv` should
+ * be considered out of memory.
+ */
+size_t cvector_append_n(concurrent_vector_t *cv, const void *elems,
+                        size_t num_elems);
+
+/*
+ * Returns a pointer to the element at `index`, which must be less than the
+ * length of `cv`. The pointer remains valid until `cv` is deleted.
+ */
+void *cvector_get(const concurrent_vector_t *cv, size_t index);
+
+/*
+ * Returns the number of slots reserved within `cv`. The value may already be
+ * stale when other threads are appending.
+ */
+size_t cvector_length(const concurrent_vector_t *cv);
+
+/*
+ * Copies the contents of `cv` into a new `vector_t`. No thread may be
+ * appending to `cv` during the copy.
+ *
+ * \return A pointer to the new vector or `NULL` upon failure.
+ */
+vector_t *cvector_to_vector(const concurrent_vector_t *cv);
+
+/*
+ * Prepares `app` to append to `cv` in batches of `num_elems` elements, or of
+ * `CVECTOR_APPENDER_DEFAULT_ELEMS` if `num_elems` is zero. Each appender must
+ * only be used by one thread.
+ *
+ * \return `true` upon success or `false` if the buffer could not be allocated.
+ */
+bool cvector_appender_init(cvector_appender *app, concurrent_vector_t *cv,
+                           size_t num_elems);
+
+/*
+ * Buffers a copy of `elem`, flushing the buffer first if it is full.
+ *
+ * \return `true` upon success or `false` if flushing failed.
+ */
+bool cvector_appender_push(cvector_appender *app, const void *elem);
+
+/*
+ * Moves every buffered element into the target vector.
+ *
+ * \return `true` upon success or `false` if a segment could not be allocated.
+ */
+bool cvector_appender_flush(cvector_appender *app);
+
+/*
+ * Flushes `app` and frees its buffer.
+ *
+ * \return The result of the final flush.
+ */
+bool cvector_appender_release(cvector_appender *app);
+
+#endif
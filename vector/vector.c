@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../allocator/allocator.h"
+
 vector_t *add_elem(vector_t *dest, void *elem) {
   if (dest->length == dest->capacity) {
     dest = expand_vector(dest);
@@ -15,34 +17,69 @@ vector_t *add_elem(vector_t *dest, void *elem) {
   return dest;
 }
 
+/* The data follows the header, padded to the vector's alignment. */
+static size_t data_offset(const size_t alignment) {
+  return (sizeof(vector_t) + alignment - 1) / alignment * alignment;
+}
+
 inline void _delete_vector(vector_t **const vec) {
-  free(*vec);
+  const allocator_t *const ALLOCATOR = (*vec)->allocator;
+  const size_t ALIGNMENT = (*vec)->alignment;
+  ALLOCATOR->free(ALLOCATOR->ctx, *vec,
+                  data_offset(ALIGNMENT) + (*vec)->capacity, ALIGNMENT);
   *vec = NULL;
 }
 
 inline void delete_vector_s(vector_t *vec) {
-  memset(vec, 0, vec->capacity);
-  delete_vector(vec);
+  /* The header is about to be zeroed, so keep what freeing it requires. */
+  const allocator_t *const ALLOCATOR = vec->allocator;
+  const size_t ALIGNMENT = vec->alignment;
+  const size_t SIZE = data_offset(ALIGNMENT) + vec->capacity;
+  memset(vec, 0, SIZE);
+  ALLOCATOR->free(ALLOCATOR->ctx, vec, SIZE, ALIGNMENT);
 }
 
 vector_t *resize_vector(vector_t *const vec, const size_t new_size) {
-  vector_t *new_vec = realloc(vec, new_size + sizeof(vector_t));
+  const allocator_t *const ALLOCATOR = vec->allocator;
+  const size_t OFFSET = data_offset(vec->alignment);
+  vector_t *new_vec =
+      ALLOCATOR->realloc(ALLOCATOR->ctx, vec, OFFSET + vec->capacity,
+                         OFFSET + new_size, vec->alignment);
   if (new_vec == NULL) return NULL;
   new_vec->capacity = new_size;
   new_vec->length = (new_size < new_vec->length) ? new_size : new_vec->length;
-  new_vec->data = (char *)new_vec + sizeof(vector_t);
+  new_vec->data = (char *)new_vec + OFFSET;
   return new_vec;
 }
 
 vector_t *_new_vector(const void *const data, const size_t elem_size,
                       const size_t length) {
+  return _new_vector_with(data, elem_size, length, NULL);
+}
+
+vector_t *_new_vector_with(const void *const data, const size_t elem_size,
+                           const size_t length,
+                           const allocator_t *const allocator) {
+  return _new_vector_aligned(data, elem_size, length, DEFAULT_ALIGNMENT,
+                             allocator);
+}
+
+vector_t *_new_vector_aligned(const void *const data, const size_t elem_size,
+                              const size_t length, size_t alignment,
+                              const allocator_t *const allocator) {
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) return NULL;
+  if (alignment < DEFAULT_ALIGNMENT) alignment = DEFAULT_ALIGNMENT;
   const size_t CAPACITY = length * elem_size;
-  vector_t *vec = malloc(CAPACITY + sizeof(vector_t));
+  const allocator_t *const ALLOCATOR = allocator_or_default(allocator);
+  vector_t *vec = ALLOCATOR->alloc(
+      ALLOCATOR->ctx, data_offset(alignment) + CAPACITY, alignment);
   if (vec == NULL) return NULL;
-  vec->data = (char *)vec + sizeof(vector_t);
+  vec->allocator = ALLOCATOR;
+  vec->alignment = alignment;
+  vec->data = (char *)vec + data_offset(alignment);
   vec->elem_size = elem_size;
   vec->length = length;
   vec->capacity = CAPACITY;
-  memcpy(vec->data, data, CAPACITY);
+  if (data != NULL) memcpy(vec->data, data, CAPACITY);
   return vec;
 }
@@ -3,11 +3,15 @@
 
 #include <stddef.h>
 
+#include "../allocator/allocator.h"
+
 #define REALLOC_FACTOR (2)
 
 /* clang-format off */
 #define new_vector(data, length) _new_vector(data, sizeof*(data), length)
 #define new_vector_from_c_arr(arr) _new_vector(arr, sizeof*(arr), sizeof(arr) / sizeof*(arr))
+#define new_vector_with(data, length, allocator) _new_vector_with(data, sizeof*(data), length, allocator)
+#define new_vector_aligned(data, length, alignment) _new_vector_aligned(data, sizeof*(data), length, alignment, NULL)
 #define delete_vector(vec) _delete_vector(&(vec))
 #define expand_vector(vec) resize_vector(vec, (vec)->capacity * REALLOC_FACTOR)
 /* clang-format on */
@@ -17,6 +21,8 @@ typedef struct vector_t {
   size_t length;
   size_t elem_size;
   size_t capacity;
+  const allocator_t *allocator;
+  size_t alignment; /* The alignment of `data`. */
 } vector_t;
 
 void _delete_vector(vector_t **v);
@@ -28,4 +34,24 @@ vector_t *resize_vector(vector_t *vec, size_t new_size);
 size_t print_vector(const vector_t *vec);
 
 vector_t *_new_vector(const void *data, size_t elem_size, size_t num_elems);
+
+/*
+ * Same as `_new_vector()`, except the vector's memory is obtained from and
+ * returned to `allocator`, or the default allocator if it is `NULL`.
+ */
+vector_t *_new_vector_with(const void *data, size_t elem_size,
+                           size_t num_elems, const allocator_t *allocator);
+
+/*
+ * Same as `_new_vector_with()`, except `data` is aligned to `alignment`, a
+ * power of two, and stays aligned across resizes. Alignments below
+ * `DEFAULT_ALIGNMENT` are raised to it. If `data` is `NULL`, the elements are
+ * left uninitialized.
+ *
+ * \return A pointer to the new vector or `NULL` upon failure or if
+ * `alignment` is not a power of two.
+ */
+vector_t *_new_vector_aligned(const void *data, size_t elem_size,
+                              size_t num_elems, size_t alignment,
+                              const allocator_t *allocator);
 #endif